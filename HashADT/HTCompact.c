@@ -0,0 +1,544 @@
+//
+// File name: HTCompact.c
+//
+// Description:
+// The HT_LAYOUT_COMPACT storage of HashADT, an insertion ordered table:
+// the pairs are appended to a dense array of entries, and linear probing
+// runs over an index of slots, each 0 or one more than the position of
+// an entry.  Slots are 1, 2 or 4 bytes, the fewest that can name every
+// entry the index may hold, so an empty bucket of a table under 192 keys
+// costs a byte instead of a 16 byte pair.  The entry array grows by half
+// again whenever it fills, apart from the index.  Removing a key leaves
+// a gap in the entries; rebuilding the index, to grow or to drop the
+// gaps, squeezes them out in one sequential pass without reordering.
+// Walking the pairs reads the entries front to back, in insertion order.
+//
+// @author Nick Creeley - nc8004
+//
+// version control:
+// git hw6 repository
+//
+// // // // // // // // // // // // // // // // // // // // // // // // // // // // // //
+
+//include standard libraries
+
+#include <stdbool.h>
+
+#include <stddef.h>
+
+#include <stdlib.h>
+
+#include <assert.h>
+
+#include <string.h>
+
+#include <stdint.h>
+
+//include header files
+
+#include "HashADT.h"
+
+#include "HTLayout.h"
+
+//slot of the index that points at no entry
+
+#define EMPTY 0
+
+/// A stored pair; a removed pair keeps its place with a NULL key until
+/// the next rebuild
+
+typedef struct CompactEntry {
+
+    void *key;
+
+    void *value;
+
+} CompactEntry;
+
+/// The index and the entries; entries[0 .. used) are the pairs in the
+/// order they were added, count of them live, and every live one has
+/// exactly one slot holding its position plus one
+
+typedef struct CompactTable {
+
+    void *slots;
+
+    size_t capacity;
+
+    //bytes per slot: 1, 2 or 4
+
+    size_t width;
+
+    CompactEntry *entries;
+
+    size_t entry_capacity;
+
+    size_t used;
+
+    size_t count;
+
+} CompactTable;
+
+/// compact_limit(): entries an index of capacity slots can take, at the
+/// load threshold
+
+static size_t compact_limit( size_t capacity ) {
+
+    return (size_t) (capacity * LOAD_THRESHOLD);
+}
+
+/// compact_slot(): the entry position plus one held by slot i, or EMPTY
+
+static size_t compact_slot( const CompactTable *c, size_t i ) {
+
+    switch(c -> width) {
+
+        case 1:
+            return ((const uint8_t *) c -> slots)[i];
+
+        case 2:
+            return ((const uint16_t *) c -> slots)[i];
+
+        default:
+            return ((const uint32_t *) c -> slots)[i];
+    }
+}
+
+/// compact_set_slot(): store an entry position plus one, or EMPTY
+
+static void compact_set_slot( CompactTable *c, size_t i, size_t slot ) {
+
+    switch(c -> width) {
+
+        case 1:
+            ((uint8_t *) c -> slots)[i] = (uint8_t) slot;
+            break;
+
+        case 2:
+            ((uint16_t *) c -> slots)[i] = (uint16_t) slot;
+            break;
+
+        default:
+            ((uint32_t *) c -> slots)[i] = (uint32_t) slot;
+            break;
+    }
+}
+
+/// compact_alloc(): make an empty index of capacity slots, each as wide
+/// as its largest entry position plus one needs
+
+static void compact_alloc( const HashADT t, CompactTable *c, size_t capacity ) {
+
+    size_t limit = compact_limit(capacity);
+
+    //positions past 32 bits would need 8 byte slots, no smaller than a
+    //flat table's pair
+
+    assert(limit < UINT32_MAX);
+
+    c -> width = limit <= UINT8_MAX ? 1 : limit <= UINT16_MAX ? 2 : 4;
+
+    c -> slots = ht_layout_alloc(t, capacity * c -> width);
+
+    assert(c -> slots != NULL);
+
+    memset(c -> slots, 0, capacity * c -> width);
+
+    c -> capacity = capacity;
+}
+
+/// compact_reserve(): make room for one more entry, growing the entries
+/// by half again, and never past what the index can take
+
+static void compact_reserve( const HashADT t, CompactTable *c ) {
+
+    if(c -> used < c -> entry_capacity) {
+        return;
+    }
+
+    size_t limit = compact_limit(c -> capacity);
+
+    size_t entry_capacity = c -> entry_capacity + c -> entry_capacity / 2;
+
+    entry_capacity = entry_capacity < limit ? entry_capacity : limit;
+
+    c -> entries = (CompactEntry *) ht_layout_realloc(t, c -> entries,
+        c -> entry_capacity * sizeof(CompactEntry), entry_capacity * sizeof(CompactEntry));
+
+    assert(c -> entries != NULL);
+
+    c -> entry_capacity = entry_capacity;
+}
+
+/// compact_probe(): find key, whose hash is hash
+///
+/// returns true with *slot at the slot naming its entry, or false with
+/// *slot at the first empty slot of its probe, where it would be placed
+
+static bool compact_probe( const HashADT t, const CompactTable *c, uint64_t hash, const void *key, size_t *slot ) {
+
+    size_t mask = c -> capacity - 1;
+
+    size_t home = (size_t) hash & mask;
+
+    size_t i = home;
+
+    size_t entry;
+
+    while((entry = compact_slot(c, i)) != EMPTY) {
+
+        if(ht_layout_equals(t, key, c -> entries[entry - 1].key)) {
+
+            ht_layout_collisions(t, (i - home) & mask);
+
+            *slot = i;
+
+            return true;
+        }
+
+        i = (i + 1) & mask;
+    }
+
+    ht_layout_collisions(t, (i - home) & mask);
+
+    *slot = i;
+
+    return false;
+}
+
+/// compact_index(): point the first empty slot from hash's home at entry
+
+static void compact_index( CompactTable *c, uint64_t hash, size_t entry ) {
+
+    size_t mask = c -> capacity - 1;
+
+    size_t i = (size_t) hash & mask;
+
+    while(compact_slot(c, i) != EMPTY) {
+
+        i = (i + 1) & mask;
+    }
+
+    compact_set_slot(c, i, entry + 1);
+}
+
+/// compact_rebuild(): squeeze the removed pairs out of the entries,
+/// keeping the order of the rest, and index them afresh in capacity
+/// slots; the entries stay in their array
+
+static void compact_rebuild( HashADT t, CompactTable *c, size_t capacity ) {
+
+    uint64_t start = ht_layout_now_ns();
+
+    void *old_slots = c -> slots;
+
+    size_t old_bytes = c -> capacity * c -> width;
+
+    compact_alloc(t, c, capacity);
+
+    size_t live = 0;
+
+    for(size_t e = 0; e < c -> used; e++) {
+
+        if(c -> entries[e].key == NULL) {
+            continue;
+        }
+
+        c -> entries[live] = c -> entries[e];
+
+        compact_index(c, ht_layout_hash(t, c -> entries[live].key), live);
+
+        live++;
+    }
+
+    c -> used = live;
+
+    ht_layout_free(t, old_slots, old_bytes);
+
+    ht_layout_rehashed(t, ht_layout_now_ns() - start);
+}
+
+/// compact_create(): an empty table of INITIAL_CAPACITY slots
+
+static void *compact_create( HashADT t ) {
+
+    CompactTable *c = (CompactTable *) ht_layout_alloc(t, sizeof(CompactTable));
+
+    assert(c != NULL);
+
+    compact_alloc(t, c, INITIAL_CAPACITY);
+
+    c -> entry_capacity = INITIAL_CAPACITY / 2;
+
+    c -> entries = (CompactEntry *) ht_layout_alloc(t, c -> entry_capacity * sizeof(CompactEntry));
+
+    assert(c -> entries != NULL);
+
+    c -> used = 0;
+
+    c -> count = 0;
+
+    return c;
+}
+
+/// compact_destroy(): release the index, the entries and the table
+
+static void compact_destroy( HashADT t, void *state ) {
+
+    CompactTable *c = (CompactTable *) state;
+
+    ht_layout_free(t, c -> slots, c -> capacity * c -> width);
+
+    ht_layout_free(t, c -> entries, c -> entry_capacity * sizeof(CompactEntry));
+
+    ht_layout_free(t, c, sizeof(CompactTable));
+}
+
+/// compact_find(): look up a key
+
+static bool compact_find( const HashADT t, void *state, const void *key, const void **value ) {
+
+    const CompactTable *c = (const CompactTable *) state;
+
+    size_t slot;
+
+    if(!compact_probe(t, c, ht_layout_hash(t, key), key, &slot)) {
+        return false;
+    }
+
+    *value = c -> entries[compact_slot(c, slot) - 1].value;
+
+    return true;
+}
+
+/// compact_insert(): add or update a key; a new key is appended to the
+/// entries, after a rebuild when the index is at the load threshold
+
+static void *compact_insert( HashADT t, void *state, const void *key, const void *value, bool *added ) {
+
+    CompactTable *c = (CompactTable *) state;
+
+    uint64_t hash = ht_layout_hash(t, key);
+
+    size_t slot;
+
+    if(compact_probe(t, c, hash, key, &slot)) {
+
+        CompactEntry *entry = &c -> entries[compact_slot(c, slot) - 1];
+
+        void *old_value = entry -> value;
+
+        entry -> value = (void *) value;
+
+        *added = false;
+
+        return old_value;
+    }
+
+    //positions are never reused, so the index fills with used, not count;
+    //it only doubles if squeezing out removed pairs would leave room for
+    //less than a quarter of its limit, which keeps rebuilds amortized
+
+    if(c -> used + 1 > compact_limit(c -> capacity)) {
+
+        size_t limit = compact_limit(c -> capacity);
+
+        bool crowded = c -> count + 1 > limit - limit / 4;
+
+        compact_rebuild(t, c, crowded ? c -> capacity * RESIZE_FACTOR : c -> capacity);
+
+        compact_index(c, hash, c -> used);
+
+    } else {
+
+        compact_set_slot(c, slot, c -> used + 1);
+    }
+
+    compact_reserve(t, c);
+
+    c -> entries[c -> used].key = (void *) key;
+
+    c -> entries[c -> used].value = (void *) value;
+
+    c -> used++;
+
+    c -> count++;
+
+    *added = true;
+
+    return NULL;
+}
+
+/// compact_remove(): take a key out
+///
+/// the slot is closed by backward shift, as in HTSoA.c; the entry stays
+/// as a gap, so the pairs after it keep their order
+
+static bool compact_remove( HashADT t, void *state, const void *key, void **key_out, void **value_out ) {
+
+    CompactTable *c = (CompactTable *) state;
+
+    size_t mask = c -> capacity - 1;
+
+    size_t hole;
+
+    if(!compact_probe(t, c, ht_layout_hash(t, key), key, &hole)) {
+        return false;
+    }
+
+    CompactEntry *entry = &c -> entries[compact_slot(c, hole) - 1];
+
+    *key_out = entry -> key;
+
+    *value_out = entry -> value;
+
+    size_t slot;
+
+    for(size_t i = (hole + 1) & mask; (slot = compact_slot(c, i)) != EMPTY; i = (i + 1) & mask) {
+
+        size_t home = (size_t) ht_layout_hash(t, c -> entries[slot - 1].key) & mask;
+
+        //the slot stays if its home lies cyclically in (hole, i]
+
+        if(((i - home) & mask) < ((i - hole) & mask)) {
+            continue;
+        }
+
+        compact_set_slot(c, hole, slot);
+
+        hole = i;
+    }
+
+    compact_set_slot(c, hole, EMPTY);
+
+    entry -> key = NULL;
+
+    entry -> value = NULL;
+
+    c -> count--;
+
+    //a gap at the end is simply given back
+
+    while(c -> used > 0 && c -> entries[c -> used - 1].key == NULL) {
+
+        c -> used--;
+    }
+
+    return true;
+}
+
+/// compact_each(): visit every pair in insertion order
+
+static void compact_each( const HashADT t, void *state,
+        void (*visit)( void *context, void *key, void *value ), void *context ) {
+
+    (void) t;
+
+    const CompactTable *c = (const CompactTable *) state;
+
+    for(size_t e = 0; e < c -> used; e++) {
+
+        if(c -> entries[e].key != NULL) {
+
+            visit(context, c -> entries[e].key, c -> entries[e].value);
+        }
+    }
+}
+
+/// compact_stats_bucket(): the log2 histogram bucket a value falls in
+
+static size_t compact_stats_bucket( uint64_t value ) {
+
+    size_t bucket = 0;
+
+    while(value > 0 && bucket < HT_STATS_BUCKETS - 1) {
+
+        value >>= 1;
+
+        bucket++;
+    }
+
+    return bucket;
+}
+
+/// compact_stats(): capacity, probe distances, runs and bytes
+///
+/// like the flat table's, this rehashes every key
+
+static void compact_stats( const HashADT t, void *state, HTStats *stats ) {
+
+    const CompactTable *c = (const CompactTable *) state;
+
+    size_t mask = c -> capacity - 1;
+
+    uint64_t total = 0;
+
+    stats -> capacity = c -> capacity;
+
+    stats -> max_probe = 0;
+
+    stats -> bytes_used = sizeof(CompactTable) + c -> capacity * c -> width
+        + c -> entry_capacity * sizeof(CompactEntry);
+
+    //start after an empty slot so no run wraps
+
+    size_t start = 0;
+
+    while(compact_slot(c, start) != EMPTY) {
+
+        start++;
+    }
+
+    uint64_t run = 0;
+
+    for(size_t n = 1; n <= c -> capacity; n++) {
+
+        size_t i = (start + n) & mask;
+
+        size_t slot = compact_slot(c, i);
+
+        if(slot == EMPTY) {
+
+            if(run > 0) {
+
+                stats -> cluster_histogram[compact_stats_bucket(run)]++;
+            }
+
+            run = 0;
+
+            continue;
+        }
+
+        run++;
+
+        uint64_t distance = (i - (size_t) ht_layout_hash(t, c -> entries[slot - 1].key)) & mask;
+
+        stats -> probe_histogram[compact_stats_bucket(distance)]++;
+
+        total += distance;
+
+        if(distance > stats -> max_probe) {
+
+            stats -> max_probe = distance;
+        }
+    }
+
+    if(run > 0) {
+
+        stats -> cluster_histogram[compact_stats_bucket(run)]++;
+    }
+
+    stats -> mean_probe = stats -> size > 0 ? (double) total / stats -> size : 0.0;
+}
+
+/// The compact layout, see HTLayout.h
+
+const HTLayoutOps ht_layout_compact = {
+    compact_create,
+    compact_destroy,
+    compact_find,
+    compact_insert,
+    compact_remove,
+    compact_each,
+    compact_stats
+};
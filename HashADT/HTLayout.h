@@ -0,0 +1,136 @@
+/// \file HTLayout.h
+/// \brief Internal interface between HashADT and its storage layouts.
+///
+/// HashADT.c stores HT_LAYOUT_FLAT tables itself.  Every other layout is
+/// a table of HTLayoutOps in its own source file; HashADT.c keeps the
+/// client callbacks, seed, trace and counters, and hands storage to the
+/// layout.  Clients never include this file.
+///
+/// @author Nick Creeley - nc8004
+
+#ifndef HTLAYOUT_H
+#define HTLAYOUT_H
+
+#include <stdbool.h>    // bool
+#include <stddef.h>     // size_t
+#include <stdint.h>     // uint64_t
+
+#include "HashADT.h"
+
+///
+/// The storage operations of a layout.  state is whatever create()
+/// returned.  Running out of memory is an assert failure, as in HashADT.c.
+///
+typedef struct HTLayoutOps {
+
+    /// Make empty storage
+    void *(*create)( HashADT t );
+
+    /// Release the storage (not keys or values; HashADT calls the delete
+    /// function through each() first)
+    void (*destroy)( HashADT t, void *state );
+
+    /// Find key; on success set *value to what ht_get() returns
+    bool (*find)( const HashADT t, void *state, const void *key, const void **value );
+
+    /// Add or update key; *added tells which.  Returns what ht_put()
+    /// returns for the layout
+    void *(*insert)( HashADT t, void *state, const void *key, const void *value, bool *added );
+
+    /// Remove key; on success set *key_out and *value_out to what was
+    /// stored
+    bool (*remove)( HashADT t, void *state, const void *key, void **key_out, void **value_out );
+
+    /// Call visit for every stored pair, in the layout's order
+    void (*each)( const HashADT t, void *state,
+        void (*visit)( void *context, void *key, void *value ), void *context );
+
+    /// Fill capacity, max_probe, mean_probe, the histograms and bytes_used
+    /// (the storage only; HashADT adds its own header)
+    void (*stats)( const HashADT t, void *state, HTStats *stats );
+
+} HTLayoutOps;
+
+/// The layouts, one per source file
+extern const HTLayoutOps ht_layout_segmented;
+
+extern const HTLayoutOps ht_layout_soa;
+
+extern const HTLayoutOps ht_layout_compact;
+
+///
+/// The 64 bit hash of key under the table's seed.  Unlike the flat
+/// layout, which uses hash % capacity directly, this is always mixed, so
+/// layouts may take bits from anywhere in it.
+///
+uint64_t ht_layout_hash( const HashADT t, const void *key );
+
+///
+/// The table's equals function.
+///
+bool ht_layout_equals( const HashADT t, const void *key1, const void *key2 );
+
+///
+/// Bytes of each value the table copies in (HTOptions value_size), or 0
+/// when values are pointers.  A layout that copies values returns a
+/// pointer to the copy wherever it would return a value, except from
+/// remove, whose copy is gone, so it gives NULL.
+///
+size_t ht_layout_value_size( const HashADT t );
+
+///
+/// Allocate and free through the table's allocator.  free must be given
+/// the size that was allocated.
+///
+void *ht_layout_alloc( const HashADT t, size_t size );
+
+void ht_layout_free( const HashADT t, void *ptr, size_t size );
+
+///
+/// Resize a block from ht_layout_alloc() of old_size bytes to new_size,
+/// keeping its contents, through the allocator's realloc hook when it has
+/// one.  Returns NULL and leaves the block alone if there is no memory.
+///
+void *ht_layout_realloc( const HashADT t, void *ptr, size_t old_size, size_t new_size );
+
+///
+/// Report that the layout moved pairs to make room, taking ns nanoseconds;
+/// counted as a rehash by ht_stats() and ht_rehash_count().
+///
+void ht_layout_rehashed( HashADT t, uint64_t ns );
+
+///
+/// Count probes stepped over, when the library keeps counters.
+///
+void ht_layout_collisions( const HashADT t, uint64_t probes );
+
+///
+/// Monotonic clock in nanoseconds, for timing rehashes.
+///
+uint64_t ht_layout_now_ns( void );
+
+///
+/// Entry points for the containers built on HashADT (HashSet.c), which
+/// need more than HashADT.h offers.  They work for every layout and for
+/// small tables.
+///
+
+///
+/// The number of keys in the table.
+///
+size_t ht_occupancy( const HashADT t );
+
+///
+/// Remove key from the table, without calling the delete function.
+///
+/// @return false if the key was not there; otherwise true, with *key_out
+///         and *value_out set to the stored key and value
+///
+bool ht_remove( HashADT t, const void *key, void **key_out, void **value_out );
+
+///
+/// Call visit for every pair in the table, in storage order.
+///
+void ht_each( const HashADT t, void (*visit)( void *context, void *key, void *value ), void *context );
+
+#endif // HTLAYOUT_H
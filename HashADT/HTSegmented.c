@@ -0,0 +1,645 @@
+//
+// File name: HTSegmented.c
+//
+// Description:
+// The HT_LAYOUT_SEGMENTED storage of HashADT: extendible hashing over a
+// directory of small open-addressing segments.  The top bits of a key's
+// hash pick a directory entry, which points to a segment; the low bits
+// pick the home bucket inside the segment, probed linearly.  A full
+// segment doubles until it reaches SEGMENT_SLOTS buckets, and after that
+// splits into two on the next hash bit, so growth moves at most one
+// segment's pairs and no block is ever larger than a segment.
+//
+// @author Nick Creeley - nc8004
+//
+// version control:
+// git hw6 repository
+//
+// // // // // // // // // // // // // // // // // // // // // // // // // // // // // //
+
+//include standard libraries
+
+#include <stdbool.h>
+
+#include <stddef.h>
+
+#include <stdlib.h>
+
+#include <assert.h>
+
+#include <string.h>
+
+#include <stdint.h>
+
+//include header files
+
+#include "HashADT.h"
+
+#include "HTLayout.h"
+
+//buckets in a new segment, and the most a segment grows to before it
+//splits; both powers of two.  A segment whose split would not separate
+//its keys (equal hashes, say) grows past SEGMENT_SLOTS instead
+
+#define SEGMENT_MIN 16
+
+#define SEGMENT_SLOTS 1024
+
+/// A stored pair, as in HashADT.c
+
+typedef struct SegmentPair {
+
+    void *key;
+
+    void *value;
+
+} SegmentPair;
+
+/// A segment: one block holding this header, the pairs and, after them,
+/// the full hash of each pair, so splits never call the hash function
+
+typedef struct Segment {
+
+    //buckets, a power of two, and pairs stored
+
+    size_t slots;
+
+    size_t count;
+
+    //hash bits shared by every key in the segment
+
+    unsigned depth;
+
+    SegmentPair pairs[];
+
+} Segment;
+
+/// The directory: 2^depth entries, each segment of depth d filling the
+/// 2^(depth - d) consecutive entries that share its top d bits
+
+typedef struct Directory {
+
+    Segment **segments;
+
+    unsigned depth;
+
+} Directory;
+
+/// seg_hashes(): the hash array after a segment's pairs
+
+static uint64_t *seg_hashes( const Segment *s ) {
+
+    return (uint64_t *) (s -> pairs + s -> slots);
+}
+
+/// seg_bytes(): the size of a segment block with slots buckets
+
+static size_t seg_bytes( size_t slots ) {
+
+    return sizeof(Segment) + slots * (sizeof(SegmentPair) + sizeof(uint64_t));
+}
+
+/// seg_new(): an empty segment
+
+static Segment *seg_new( const HashADT t, size_t slots, unsigned depth ) {
+
+    Segment *s = (Segment *) ht_layout_alloc(t, seg_bytes(slots));
+
+    assert(s != NULL);
+
+    memset(s, 0, seg_bytes(slots));
+
+    s -> slots = slots;
+
+    s -> depth = depth;
+
+    return s;
+}
+
+/// seg_free(): release a segment block
+
+static void seg_free( const HashADT t, Segment *s ) {
+
+    ht_layout_free(t, s, seg_bytes(s -> slots));
+}
+
+/// seg_place(): store a pair known to be absent in the first free bucket
+/// from its home
+
+static void seg_place( Segment *s, uint64_t hash, void *key, void *value ) {
+
+    size_t mask = s -> slots - 1;
+
+    size_t index = (size_t) hash & mask;
+
+    while(s -> pairs[index].key != NULL) {
+
+        index = (index + 1) & mask;
+    }
+
+    s -> pairs[index].key = key;
+
+    s -> pairs[index].value = value;
+
+    seg_hashes(s)[index] = hash;
+
+    s -> count++;
+}
+
+/// seg_index(): the directory entry for a hash
+
+static size_t seg_index( const Directory *d, uint64_t hash ) {
+
+    return d -> depth == 0 ? 0 : (size_t) (hash >> (64 - d -> depth));
+}
+
+/// seg_first(): whether entry i is the first of its segment's entries,
+/// so walks over the directory visit each segment once
+
+static bool seg_first( const Directory *d, size_t i ) {
+
+    Segment *s = d -> segments[i];
+
+    return (i & (((size_t) 1 << (d -> depth - s -> depth)) - 1)) == 0;
+}
+
+/// seg_point(): point every directory entry of the segment at entry i
+/// (any of them) to s
+
+static void seg_point( Directory *d, size_t i, unsigned depth, Segment *s ) {
+
+    size_t span = (size_t) 1 << (d -> depth - depth);
+
+    size_t first = i & ~(span - 1);
+
+    for(size_t j = 0; j < span; j++) {
+
+        d -> segments[first + j] = s;
+    }
+}
+
+/// seg_double_directory(): give the directory one more hash bit
+
+static void seg_double_directory( const HashADT t, Directory *d ) {
+
+    size_t entries = (size_t) 1 << d -> depth;
+
+    Segment **segments = (Segment **) ht_layout_alloc(t, 2 * entries * sizeof(Segment *));
+
+    assert(segments != NULL);
+
+    for(size_t i = 0; i < entries; i++) {
+
+        segments[2 * i] = d -> segments[i];
+
+        segments[2 * i + 1] = d -> segments[i];
+    }
+
+    ht_layout_free(t, d -> segments, entries * sizeof(Segment *));
+
+    d -> segments = segments;
+
+    d -> depth++;
+}
+
+/// seg_splits(): whether splitting s on bit would leave pairs in both
+/// halves
+
+static bool seg_splits( const Segment *s, uint64_t bit ) {
+
+    const uint64_t *hashes = seg_hashes(s);
+
+    bool low = false;
+
+    bool high = false;
+
+    for(size_t j = 0; j < s -> slots; j++) {
+
+        if(s -> pairs[j].key != NULL) {
+
+            if(hashes[j] & bit) {
+                high = true;
+            } else {
+                low = true;
+            }
+        }
+    }
+
+    return low && high;
+}
+
+/// seg_make_room(): grow or split the segment at entry i so it can take
+/// one more pair
+///
+/// a segment below SEGMENT_SLOTS doubles; a full size one splits on bit
+/// depth of the hash (counting from the top) into two segments of its
+/// size.  Either way only its own pairs move.  A split that would send
+/// every pair one way, or would double the directory past one entry per
+/// stored pair, is not made and the segment doubles instead, so keys
+/// with equal hashes cost one large segment rather than a directory of
+/// 2^64 entries
+
+static void seg_make_room( HashADT t, Directory *d, size_t i ) {
+
+    uint64_t start = ht_layout_now_ns();
+
+    Segment *s = d -> segments[i];
+
+    uint64_t *hashes = seg_hashes(s);
+
+    uint64_t bit = s -> depth < 64 ? (uint64_t) 1 << (63 - s -> depth) : 0;
+
+    bool split = s -> slots >= SEGMENT_SLOTS && bit != 0 && seg_splits(s, bit);
+
+    if(split && s -> depth == d -> depth) {
+
+        split = ((size_t) 2 << d -> depth) <= ht_occupancy(t);
+    }
+
+    if(!split) {
+
+        Segment *grown = seg_new(t, s -> slots * 2, s -> depth);
+
+        for(size_t j = 0; j < s -> slots; j++) {
+
+            if(s -> pairs[j].key != NULL) {
+
+                seg_place(grown, hashes[j], s -> pairs[j].key, s -> pairs[j].value);
+            }
+        }
+
+        seg_point(d, i, s -> depth, grown);
+
+        seg_free(t, s);
+
+        ht_layout_rehashed(t, ht_layout_now_ns() - start);
+
+        return;
+    }
+
+    if(s -> depth == d -> depth) {
+
+        seg_double_directory(t, d);
+
+        i *= 2;
+    }
+
+    Segment *low = seg_new(t, s -> slots, s -> depth + 1);
+
+    Segment *high = seg_new(t, s -> slots, s -> depth + 1);
+
+    for(size_t j = 0; j < s -> slots; j++) {
+
+        if(s -> pairs[j].key != NULL) {
+
+            seg_place((hashes[j] & bit) ? high : low, hashes[j], s -> pairs[j].key, s -> pairs[j].value);
+        }
+    }
+
+    //the old entries split in half, the lower half to low
+
+    size_t span = (size_t) 1 << (d -> depth - s -> depth);
+
+    size_t first = i & ~(span - 1);
+
+    for(size_t j = 0; j < span; j++) {
+
+        d -> segments[first + j] = j < span / 2 ? low : high;
+    }
+
+    seg_free(t, s);
+
+    ht_layout_rehashed(t, ht_layout_now_ns() - start);
+}
+
+/// seg_create(): a directory of one segment
+
+static void *seg_create( HashADT t ) {
+
+    Directory *d = (Directory *) ht_layout_alloc(t, sizeof(Directory));
+
+    assert(d != NULL);
+
+    d -> depth = 0;
+
+    d -> segments = (Segment **) ht_layout_alloc(t, sizeof(Segment *));
+
+    assert(d -> segments != NULL);
+
+    d -> segments[0] = seg_new(t, SEGMENT_MIN, 0);
+
+    return d;
+}
+
+/// seg_destroy(): release every segment and the directory
+
+static void seg_destroy( HashADT t, void *state ) {
+
+    Directory *d = (Directory *) state;
+
+    size_t entries = (size_t) 1 << d -> depth;
+
+    //step over each segment's entries before freeing it
+
+    for(size_t i = 0; i < entries; ) {
+
+        Segment *s = d -> segments[i];
+
+        i += (size_t) 1 << (d -> depth - s -> depth);
+
+        seg_free(t, s);
+    }
+
+    ht_layout_free(t, d -> segments, entries * sizeof(Segment *));
+
+    ht_layout_free(t, d, sizeof(Directory));
+}
+
+/// seg_lookup(): the bucket holding key in s, or s -> slots
+
+static size_t seg_lookup( const HashADT t, const Segment *s, uint64_t hash, const void *key ) {
+
+    size_t mask = s -> slots - 1;
+
+    size_t index = (size_t) hash & mask;
+
+    const uint64_t *hashes = seg_hashes(s);
+
+    uint64_t probes = 0;
+
+    //a segment is never full, so the probe always meets an empty bucket
+
+    while(s -> pairs[index].key != NULL) {
+
+        if(hashes[index] == hash && ht_layout_equals(t, key, s -> pairs[index].key)) {
+
+            break;
+        }
+
+        index = (index + 1) & mask;
+
+        probes++;
+    }
+
+    if(probes > 0) {
+
+        ht_layout_collisions(t, probes);
+    }
+
+    return s -> pairs[index].key != NULL ? index : s -> slots;
+}
+
+/// seg_find(): look up a key
+
+static bool seg_find( const HashADT t, void *state, const void *key, const void **value ) {
+
+    const Directory *d = (const Directory *) state;
+
+    uint64_t hash = ht_layout_hash(t, key);
+
+    const Segment *s = d -> segments[seg_index(d, hash)];
+
+    size_t index = seg_lookup(t, s, hash, key);
+
+    if(index == s -> slots) {
+        return false;
+    }
+
+    *value = s -> pairs[index].value;
+
+    return true;
+}
+
+/// seg_insert(): add or update a key, making room in its segment first
+/// when it is at the load threshold
+
+static void *seg_insert( HashADT t, void *state, const void *key, const void *value, bool *added ) {
+
+    Directory *d = (Directory *) state;
+
+    uint64_t hash = ht_layout_hash(t, key);
+
+    size_t i = seg_index(d, hash);
+
+    Segment *s = d -> segments[i];
+
+    size_t index = seg_lookup(t, s, hash, key);
+
+    if(index != s -> slots) {
+
+        void *old_value = s -> pairs[index].value;
+
+        s -> pairs[index].value = (void *) value;
+
+        *added = false;
+
+        return old_value;
+    }
+
+    //a split can leave every pair on one side, so repeat until it fits
+
+    while((double) (s -> count + 1) / s -> slots > LOAD_THRESHOLD) {
+
+        seg_make_room(t, d, i);
+
+        i = seg_index(d, hash);
+
+        s = d -> segments[i];
+    }
+
+    seg_place(s, hash, (void *) key, (void *) value);
+
+    *added = true;
+
+    return NULL;
+}
+
+/// seg_remove(): take a key out of its segment by backward shift, as
+/// in HTSoA.c; segments never shrink or merge
+
+static bool seg_remove( HashADT t, void *state, const void *key, void **key_out, void **value_out ) {
+
+    Directory *d = (Directory *) state;
+
+    uint64_t hash = ht_layout_hash(t, key);
+
+    Segment *s = d -> segments[seg_index(d, hash)];
+
+    uint64_t *hashes = seg_hashes(s);
+
+    size_t mask = s -> slots - 1;
+
+    size_t hole = seg_lookup(t, s, hash, key);
+
+    if(hole == s -> slots) {
+        return false;
+    }
+
+    *key_out = s -> pairs[hole].key;
+
+    *value_out = s -> pairs[hole].value;
+
+    for(size_t i = (hole + 1) & mask; s -> pairs[i].key != NULL; i = (i + 1) & mask) {
+
+        //the pair stays if its home lies cyclically in (hole, i]
+
+        if(((i - (size_t) hashes[i]) & mask) < ((i - hole) & mask)) {
+            continue;
+        }
+
+        s -> pairs[hole] = s -> pairs[i];
+
+        hashes[hole] = hashes[i];
+
+        hole = i;
+    }
+
+    s -> pairs[hole].key = NULL;
+
+    s -> pairs[hole].value = NULL;
+
+    s -> count--;
+
+    return true;
+}
+
+/// seg_each(): visit every pair, segment by segment
+
+static void seg_each( const HashADT t, void *state,
+        void (*visit)( void *context, void *key, void *value ), void *context ) {
+
+    (void) t;
+
+    const Directory *d = (const Directory *) state;
+
+    size_t entries = (size_t) 1 << d -> depth;
+
+    for(size_t i = 0; i < entries; i++) {
+
+        if(!seg_first(d, i)) {
+            continue;
+        }
+
+        const Segment *s = d -> segments[i];
+
+        for(size_t j = 0; j < s -> slots; j++) {
+
+            if(s -> pairs[j].key != NULL) {
+
+                visit(context, s -> pairs[j].key, s -> pairs[j].value);
+            }
+        }
+    }
+}
+
+/// seg_stats_bucket(): the log2 histogram bucket a value falls in
+
+static size_t seg_stats_bucket( uint64_t value ) {
+
+    size_t bucket = 0;
+
+    while(value > 0 && bucket < HT_STATS_BUCKETS - 1) {
+
+        value >>= 1;
+
+        bucket++;
+    }
+
+    return bucket;
+}
+
+/// seg_stats(): capacity, probe distances, runs and bytes of every segment
+
+static void seg_stats( const HashADT t, void *state, HTStats *stats ) {
+
+    (void) t;
+
+    const Directory *d = (const Directory *) state;
+
+    size_t entries = (size_t) 1 << d -> depth;
+
+    uint64_t total = 0;
+
+    stats -> capacity = 0;
+
+    stats -> max_probe = 0;
+
+    stats -> bytes_used = sizeof(Directory) + entries * sizeof(Segment *);
+
+    for(size_t i = 0; i < entries; i++) {
+
+        if(!seg_first(d, i)) {
+            continue;
+        }
+
+        const Segment *s = d -> segments[i];
+
+        const uint64_t *hashes = seg_hashes(s);
+
+        size_t mask = s -> slots - 1;
+
+        stats -> capacity += s -> slots;
+
+        stats -> bytes_used += seg_bytes(s -> slots);
+
+        //as in ht_stats(), start after an empty bucket so no run wraps
+
+        size_t start = 0;
+
+        while(s -> pairs[start].key != NULL) {
+
+            start++;
+        }
+
+        uint64_t run = 0;
+
+        for(size_t n = 1; n <= s -> slots; n++) {
+
+            size_t j = (start + n) & mask;
+
+            if(s -> pairs[j].key == NULL) {
+
+                if(run > 0) {
+
+                    stats -> cluster_histogram[seg_stats_bucket(run)]++;
+                }
+
+                run = 0;
+
+                continue;
+            }
+
+            run++;
+
+            uint64_t distance = (j - (size_t) hashes[j]) & mask;
+
+            stats -> probe_histogram[seg_stats_bucket(distance)]++;
+
+            total += distance;
+
+            if(distance > stats -> max_probe) {
+
+                stats -> max_probe = distance;
+            }
+        }
+
+        if(run > 0) {
+
+            stats -> cluster_histogram[seg_stats_bucket(run)]++;
+        }
+    }
+
+    stats -> mean_probe = stats -> size > 0 ? (double) total / stats -> size : 0.0;
+}
+
+/// The segmented layout, see HTLayout.h
+
+const HTLayoutOps ht_layout_segmented = {
+    seg_create,
+    seg_destroy,
+    seg_find,
+    seg_insert,
+    seg_remove,
+    seg_each,
+    seg_stats
+};
@@ -0,0 +1,665 @@
+//
+// File name: HTSoA.c
+//
+// Description:
+// The HT_LAYOUT_SOA storage of HashADT: linear probing over three
+// parallel arrays instead of one array of pairs.  A byte per bucket holds
+// a 7 bit tag from the top of the key's hash, or EMPTY; the keys and the
+// values follow in arrays of their own.  A probe compares 16 tags at a
+// time (one SSE2 instruction on x86), calls equals only for keys whose
+// tag matches, and reads the value array only for the key it finds, so
+// ht_has() never touches values at all.  A table whose values are all
+// NULL, such as every HashSet, never allocates the value array.  A table
+// with a value_size keeps the values themselves in that array.
+//
+// @author Nick Creeley - nc8004
+//
+// version control:
+// git hw6 repository
+//
+// // // // // // // // // // // // // // // // // // // // // // // // // // // // // //
+
+//include standard libraries
+
+#include <stdbool.h>
+
+#include <stddef.h>
+
+#include <stdlib.h>
+
+#include <assert.h>
+
+#include <string.h>
+
+#include <stdint.h>
+
+//the group compare uses SSE2 where the compiler targets it (every
+//x86_64 build), and a byte loop elsewhere
+
+#if defined(__SSE2__)
+#define SOA_SSE2 1
+#include <emmintrin.h>
+#else
+#define SOA_SSE2 0
+#endif
+
+//include header files
+
+#include "HashADT.h"
+
+#include "HTLayout.h"
+
+//tags compared at once, and the smallest capacity, which must hold a group
+
+#define GROUP 16
+
+//tag of an empty bucket; stored tags are 0..127, so only EMPTY has the
+//high bit set
+
+#define EMPTY 0x80
+
+/// The arrays of a table: tags and keys in one block starting at tags,
+/// values in another.  tags has GROUP extra bytes mirroring its first
+/// GROUP, so a group that starts near the end reads on past it without
+/// wrapping.  The value array holds a pointer per bucket, made when the
+/// first value that is not NULL arrives, or with a value_size, a copy of
+/// each value, made at once
+
+typedef struct SoATable {
+
+    //buckets, a power of two, and pairs stored
+
+    size_t capacity;
+
+    size_t count;
+
+    uint8_t *tags;
+
+    void **keys;
+
+    //value bytes copied per pair, 0 to store pointers, and the bytes
+    //per bucket of the value array
+
+    size_t value_size;
+
+    size_t stride;
+
+    //NULL while every value is NULL
+
+    unsigned char *values;
+
+} SoATable;
+
+/// soa_bytes(): the size of the tag and key block for capacity buckets
+
+static size_t soa_bytes( size_t capacity ) {
+
+    return capacity + GROUP + capacity * sizeof(void *);
+}
+
+/// soa_need_values(): make the value array, every value NULL or zero
+
+static void soa_need_values( const HashADT t, SoATable *s ) {
+
+    s -> values = (unsigned char *) ht_layout_alloc(t, s -> capacity * s -> stride);
+
+    assert(s -> values != NULL);
+
+    memset(s -> values, 0, s -> capacity * s -> stride);
+}
+
+/// soa_value(): the value of a bucket as the client sees it, a pointer
+/// into the value array when values are copied
+
+static void *soa_value( const SoATable *s, size_t index ) {
+
+    if(s -> values == NULL) {
+        return NULL;
+    }
+
+    if(s -> value_size > 0) {
+        return s -> values + index * s -> stride;
+    }
+
+    return ((void **) s -> values)[index];
+}
+
+/// soa_store(): set the value of a bucket; a copied value is read from
+/// value, or zeroed when it is NULL
+
+static void soa_store( SoATable *s, size_t index, const void *value ) {
+
+    if(s -> value_size == 0) {
+
+        ((void **) s -> values)[index] = (void *) value;
+
+    } else if(value != NULL) {
+
+        memmove(s -> values + index * s -> stride, value, s -> value_size);
+
+    } else {
+
+        memset(s -> values + index * s -> stride, 0, s -> value_size);
+    }
+}
+
+/// soa_alloc(): empty arrays for capacity buckets, with a value array if
+/// values is true
+
+static void soa_alloc( const HashADT t, SoATable *s, size_t capacity, bool values ) {
+
+    uint8_t *block = (uint8_t *) ht_layout_alloc(t, soa_bytes(capacity));
+
+    assert(block != NULL);
+
+    memset(block, EMPTY, capacity + GROUP);
+
+    s -> capacity = capacity;
+
+    s -> tags = block;
+
+    //capacity + GROUP is a multiple of 16, so the pointers stay aligned
+
+    s -> keys = (void **) (block + capacity + GROUP);
+
+    s -> values = NULL;
+
+    if(values || s -> value_size > 0) {
+
+        soa_need_values(t, s);
+    }
+}
+
+/// soa_free(): release the arrays
+
+static void soa_free( const HashADT t, SoATable *s ) {
+
+    ht_layout_free(t, s -> tags, soa_bytes(s -> capacity));
+
+    if(s -> values != NULL) {
+
+        ht_layout_free(t, s -> values, s -> capacity * s -> stride);
+    }
+}
+
+/// soa_tag(): the tag of a hash, its top 7 bits; the home bucket comes
+/// from the low bits, so the two are independent
+
+static uint8_t soa_tag( uint64_t hash ) {
+
+    return (uint8_t) (hash >> 57);
+}
+
+/// soa_set_tag(): store a bucket's tag, and its mirror past the end
+
+static void soa_set_tag( SoATable *s, size_t index, uint8_t tag ) {
+
+    s -> tags[index] = tag;
+
+    if(index < GROUP) {
+
+        s -> tags[s -> capacity + index] = tag;
+    }
+}
+
+/// soa_group(): compare the GROUP tags at tags with tag; bit i of the
+/// result is set when tags[i] matches, and bit i of *empty when it is
+/// EMPTY
+
+static unsigned soa_group( const uint8_t *tags, uint8_t tag, unsigned *empty ) {
+
+#if SOA_SSE2
+
+    __m128i group = _mm_loadu_si128((const __m128i *) tags);
+
+    *empty = (unsigned) _mm_movemask_epi8(group);
+
+    return (unsigned) _mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8((char) tag)));
+
+#else
+
+    unsigned match = 0;
+
+    *empty = 0;
+
+    for(unsigned i = 0; i < GROUP; i++) {
+
+        match |= (unsigned) (tags[i] == tag) << i;
+
+        *empty |= (unsigned) (tags[i] == EMPTY) << i;
+    }
+
+    return match;
+
+#endif
+}
+
+/// soa_lowest(): the index of the lowest set bit of a nonzero mask
+
+static unsigned soa_lowest( unsigned mask ) {
+
+#if defined(__GNUC__) || defined(__clang__)
+
+    return (unsigned) __builtin_ctz(mask);
+
+#else
+
+    unsigned bit = 0;
+
+    while((mask & 1) == 0) {
+
+        mask >>= 1;
+
+        bit++;
+    }
+
+    return bit;
+
+#endif
+}
+
+/// soa_probe(): find key, whose hash is hash
+///
+/// returns true with *index at its bucket, or false with *index at the
+/// first empty bucket of its probe, where it would be inserted.  The
+/// table is never full, so every probe meets an empty bucket
+
+static bool soa_probe( const HashADT t, const SoATable *s, uint64_t hash, const void *key, size_t *index ) {
+
+    size_t mask = s -> capacity - 1;
+
+    size_t home = (size_t) hash & mask;
+
+    size_t start = home;
+
+    uint8_t tag = soa_tag(hash);
+
+    //the key most likely wanted is at home; start loading it alongside
+    //the tags rather than after them
+
+#if defined(__GNUC__) || defined(__clang__)
+
+    __builtin_prefetch(&s -> keys[home]);
+
+#endif
+
+    for(;;) {
+
+        unsigned empty;
+
+        unsigned match = soa_group(s -> tags + start, tag, &empty);
+
+        //linear probing: nothing past the first empty bucket belongs here
+
+        if(empty != 0) {
+
+            match &= (empty & (0u - empty)) - 1;
+        }
+
+        while(match != 0) {
+
+            size_t i = (start + soa_lowest(match)) & mask;
+
+            if(ht_layout_equals(t, key, s -> keys[i])) {
+
+                ht_layout_collisions(t, (i - home) & mask);
+
+                *index = i;
+
+                return true;
+            }
+
+            match &= match - 1;
+        }
+
+        if(empty != 0) {
+
+            *index = (start + soa_lowest(empty)) & mask;
+
+            ht_layout_collisions(t, (*index - home) & mask);
+
+            return false;
+        }
+
+        start = (start + GROUP) & mask;
+    }
+}
+
+/// soa_place(): store a pair known to be absent in the first empty
+/// bucket from its home; the value must be NULL if there is no value
+/// array
+
+static void soa_place( SoATable *s, uint64_t hash, void *key, void *value ) {
+
+    size_t mask = s -> capacity - 1;
+
+    size_t index = (size_t) hash & mask;
+
+    while(s -> tags[index] != EMPTY) {
+
+        index = (index + 1) & mask;
+    }
+
+    soa_set_tag(s, index, soa_tag(hash));
+
+    s -> keys[index] = key;
+
+    if(s -> values != NULL) {
+
+        soa_store(s, index, value);
+    }
+
+    s -> count++;
+}
+
+/// soa_grow(): move every pair into arrays of twice the capacity
+///
+/// the old arrays are left in old for the caller to free, since the
+/// value being added may be a copy in them
+
+static void soa_grow( HashADT t, SoATable *s, SoATable *old ) {
+
+    uint64_t start = ht_layout_now_ns();
+
+    *old = *s;
+
+    soa_alloc(t, s, old -> capacity * RESIZE_FACTOR, old -> values != NULL);
+
+    s -> count = 0;
+
+    for(size_t i = 0; i < old -> capacity; i++) {
+
+        if(old -> tags[i] != EMPTY) {
+
+            soa_place(s, ht_layout_hash(t, old -> keys[i]), old -> keys[i], soa_value(old, i));
+        }
+    }
+
+    ht_layout_rehashed(t, ht_layout_now_ns() - start);
+}
+
+/// soa_create(): an empty table of INITIAL_CAPACITY buckets
+
+static void *soa_create( HashADT t ) {
+
+    SoATable *s = (SoATable *) ht_layout_alloc(t, sizeof(SoATable));
+
+    assert(s != NULL);
+
+    //copies keep the alignment of value_size rounded up to a power of
+    //two, at most 8
+
+    s -> value_size = ht_layout_value_size(t);
+
+    size_t align = 1;
+
+    while(align < 8 && align < s -> value_size) {
+
+        align *= 2;
+    }
+
+    s -> stride = s -> value_size > 0
+        ? (s -> value_size + align - 1) & ~(align - 1) : sizeof(void *);
+
+    soa_alloc(t, s, INITIAL_CAPACITY < GROUP ? GROUP : INITIAL_CAPACITY, false);
+
+    s -> count = 0;
+
+    return s;
+}
+
+/// soa_destroy(): release the arrays and the table
+
+static void soa_destroy( HashADT t, void *state ) {
+
+    SoATable *s = (SoATable *) state;
+
+    soa_free(t, s);
+
+    ht_layout_free(t, s, sizeof(SoATable));
+}
+
+/// soa_find(): look up a key
+
+static bool soa_find( const HashADT t, void *state, const void *key, const void **value ) {
+
+    const SoATable *s = (const SoATable *) state;
+
+    size_t index;
+
+    if(!soa_probe(t, s, ht_layout_hash(t, key), key, &index)) {
+        return false;
+    }
+
+    *value = soa_value(s, index);
+
+    return true;
+}
+
+/// soa_insert(): add or update a key, growing first when the table is at
+/// the load threshold
+
+static void *soa_insert( HashADT t, void *state, const void *key, const void *value, bool *added ) {
+
+    SoATable *s = (SoATable *) state;
+
+    uint64_t hash = ht_layout_hash(t, key);
+
+    size_t index;
+
+    if(value != NULL && s -> values == NULL) {
+
+        soa_need_values(t, s);
+    }
+
+    if(soa_probe(t, s, hash, key, &index)) {
+
+        void *old_value = NULL;
+
+        if(s -> values != NULL) {
+
+            //a copied value has no old pointer, so its bucket stands in
+
+            old_value = soa_value(s, index);
+
+            soa_store(s, index, value);
+        }
+
+        *added = false;
+
+        return old_value;
+    }
+
+    if((double) (s -> count + 1) / s -> capacity > LOAD_THRESHOLD) {
+
+        //value may be ht_get() of another key, so the old arrays live
+        //until it is copied
+
+        SoATable old;
+
+        soa_grow(t, s, &old);
+
+        soa_place(s, hash, (void *) key, (void *) value);
+
+        soa_free(t, &old);
+
+    } else {
+
+        soa_place(s, hash, (void *) key, (void *) value);
+    }
+
+    *added = true;
+
+    return NULL;
+}
+
+/// soa_remove(): take a key out by backward shift
+///
+/// each pair after the hole that may move back (its home is not between
+/// the hole and it) fills the hole and leaves a new one, until the run
+/// ends; no tombstones are left, so probes stay as short as at insert
+
+static bool soa_remove( HashADT t, void *state, const void *key, void **key_out, void **value_out ) {
+
+    SoATable *s = (SoATable *) state;
+
+    size_t mask = s -> capacity - 1;
+
+    size_t hole;
+
+    if(!soa_probe(t, s, ht_layout_hash(t, key), key, &hole)) {
+        return false;
+    }
+
+    *key_out = s -> keys[hole];
+
+    //a copied value is about to be overwritten, so there is none to give
+
+    *value_out = s -> value_size == 0 ? soa_value(s, hole) : NULL;
+
+    for(size_t i = (hole + 1) & mask; s -> tags[i] != EMPTY; i = (i + 1) & mask) {
+
+        size_t home = (size_t) ht_layout_hash(t, s -> keys[i]) & mask;
+
+        //the pair stays if its home lies cyclically in (hole, i]
+
+        if(((i - home) & mask) < ((i - hole) & mask)) {
+            continue;
+        }
+
+        soa_set_tag(s, hole, s -> tags[i]);
+
+        s -> keys[hole] = s -> keys[i];
+
+        if(s -> values != NULL) {
+
+            memcpy(s -> values + hole * s -> stride, s -> values + i * s -> stride, s -> stride);
+        }
+
+        hole = i;
+    }
+
+    soa_set_tag(s, hole, EMPTY);
+
+    s -> count--;
+
+    return true;
+}
+
+/// soa_each(): visit every pair in bucket order
+
+static void soa_each( const HashADT t, void *state,
+        void (*visit)( void *context, void *key, void *value ), void *context ) {
+
+    (void) t;
+
+    const SoATable *s = (const SoATable *) state;
+
+    for(size_t i = 0; i < s -> capacity; i++) {
+
+        if(s -> tags[i] != EMPTY) {
+
+            visit(context, s -> keys[i], soa_value(s, i));
+        }
+    }
+}
+
+/// soa_stats_bucket(): the log2 histogram bucket a value falls in
+
+static size_t soa_stats_bucket( uint64_t value ) {
+
+    size_t bucket = 0;
+
+    while(value > 0 && bucket < HT_STATS_BUCKETS - 1) {
+
+        value >>= 1;
+
+        bucket++;
+    }
+
+    return bucket;
+}
+
+/// soa_stats(): capacity, probe distances, runs and bytes
+///
+/// like the flat table's, this rehashes every key
+
+static void soa_stats( const HashADT t, void *state, HTStats *stats ) {
+
+    const SoATable *s = (const SoATable *) state;
+
+    size_t mask = s -> capacity - 1;
+
+    uint64_t total = 0;
+
+    stats -> capacity = s -> capacity;
+
+    stats -> max_probe = 0;
+
+    stats -> bytes_used = sizeof(SoATable) + soa_bytes(s -> capacity);
+
+    if(s -> values != NULL) {
+
+        stats -> bytes_used += s -> capacity * s -> stride;
+    }
+
+    //start after an empty bucket so no run wraps
+
+    size_t start = 0;
+
+    while(s -> tags[start] != EMPTY) {
+
+        start++;
+    }
+
+    uint64_t run = 0;
+
+    for(size_t n = 1; n <= s -> capacity; n++) {
+
+        size_t i = (start + n) & mask;
+
+        if(s -> tags[i] == EMPTY) {
+
+            if(run > 0) {
+
+                stats -> cluster_histogram[soa_stats_bucket(run)]++;
+            }
+
+            run = 0;
+
+            continue;
+        }
+
+        run++;
+
+        uint64_t distance = (i - (size_t) ht_layout_hash(t, s -> keys[i])) & mask;
+
+        stats -> probe_histogram[soa_stats_bucket(distance)]++;
+
+        total += distance;
+
+        if(distance > stats -> max_probe) {
+
+            stats -> max_probe = distance;
+        }
+    }
+
+    if(run > 0) {
+
+        stats -> cluster_histogram[soa_stats_bucket(run)]++;
+    }
+
+    stats -> mean_probe = stats -> size > 0 ? (double) total / stats -> size : 0.0;
+}
+
+/// The structure-of-arrays layout, see HTLayout.h
+
+const HTLayoutOps ht_layout_soa = {
+    soa_create,
+    soa_destroy,
+    soa_find,
+    soa_insert,
+    soa_remove,
+    soa_each,
+    soa_stats
+};
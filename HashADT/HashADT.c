@@ -11,6 +11,11 @@
 //
 // // // // // // // // // // // // // // // // // // // // // // // // // // // // // //
 
+//clock_gettime() and posix_memalign() are POSIX, MAP_ANONYMOUS and the
+//madvise() flags are GNU extensions
+
+#define _GNU_SOURCE
+
 //include standard libraries
 
 #include <stdbool.h>
@@ -23,430 +28,3552 @@
 
 #include <stdio.h>
 
+#include <string.h>
+
+#include <stdint.h>
+
+#include <inttypes.h>
+
+#include <time.h>
+
+#ifdef __linux__
+
+#include <sys/mman.h>
+
+#include <sys/syscall.h>
+
+#include <unistd.h>
+
+#include <pthread.h>
+
+#include <sched.h>
+
+#define HT_MMAP 1
+
+#else
+
+#define HT_MMAP 0
+
+#endif
+
 //include header file
 
 #include "HashADT.h"
 
+#include "HashFunctions.h"
+
+#include "HTLayout.h"
+
+//operation counters cost a read-modify-write on every probe, so they are
+//only compiled in when HASHADT_STATS is nonzero; by default that is every
+//build except NDEBUG (release) builds
+
+#ifndef HASHADT_STATS
+#ifdef NDEBUG
+#define HASHADT_STATS 0
+#else
+#define HASHADT_STATS 1
+#endif
+#endif
+
+#if HASHADT_STATS
+#define HT_COUNT(counter) ((counter)++)
+#else
+#define HT_COUNT(counter) ((void) 0)
+#endif
+
 /// The KeyValuePair is a struct representing a key value pair
 /// 
 /// The key and value are both null pointers, allowing them to store any data
 
-typedef struct KeyValuePair {
+typedef struct KeyValuePair {
+
+    void* key;
+
+    void* value;
+
+} KeyValuePair;
+
+
+//first slab size; later slabs double up to SLAB_MAX
+
+#define SLAB_MIN ((size_t) 64 << 10)
+
+#define SLAB_MAX ((size_t) 16 << 20)
+
+//alignment of every copy in a slab
+
+#define SLAB_ALIGN 16
+
+//alignment of every bucket array, one cache line, so a pair never
+//straddles two lines
+
+#define TABLE_ALIGN 64
+
+//huge page size that mapped bucket arrays are aligned and rounded to
+
+#define HUGE_PAGE ((size_t) 2 << 20)
+
+//most NUMA nodes and CPUs the placement code knows about
+
+#define MAX_NODES 64
+
+#define MAX_CPUS 4096
+
+//node arguments of ht_table_alloc() besides a node number
+
+#define NODE_ANY (-1)
+
+#define NODE_INTERLEAVE (-2)
+
+/// A block of memory holding copies made by ht_put_copy()
+
+typedef struct HTSlab {
+
+    struct HTSlab *next;
+
+    size_t size;
+
+    size_t used;
+
+    unsigned char data[];
+
+} HTSlab;
+
+/// An operation trace in progress, see ht_trace_start()
+
+typedef struct HTTrace {
+
+    FILE *file;
+
+    //records wait here until the buffer fills
+
+    unsigned char *buffer;
+
+    size_t size;
+
+    size_t used;
+
+    size_t (*key_bytes)(const void *key, void *buffer, size_t room);
+
+    uint64_t start_ns;
+
+    //false once any write has failed
+
+    bool ok;
+
+} HTTrace;
+
+/// The hash table representation of ADT
+/// Uses array of KeyValuePairs to represent hash table
+/// Holds given fcns from client to use
+/// Holds counters to keep track of performance
+
+struct hashtab_s {
+
+    //what every lookup reads comes first: with the struct cache line
+    //aligned these fields fill its first line, and the second begins
+    //with the seed mode and small flag
+
+    //the hash table itself, an array of KeyValue pairs (struct)
+    KeyValuePair* table;
+
+    //keep track of capacity
+    size_t capacity;
+
+    //handle all the fcns given to work with by client
+
+    size_t (*hash_fcn)(const void *key);
+
+    size_t (*keyed_hash_fcn)(const void *key, uint64_t seed);
+
+    bool (*equals_fcn)(const void *key1, const void *key2);
+
+    //seed mixed into every bucket index, and how it was chosen
+    uint64_t seed;
+
+    //the storage of a table that is not HT_LAYOUT_FLAT, which then has
+    //no bucket array of its own (table NULL, capacity 0)
+
+    const HTLayoutOps *layout;
+
+    //operation trace, NULL unless ht_trace_start() was called
+
+    HTTrace *trace;
+
+    HTSeedMode seed_mode;
+
+    //a small table keeps its first small_capacity pairs in small_pairs,
+    //packed in insertion order, until one more arrives
+
+    bool small;
+
+    //the rest is for inserts, growth and the less common paths
+
+    //track the occupancy
+    size_t occupancy;
+
+    //track # of rehashes
+    uint64_t rehashes;
+
+    //track # of times flooding was detected and the seed replaced
+    uint64_t reseeds;
+
+    //track # of pairs removed to stay within the memory budget
+    uint64_t evictions;
+
+    //track time spent moving pairs into new arrays
+    uint64_t rehash_ns;
+
+#if HASHADT_STATS
+
+    //track the collisions occured
+    uint64_t collisions;
+
+    //track lookups (ht_has, ht_get) and whether they found the key
+    uint64_t lookups;
+
+    uint64_t hits;
+
+    uint64_t misses;
+
+    //track ht_put calls that added a key and that replaced a value
+    uint64_t inserts;
+
+    uint64_t updates;
+
+#endif
+
+    //probe length past which an insert reseeds the table
+    size_t max_probe;
+
+    //whether max_probe follows the capacity or was given by the client
+    bool auto_probe;
+
+    //the client fcns only dump and destroy use
+
+    void (*print_fcn)(const void *key, const void *value);
+
+    void (*delete_fcn)(void *key, void *value);
+
+    //memory hooks from the client; alloc is NULL for malloc and free
+
+    HTAllocator allocator;
+
+    //how large bucket arrays are mapped, see HTOptions
+
+    HTHugePages huge_pages;
+
+    size_t huge_threshold;
+
+    HTPrefault prefault;
+
+    //bytes mapped for the current bucket array, 0 if it is from the heap
+
+    size_t table_mapping;
+
+    //occupancy at which to start preparing the next array, and that array
+
+    size_t prepare_at;
+
+    struct HTPrepared *prepared;
+
+    //whether growth first tries to resize the bucket array where it is
+
+    bool grow_in_place;
+
+    //NUMA placement; a replicating table keeps one bucket array per node,
+    //with replicas[0] == table, and replica_count 0 otherwise.  Arrays
+    //too small to be mapped are not copied: every entry is then table
+
+    HTNuma numa;
+
+    size_t replica_count;
+
+    KeyValuePair **replicas;
+
+    size_t *replica_mappings;
+
+    //slabs for ht_put_copy, newest first, and their total size
+
+    HTSlab *slabs;
+
+    uint64_t slab_bytes;
+
+    //bytes the layout holds through ht_layout_alloc(), and the client's
+    //bytes for the stored pairs as its pair_bytes fcn reports them
+
+    uint64_t layout_bytes;
+
+    size_t (*pair_bytes_fcn)(const void *key, const void *value);
+
+    uint64_t pair_bytes;
+
+    //memory budget (0 for none), what a put does when growing would pass
+    //it, the bucket eviction looks at next, and why the last put stored
+    //nothing
+
+    size_t memory_budget;
+
+    HTBudgetPolicy budget_policy;
+
+    size_t evict_hand;
+
+    HTError error;
+
+    void *layout_state;
+
+    //bytes of each value the layout copies in, 0 for value pointers
+
+    size_t value_size;
+
+    size_t small_capacity;
+
+    KeyValuePair *small_pairs;
+
+    //buckets of the array allocated right after the struct, which is the
+    //table until the first growth, or 0 if the table started without one
+
+    size_t inline_capacity;
+
+    //the small pairs' seeded hashes, followed by the pairs themselves, in
+    //the same allocation as the table struct; empty for other tables
+
+    uint64_t small_hashes[];
+
+};
+
+/// ht_seed_base(): a secret, nonzero base for the seeds of this process
+
+static uint64_t ht_seed_base( void ) {
+
+    uint64_t base = 0;
+
+    FILE *urandom = fopen("/dev/urandom", "rb");
+
+    if(urandom != NULL) {
+
+        if(fread(&base, sizeof(base), 1, urandom) != 1) {
+            base = 0;
+        }
+
+        fclose(urandom);
+    }
+
+    //fall back on the clock and a stack address, better than a constant
+
+    base ^= ht_mix64((uint64_t) time(NULL) ^ (uint64_t) (uintptr_t) &base);
+
+    return base | 1;
+}
+
+/// ht_random_seed(): draw a fresh seed for a table
+///
+/// the OS is asked for entropy once per process; each table then gets the
+/// next value of a splitmix sequence over that secret base.  Tables are
+/// made and reseeded on any thread, so the base is set by whichever
+/// thread gets there first and the counter is bumped atomically
+
+static uint64_t ht_random_seed( void ) {
+
+    static uint64_t base = 0;
+
+    static uint64_t counter = 0;
+
+#if defined(__GNUC__) || defined(__clang__)
+
+    uint64_t seed = __atomic_load_n(&base, __ATOMIC_ACQUIRE);
+
+    if(seed == 0) {
+
+        uint64_t drawn = ht_seed_base();
+
+        //a thread that loses the race takes the winner's base
+
+        if(__atomic_compare_exchange_n(&base, &seed, drawn, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            seed = drawn;
+        }
+    }
+
+    uint64_t step = __atomic_add_fetch(&counter, 0x9e3779b97f4a7c15ULL, __ATOMIC_RELAXED);
+
+#else
+
+    if(base == 0) {
+        base = ht_seed_base();
+    }
+
+    uint64_t seed = base;
+
+    uint64_t step = counter += 0x9e3779b97f4a7c15ULL;
+
+#endif
+
+    return ht_mix64(seed + step);
+}
+
+/// ht_probe_bound(): default max_probe for a capacity
+///
+/// clusters at the load threshold grow with log(capacity); 32 probes per
+/// doubling is far above what random keys produce
+
+static size_t ht_probe_bound( size_t capacity ) {
+
+    size_t bound = 0;
+
+    while(capacity > 1) {
+
+        capacity >>= 1;
+
+        bound += 32;
+    }
+
+    return bound;
+}
+
+/// ht_header_bytes(): the size of a table struct with room for
+/// small_capacity inline pairs, rounded up to a cache line so a bucket
+/// array can follow it in the same block
+
+static size_t ht_header_bytes( size_t small_capacity ) {
+
+    size_t bytes = sizeof(struct hashtab_s) + small_capacity * (sizeof(uint64_t) + sizeof(KeyValuePair));
+
+    return (bytes + TABLE_ALIGN - 1) & ~(size_t) (TABLE_ALIGN - 1);
+}
+
+/// ht_block_bytes(): the size of the block holding the table struct
+
+static size_t ht_block_bytes( const HashADT t ) {
+
+    return ht_header_bytes(t -> small_capacity) + t -> inline_capacity * sizeof(KeyValuePair);
+}
+
+/// ht_inline_table(): the first bucket array, allocated with the struct,
+/// or NULL if the table has none
+
+static KeyValuePair *ht_inline_table( const HashADT t ) {
+
+    if(t -> inline_capacity == 0) {
+        return NULL;
+    }
+
+    return (KeyValuePair *) ((unsigned char *) t + ht_header_bytes(t -> small_capacity));
+}
+
+/// ht_options_init(): default creation options
+///
+/// see headerfile for full documentation
+
+void ht_options_init( HTOptions *options ) {
+
+    assert(options != NULL);
+
+    options -> seed_mode = HT_SEED_NONE;
+
+    options -> seed = 0;
+
+    options -> keyed_hash = NULL;
+
+    options -> max_probe = 0;
+
+    options -> allocator = NULL;
+
+    options -> huge_pages = HT_HUGE_NONE;
+
+    options -> huge_threshold = 0;
+
+    options -> prefault = HT_PREFAULT_NONE;
+
+    options -> numa = HT_NUMA_DEFAULT;
+
+    options -> grow_in_place = false;
+
+    options -> layout = HT_LAYOUT_FLAT;
+
+    options -> small_capacity = 0;
+
+    options -> value_size = 0;
+
+    options -> memory_budget = 0;
+
+    options -> budget_policy = HT_BUDGET_REFUSE;
+
+    options -> pair_bytes = NULL;
+}
+
+/// ht_mem_alloc(): size bytes from the allocator, or malloc without one
+
+static void *ht_mem_alloc( const HTAllocator *allocator, size_t size ) {
+
+    if(allocator == NULL || allocator -> alloc == NULL) {
+
+        return malloc(size);
+    }
+
+    return allocator -> alloc(allocator -> context, size);
+}
+
+/// ht_mem_zalloc(): a zeroed, cache line aligned bucket array of size bytes
+///
+/// an allocator without aligned_alloc only promises malloc's alignment
+
+static void *ht_mem_zalloc( const HTAllocator *allocator, size_t size ) {
+
+    if(allocator -> alloc == NULL) {
+
+        void *ptr = NULL;
+
+        if(posix_memalign(&ptr, TABLE_ALIGN, size) != 0) {
+            return NULL;
+        }
+
+        memset(ptr, 0, size);
+
+        return ptr;
+    }
+
+    void *ptr = allocator -> aligned_alloc != NULL
+        ? allocator -> aligned_alloc(allocator -> context, TABLE_ALIGN, size)
+        : allocator -> alloc(allocator -> context, size);
+
+    if(ptr != NULL) {
+
+        memset(ptr, 0, size);
+    }
+
+    return ptr;
+}
+
+/// ht_mem_free(): give a block of size bytes back to where it came from
+
+static void ht_mem_free( const HTAllocator *allocator, void *ptr, size_t size ) {
+
+    if(allocator -> alloc == NULL) {
+
+        free(ptr);
+
+    } else if(ptr != NULL) {
+
+        allocator -> free(allocator -> context, ptr, size);
+    }
+}
+
+/// ht_map_length(): the bytes ht_map() maps for an array of bytes, whole
+/// huge pages
+
+static size_t ht_map_length( size_t bytes ) {
+
+    return (bytes + HUGE_PAGE - 1) & ~(HUGE_PAGE - 1);
+}
+
+#if HT_MMAP
+
+/// A bucket array mapped and faulted by a thread ahead of the growth
+/// that needs it
+
+typedef struct HTPrepared {
+
+    pthread_t thread;
+
+    size_t bytes;
+
+    HTHugePages huge_pages;
+
+    int node;
+
+    //results from the thread; table is NULL if mapping failed
+
+    void *table;
+
+    size_t mapping;
+
+} HTPrepared;
+
+//NUMA nodes and the node of each CPU, read from sysfs by ht_numa_init()
+
+static size_t ht_node_count = 0;
+
+static unsigned char ht_cpu_node[MAX_CPUS];
+
+/// ht_numa_init(): learn the NUMA layout once per process
+///
+/// libnuma is not needed: sysfs lists the CPUs of each node, and a
+/// machine without those files is treated as a single node
+
+static void ht_numa_init( void ) {
+
+    if(ht_node_count > 0) {
+        return;
+    }
+
+    size_t nodes = 1;
+
+    for(size_t node = 0; node < MAX_NODES; node++) {
+
+        char path[64];
+
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%zu/cpulist", node);
+
+        FILE *in = fopen(path, "r");
+
+        if(in == NULL) {
+            continue;
+        }
+
+        char list[4096];
+
+        //ranges like "0-3,8-11"
+
+        if(fgets(list, sizeof(list), in) != NULL) {
+
+            char *p = list;
+
+            while(*p >= '0' && *p <= '9') {
+
+                long first = strtol(p, &p, 10), last = first;
+
+                if(*p == '-') {
+
+                    last = strtol(p + 1, &p, 10);
+                }
+
+                for(long cpu = first; cpu <= last && cpu < MAX_CPUS; cpu++) {
+
+                    ht_cpu_node[cpu] = (unsigned char) node;
+                }
+
+                if(*p == ',') {
+                    p++;
+                }
+            }
+        }
+
+        fclose(in);
+
+        nodes = node + 1;
+    }
+
+    ht_node_count = nodes;
+}
+
+/// ht_current_node(): the NUMA node of the CPU running the caller
+
+static size_t ht_current_node( void ) {
+
+    int cpu = sched_getcpu();
+
+    return cpu >= 0 && cpu < MAX_CPUS ? ht_cpu_node[cpu] : 0;
+}
+
+/// ht_bind(): set the NUMA policy of a mapping that has no pages yet
+///
+/// mbind is called directly, so libnuma is not needed; a kernel without
+/// NUMA support refuses, and the mapping keeps the default policy
+
+static void ht_bind( void *ptr, size_t length, int node ) {
+
+#ifndef MPOL_BIND
+#define MPOL_BIND 2
+#define MPOL_INTERLEAVE 3
+#endif
+
+    if(node == NODE_ANY || ht_node_count < 2) {
+        return;
+    }
+
+    unsigned long mask = 0;
+
+    if(node == NODE_INTERLEAVE) {
+
+        mask = ht_node_count >= MAX_NODES ? ~0UL : (1UL << ht_node_count) - 1;
+
+    } else {
+
+        mask = 1UL << node;
+    }
+
+    syscall(SYS_mbind, ptr, length, node == NODE_INTERLEAVE ? MPOL_INTERLEAVE : MPOL_BIND,
+        &mask, (unsigned long) MAX_NODES + 1, 0UL);
+}
+
+/// ht_prefault(): fault in every page of a fresh mapping
+///
+/// MADV_POPULATE_WRITE (Linux 5.14) does it in one call; older kernels
+/// get one write per page
+
+static void ht_prefault( void *ptr, size_t length ) {
+
+#ifndef MADV_POPULATE_WRITE
+#define MADV_POPULATE_WRITE 23
+#endif
+
+    if(madvise(ptr, length, MADV_POPULATE_WRITE) == 0) {
+        return;
+    }
+
+    for(size_t offset = 0; offset < length; offset += 4096) {
+
+        ((volatile unsigned char *) ptr)[offset] = 0;
+    }
+}
+
+/// ht_map(): an anonymous, zeroed mapping of at least bytes
+///
+/// the length is rounded up to a whole huge page, and the mapping is
+/// trimmed to start on a huge page boundary, so transparent huge pages
+/// can back all of it.  Returns NULL if the OS refuses
+
+static void *ht_map( size_t bytes, HTHugePages huge_pages, bool populate, int node,
+        size_t *mapping ) {
+
+    size_t length = ht_map_length(bytes);
+
+    if(huge_pages == HT_HUGE_EXPLICIT) {
+
+        void *ptr = mmap(NULL, length, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+
+        if(ptr != MAP_FAILED) {
+
+            ht_bind(ptr, length, node);
+
+            if(populate) {
+
+                ht_prefault(ptr, length);
+            }
+
+            *mapping = length;
+
+            return ptr;
+        }
+    }
+
+    unsigned char *raw = (unsigned char *) mmap(NULL, length + HUGE_PAGE,
+        PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    if(raw == (unsigned char *) MAP_FAILED) {
+        return NULL;
+    }
+
+    unsigned char *start = (unsigned char *)
+        (((uintptr_t) raw + HUGE_PAGE - 1) & ~(uintptr_t) (HUGE_PAGE - 1));
+
+    if(start > raw) {
+
+        munmap(raw, (size_t) (start - raw));
+    }
+
+    size_t tail = (size_t) (raw + length + HUGE_PAGE - (start + length));
+
+    if(tail > 0) {
+
+        munmap(start + length, tail);
+    }
+
+    //advice and policy must come before the first fault to take effect
+
+    if(huge_pages != HT_HUGE_NONE) {
+
+        madvise(start, length, MADV_HUGEPAGE);
+    }
+
+    ht_bind(start, length, node);
+
+    if(populate) {
+
+        ht_prefault(start, length);
+    }
+
+    *mapping = length;
+
+    return start;
+}
+
+/// ht_prepare_main(): the thread that maps the next bucket array
+
+static void *ht_prepare_main( void *arg ) {
+
+    HTPrepared *prepared = (HTPrepared *) arg;
+
+    prepared -> table = ht_map(prepared -> bytes, prepared -> huge_pages, true,
+        prepared -> node, &prepared -> mapping);
+
+    return NULL;
+}
+
+#endif
+
+/// ht_primary_node(): the NUMA policy of the table's own bucket array
+///
+/// a replicating table keeps its primary on node 0, and the other nodes'
+/// copies on those nodes
+
+static int ht_primary_node( const HashADT t ) {
+
+    if(t -> numa == HT_NUMA_INTERLEAVE) {
+        return NODE_INTERLEAVE;
+    }
+
+    return t -> replica_count > 0 ? 0 : NODE_ANY;
+}
+
+/// ht_table_mapped(): whether a bucket array of bytes is mapped from the OS
+
+static bool ht_table_mapped( const HashADT t, size_t bytes ) {
+
+    return HT_MMAP && t -> allocator.alloc == NULL && bytes >= t -> huge_threshold;
+}
+
+/// ht_array_bytes(): the bytes a bucket array of capacity pairs holds
+
+static size_t ht_array_bytes( size_t capacity, size_t mapping ) {
+
+    return mapping > 0 ? mapping : capacity * sizeof(KeyValuePair);
+}
+
+/// ht_new_array_bytes(): the bytes a new bucket array of capacity pairs
+/// will hold, rounded as ht_map() rounds it when it is to be mapped
+
+static size_t ht_new_array_bytes( const HashADT t, size_t capacity ) {
+
+    size_t bytes = capacity * sizeof(KeyValuePair);
+
+    return ht_table_mapped(t, bytes) ? ht_map_length(bytes) : bytes;
+}
+
+/// ht_prepared_bytes(): the bytes of the array being prepared for the
+/// next growth, mapped whole, and its bookkeeping; 0 if there is none
+
+static size_t ht_prepared_bytes( const HashADT t ) {
+
+#if HT_MMAP
+
+    if(t -> prepared != NULL) {
+
+        return sizeof(HTPrepared) + ht_map_length(t -> prepared -> bytes);
+    }
+
+#endif
+
+    (void) t;
+
+    return 0;
+}
+
+/// ht_array_copies(): bucket arrays the table keeps for an array of
+/// bytes, one per node when it replicates arrays that large
+
+static size_t ht_array_copies( const HashADT t, size_t bytes ) {
+
+    return t -> replica_count > 0 && ht_table_mapped(t, bytes) ? t -> replica_count : 1;
+}
+
+/// ht_budget_allows(): whether the table may take on bytes more memory
+
+static bool ht_budget_allows( const HashADT t, size_t bytes ) {
+
+    return t -> memory_budget == 0 || ht_memory_usage(t) + bytes <= t -> memory_budget;
+}
+
+
+/// ht_plan_prefault(): the occupancy at which to prepare the next array
+///
+/// half way from the last growth (load 0.375) to the next (0.75), so the
+/// thread has the time of 3/16 capacity inserts to finish
+
+static void ht_plan_prefault( HashADT t ) {
+
+    t -> prepare_at = SIZE_MAX;
+
+    //a table that grows in place has no use for a second array
+
+    //nor a table whose budget cannot hold it beside the current one
+
+    size_t new_capacity = t -> capacity * RESIZE_FACTOR;
+
+    if(t -> prefault == HT_PREFAULT_BACKGROUND && !t -> grow_in_place
+            && ht_table_mapped(t, new_capacity * sizeof(KeyValuePair))
+            && ht_budget_allows(t, sizeof(HTPrepared) + ht_new_array_bytes(t, new_capacity))) {
+
+        t -> prepare_at = (size_t) (t -> capacity * (LOAD_THRESHOLD * 3 / 4));
+    }
+}
+
+/// ht_prepare(): start a thread mapping the array the next growth needs
+
+static void ht_prepare( HashADT t ) {
+
+    t -> prepare_at = SIZE_MAX;
+
+#if HT_MMAP
+
+    //the budget is weighed again, as the table has taken on pairs since
+
+    size_t new_capacity = t -> capacity * RESIZE_FACTOR;
+
+    if(t -> prepared != NULL
+            || !ht_budget_allows(t, sizeof(HTPrepared) + ht_new_array_bytes(t, new_capacity))) {
+        return;
+    }
+
+    HTPrepared *prepared = (HTPrepared *) malloc(sizeof(HTPrepared));
+
+    if(prepared == NULL) {
+        return;
+    }
+
+    prepared -> bytes = new_capacity * sizeof(KeyValuePair);
+
+    prepared -> huge_pages = t -> huge_pages;
+
+    prepared -> node = ht_primary_node(t);
+
+    prepared -> table = NULL;
+
+    prepared -> mapping = 0;
+
+    //without a thread the growth simply maps its own array
+
+    if(pthread_create(&prepared -> thread, NULL, ht_prepare_main, prepared) != 0) {
+
+        free(prepared);
+
+        return;
+    }
+
+    t -> prepared = prepared;
+
+#endif
+}
+
+/// ht_prepared_take(): wait for the prepared array and take it if it has
+/// the size wanted; NULL if there is none
+
+static KeyValuePair *ht_prepared_take( HashADT t, size_t bytes, size_t *mapping ) {
+
+    KeyValuePair *table = NULL;
+
+#if HT_MMAP
+
+    HTPrepared *prepared = t -> prepared;
+
+    if(prepared == NULL) {
+        return NULL;
+    }
+
+    pthread_join(prepared -> thread, NULL);
+
+    if(prepared -> bytes == bytes) {
+
+        table = (KeyValuePair *) prepared -> table;
+
+        *mapping = prepared -> mapping;
+
+    } else if(prepared -> table != NULL) {
+
+        munmap(prepared -> table, prepared -> mapping);
+    }
+
+    free(prepared);
+
+    t -> prepared = NULL;
+
+#else
+
+    (void) t;
+
+    (void) bytes;
+
+    (void) mapping;
+
+#endif
+
+    return table;
+}
+
+/// ht_table_alloc(): a zeroed bucket array for capacity pairs
+///
+/// mapping is set to the bytes mapped from the OS, or 0 for the heap
+
+static KeyValuePair *ht_table_alloc( HashADT t, size_t capacity, int node, size_t *mapping ) {
+
+    size_t bytes = capacity * sizeof(KeyValuePair);
+
+    *mapping = 0;
+
+#if HT_MMAP
+
+    if(ht_table_mapped(t, bytes)) {
+
+        //a prepared array is always for the primary, never a replica
+
+        KeyValuePair *table = node == ht_primary_node(t) ? ht_prepared_take(t, bytes, mapping) : NULL;
+
+        if(table == NULL) {
+
+            table = (KeyValuePair *) ht_map(bytes, t -> huge_pages,
+                t -> prefault != HT_PREFAULT_NONE, node, mapping);
+        }
+
+        //when the OS refuses a mapping, the heap may still have room
+
+        if(table != NULL) {
+            return table;
+        }
+    }
+
+#endif
+
+    (void) node;
+
+    return (KeyValuePair *) ht_mem_zalloc(&t -> allocator, bytes);
+}
+
+/// ht_table_free(): release a bucket array from ht_table_alloc()
+
+static void ht_table_free( HashADT t, KeyValuePair *table, size_t capacity, size_t mapping ) {
+
+    //the array after the struct goes with the struct
+
+    if(table == ht_inline_table(t)) {
+        return;
+    }
+
+#if HT_MMAP
+
+    if(mapping > 0) {
+
+        munmap(table, mapping);
+
+        return;
+    }
+
+#endif
+
+    (void) mapping;
+
+    ht_mem_free(&t -> allocator, table, capacity * sizeof(KeyValuePair));
+}
+
+/// ht_replicas_free(): release every node's copy but the table itself
+
+static void ht_replicas_free( HashADT t ) {
+
+    for(size_t node = 1; node < t -> replica_count; node++) {
+
+        if(t -> replicas[node] != t -> table) {
+
+            ht_table_free(t, t -> replicas[node], t -> capacity, t -> replica_mappings[node]);
+        }
+
+        t -> replicas[node] = NULL;
+    }
+}
+
+/// ht_replicas_alloc(): an array of capacity buckets on every other node
+/// to copy table into
+///
+/// heap memory cannot be bound to a node, so an array too small to be
+/// mapped is not copied, and every node reads table itself.  Returns
+/// false, with no copy kept and every node reading table, if a copy
+/// cannot be allocated
+
+static bool ht_replicas_alloc( HashADT t, KeyValuePair *table, size_t capacity, size_t mapping ) {
+
+    bool copied = ht_table_mapped(t, capacity * sizeof(KeyValuePair));
+
+    t -> replicas[0] = table;
+
+    t -> replica_mappings[0] = mapping;
+
+    for(size_t node = 1; node < t -> replica_count; node++) {
+
+        t -> replicas[node] = table;
+
+        t -> replica_mappings[node] = 0;
+
+        if(!copied) {
+            continue;
+        }
+
+        size_t copy_mapping;
+
+        KeyValuePair *copy = ht_table_alloc(t, capacity, (int) node, &copy_mapping);
+
+        if(copy == NULL) {
+
+            for(size_t done = 1; done < node; done++) {
+
+                ht_table_free(t, t -> replicas[done], capacity, t -> replica_mappings[done]);
+
+                t -> replicas[done] = table;
+
+                t -> replica_mappings[done] = 0;
+            }
+
+            return false;
+        }
+
+        t -> replicas[node] = copy;
+
+        t -> replica_mappings[node] = copy_mapping;
+    }
+
+    return true;
+}
+
+/// ht_replicas_copy(): copy the bucket array into every node's copy
+
+static void ht_replicas_copy( HashADT t ) {
+
+    for(size_t node = 1; node < t -> replica_count; node++) {
+
+        if(t -> replicas[node] != t -> table) {
+
+            memcpy(t -> replicas[node], t -> table, t -> capacity * sizeof(KeyValuePair));
+        }
+    }
+}
+
+/// ht_replicas_build(): copy the bucket array to memory on every other
+/// node; false, with every node reading the table itself, if a copy
+/// cannot be allocated
+
+static bool ht_replicas_build( HashADT t ) {
+
+    if(!ht_replicas_alloc(t, t -> table, t -> capacity, t -> table_mapping)) {
+        return false;
+    }
+
+    ht_replicas_copy(t);
+
+    return true;
+}
+
+/// ht_replicate(): copy one changed bucket to every node's copy
+
+static void ht_replicate( HashADT t, size_t index ) {
+
+    for(size_t node = 1; node < t -> replica_count; node++) {
+
+        if(t -> replicas[node] != t -> table) {
+
+            t -> replicas[node][index] = t -> table[index];
+        }
+    }
+}
+
+/// ht_local(): the bucket array to read, the copy on the caller's node
+/// for a replicating table
+
+static const KeyValuePair *ht_local( const HashADT t ) {
+
+#if HT_MMAP
+
+    if(t -> replica_count > 0) {
+
+        return t -> replicas[ht_current_node()];
+    }
+
+#endif
+
+    return t -> table;
+}
+
+/// ht_create(): the ADT create function
+///
+/// see headerfile for full documentation
+
+HashADT ht_create(
+    size_t (*hash)( const void *key ),
+    bool (*equals)( const void *key1, const void *key2 ),
+    void (*print)( const void *key, const void *value ),
+    void (*delete)( void *key, void *value )
+) {
+
+    return ht_create_opts(hash, equals, print, delete, NULL);
+
+}
+
+/// ht_create_opts(): the ADT create function with options
+///
+/// see headerfile for full documentation
+
+HashADT ht_create_opts(
+    size_t (*hash)( const void *key ),
+    bool (*equals)( const void *key1, const void *key2 ),
+    void (*print)( const void *key, const void *value ),
+    void (*delete)( void *key, void *value ),
+    const HTOptions *options
+) {
+
+    HTOptions defaults;
+
+    if(options == NULL) {
+
+        ht_options_init(&defaults);
+
+        options = &defaults;
+    }
+
+    //check preconditions: make sure hash, equals and print are not null
+
+    assert(hash != NULL || options -> keyed_hash != NULL);
+
+    assert(equals != NULL);
+
+    assert(print != NULL);
+
+    //keep a copy of the allocator, the client's may not outlive the table
+
+    HTAllocator allocator = { NULL, NULL, NULL, NULL, NULL };
+
+    if(options -> allocator != NULL) {
+
+        assert(options -> allocator -> alloc != NULL && options -> allocator -> free != NULL);
+
+        allocator = *options -> allocator;
+    }
+
+    //a flat table's first bucket array comes in the same block as the
+    //struct, right after it, unless it is to be mapped or replicated
+
+    size_t inline_capacity = INITIAL_CAPACITY;
+
+    size_t threshold = options -> huge_threshold > 0 ? options -> huge_threshold : HUGE_PAGE;
+
+    if(options -> layout != HT_LAYOUT_FLAT || options -> small_capacity > 0
+            || options -> numa == HT_NUMA_REPLICATE
+            || (HT_MMAP && allocator.alloc == NULL && INITIAL_CAPACITY * sizeof(KeyValuePair) >= threshold)) {
+
+        inline_capacity = 0;
+    }
+
+    //create and allocate new structure, cache line aligned and zeroed
+
+    HashADT new;
+
+    new = (HashADT) ht_mem_zalloc(&allocator,
+        ht_header_bytes(options -> small_capacity) + inline_capacity * sizeof(KeyValuePair));
+
+    //assert that the mem alloc worked
+
+    assert(new != NULL);
+
+    new -> allocator = allocator;
+
+    new -> inline_capacity = inline_capacity;
+
+    //set all the tracking fields 
+    new -> capacity = INITIAL_CAPACITY;
+
+    new -> occupancy = 0;
+
+    new -> rehashes = 0;
+
+    new -> reseeds = 0;
+
+    new -> evictions = 0;
+
+    new -> rehash_ns = 0;
+
+#if HASHADT_STATS
+
+    new -> collisions = 0;
+
+    new -> lookups = 0;
+
+    new -> hits = 0;
+
+    new -> misses = 0;
+
+    new -> inserts = 0;
+
+    new -> updates = 0;
+
+#endif
+
+    //pick the seed
+
+    new -> seed_mode = options -> seed_mode;
+
+    if(options -> seed_mode == HT_SEED_RANDOM) {
+
+        new -> seed = ht_random_seed();
+
+    } else if(options -> seed_mode == HT_SEED_FIXED) {
+
+        new -> seed = options -> seed;
+
+    } else {
+
+        new -> seed = 0;
+    }
+
+    new -> auto_probe = options -> max_probe == 0;
+
+    new -> max_probe = new -> auto_probe ?
+        ht_probe_bound(INITIAL_CAPACITY) : options -> max_probe;
+
+    //set the custom functions to be used by this hashtable
+
+    new -> hash_fcn = hash;
+
+    new -> keyed_hash_fcn = options -> keyed_hash;
+
+    new -> equals_fcn = equals;
+
+    new -> print_fcn = print;
+
+    new -> delete_fcn = delete;
+
+    new -> huge_pages = options -> huge_pages;
+
+    new -> huge_threshold = options -> huge_threshold > 0 ? options -> huge_threshold : HUGE_PAGE;
+
+    new -> prefault = options -> prefault;
+
+    new -> prepared = NULL;
+
+    new -> grow_in_place = options -> grow_in_place;
+
+    //placement is about the flat bucket array
+
+    new -> numa = options -> layout == HT_LAYOUT_FLAT ? options -> numa : HT_NUMA_DEFAULT;
+
+    new -> replica_count = 0;
+
+    new -> replicas = NULL;
+
+    new -> replica_mappings = NULL;
+
+#if HT_MMAP
+
+    if(new -> numa != HT_NUMA_DEFAULT) {
+
+        ht_numa_init();
+    }
+
+    //one node has nothing to replicate to
+
+    if(new -> numa == HT_NUMA_REPLICATE && ht_node_count > 1) {
+
+        new -> replica_count = ht_node_count;
+
+        new -> replicas = (KeyValuePair**)ht_mem_alloc(&new -> allocator,
+            ht_node_count * sizeof(KeyValuePair*));
+
+        new -> replica_mappings = (size_t*)ht_mem_alloc(&new -> allocator,
+            ht_node_count * sizeof(size_t));
+
+        assert(new -> replicas != NULL && new -> replica_mappings != NULL);
+    }
+
+#endif
+
+    new -> slabs = NULL;
+
+    new -> slab_bytes = 0;
+
+    new -> layout_bytes = 0;
+
+    new -> pair_bytes_fcn = options -> pair_bytes;
+
+    new -> pair_bytes = 0;
+
+    //the budget is checked where the flat bucket array grows
+
+    assert(options -> memory_budget == 0 || options -> layout == HT_LAYOUT_FLAT);
+
+    new -> memory_budget = options -> memory_budget;
+
+    new -> budget_policy = options -> budget_policy;
+
+    new -> evict_hand = 0;
+
+    new -> error = HT_OK;
+
+    new -> trace = NULL;
+
+    //other layouts keep their own storage
+
+    new -> layout = NULL;
+
+    new -> layout_state = NULL;
+
+    if(options -> layout == HT_LAYOUT_SEGMENTED) {
+
+        new -> layout = &ht_layout_segmented;
+
+    } else if(options -> layout == HT_LAYOUT_SOA) {
+
+        new -> layout = &ht_layout_soa;
+
+    } else if(options -> layout == HT_LAYOUT_COMPACT) {
+
+        new -> layout = &ht_layout_compact;
+    }
+
+    //only the SoA layout has room for copied values
+
+    assert(options -> value_size == 0
+        || (options -> layout == HT_LAYOUT_SOA && options -> small_capacity == 0));
+
+    new -> value_size = options -> value_size;
+
+    //a small table makes its storage when it outgrows the inline pairs
+
+    new -> small = options -> small_capacity > 0;
+
+    new -> small_capacity = options -> small_capacity;
+
+    new -> small_pairs = (KeyValuePair *) (new -> small_hashes + new -> small_capacity);
+
+    if(new -> small || new -> layout != NULL) {
+
+        new -> capacity = 0;
+
+        new -> table = NULL;
+
+        new -> table_mapping = 0;
+
+        new -> prepare_at = SIZE_MAX;
+
+        if(!new -> small) {
+
+            new -> layout_state = new -> layout -> create(new);
+        }
+
+        return new;
+    }
+
+    //allocate memory for the table of key value pairs using init capacity
+
+    new -> table = ht_inline_table(new);
+
+    new -> table_mapping = 0;
+
+    if(new -> table == NULL) {
+
+        new -> table = ht_table_alloc(new, INITIAL_CAPACITY, ht_primary_node(new), &new -> table_mapping);
+    }
+
+    //assert that table alloc was completed
+
+    assert(new -> table != NULL);
+
+    //the first array is too small to copy, so every node reads it
+
+    if(new -> replica_count > 0) {
+
+        ht_replicas_build(new);
+    }
+
+    ht_plan_prefault(new);
+
+    return new;
+
+}
+
+/// ht_hash(): the hash of a key with the table seed applied
+
+static size_t ht_hash( const HashADT t, const void *key ) {
+
+    if(t -> keyed_hash_fcn != NULL) {
+
+        //the keyed hash already depends on the seed
+
+        return t -> keyed_hash_fcn(key, t -> seed);
+
+    } else if(t -> seed_mode == HT_SEED_NONE) {
+
+        return t -> hash_fcn(key);
+    }
+
+    //mixing spreads distinct hash values unpredictably
+
+    return (size_t) ht_mix64((uint64_t) t -> hash_fcn(key) ^ t -> seed);
+}
+
+/// ht_home(): the bucket a key hashes to, with the table seed applied
+
+static size_t ht_home( const HashADT t, const void *key ) {
+
+    //capacity is a power of two, so the mask is hash % capacity
+
+    return ht_hash(t, key) & (t -> capacity - 1);
+}
+
+/// ht_now_ns(): monotonic clock in nanoseconds, for timing rehashes
+
+static uint64_t ht_now_ns( void ) {
+
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t) now.tv_sec * 1000000000u + (uint64_t) now.tv_nsec;
+}
+
+/// ht_layout_hash(): the mixed hash layouts place keys by
+///
+/// see HTLayout.h for full documentation
+
+uint64_t ht_layout_hash( const HashADT t, const void *key ) {
+
+    if(t -> keyed_hash_fcn != NULL) {
+
+        return (uint64_t) t -> keyed_hash_fcn(key, t -> seed);
+    }
+
+    return ht_mix64((uint64_t) t -> hash_fcn(key) ^ t -> seed);
+}
+
+/// ht_layout_equals(): the client's key equality
+///
+/// see HTLayout.h for full documentation
+
+bool ht_layout_equals( const HashADT t, const void *key1, const void *key2 ) {
+
+    return t -> equals_fcn(key1, key2);
+}
+
+/// ht_layout_value_size(): bytes of each copied value
+///
+/// see HTLayout.h for full documentation
+
+size_t ht_layout_value_size( const HashADT t ) {
+
+    return t -> value_size;
+}
+
+/// ht_layout_alloc(): memory for a layout from the table's allocator
+///
+/// see HTLayout.h for full documentation
+
+void *ht_layout_alloc( const HashADT t, size_t size ) {
+
+    void *ptr = ht_mem_alloc(&t -> allocator, size);
+
+    if(ptr != NULL) {
+
+        t -> layout_bytes += size;
+    }
+
+    return ptr;
+}
+
+/// ht_layout_realloc(): resize memory from ht_layout_alloc()
+///
+/// see HTLayout.h for full documentation
+
+void *ht_layout_realloc( const HashADT t, void *ptr, size_t old_size, size_t new_size ) {
+
+    void *resized = NULL;
+
+    if(t -> allocator.alloc == NULL) {
+
+        resized = realloc(ptr, new_size);
+
+    } else if(t -> allocator.realloc != NULL) {
+
+        resized = t -> allocator.realloc(t -> allocator.context, ptr, old_size, new_size);
+    }
+
+    //no hook, or it declined: move the block by hand
+
+    if(resized == NULL && t -> allocator.alloc != NULL) {
+
+        resized = ht_mem_alloc(&t -> allocator, new_size);
+
+        if(resized != NULL) {
+
+            memcpy(resized, ptr, old_size < new_size ? old_size : new_size);
+
+            ht_mem_free(&t -> allocator, ptr, old_size);
+        }
+    }
+
+    if(resized != NULL) {
+
+        t -> layout_bytes += new_size - old_size;
+    }
+
+    return resized;
+}
+
+/// ht_layout_free(): return memory from ht_layout_alloc()
+///
+/// see HTLayout.h for full documentation
+
+void ht_layout_free( const HashADT t, void *ptr, size_t size ) {
+
+    if(ptr != NULL) {
+
+        t -> layout_bytes -= size;
+    }
+
+    ht_mem_free(&t -> allocator, ptr, size);
+}
+
+/// ht_layout_rehashed(): count a layout's partial rehash
+///
+/// see HTLayout.h for full documentation
+
+void ht_layout_rehashed( HashADT t, uint64_t ns ) {
+
+    t -> rehashes++;
+
+    t -> rehash_ns += ns;
+}
+
+/// ht_layout_collisions(): count a layout's probes
+///
+/// see HTLayout.h for full documentation
+
+void ht_layout_collisions( const HashADT t, uint64_t probes ) {
+
+#if HASHADT_STATS
+
+    t -> collisions += probes;
+
+#else
+
+    (void) t;
+
+    (void) probes;
+
+#endif
+}
+
+/// ht_layout_now_ns(): the clock rehashes are timed with
+///
+/// see HTLayout.h for full documentation
+
+uint64_t ht_layout_now_ns( void ) {
+
+    return ht_now_ns();
+}
+
+/// What ht_visit_*() callbacks of a layout's each() work on
+
+typedef struct HTVisit {
+
+    HashADT t;
+
+    void **array;
+
+    size_t count;
+
+} HTVisit;
+
+/// ht_visit_delete(): call the delete fcn on a pair
+
+static void ht_visit_delete( void *context, void *key, void *value ) {
+
+    HTVisit *visit = (HTVisit *) context;
+
+    visit -> t -> delete_fcn(key, value);
+}
+
+/// ht_visit_print(): print a pair as ht_dump() does, numbered in order
+
+static void ht_visit_print( void *context, void *key, void *value ) {
+
+    HTVisit *visit = (HTVisit *) context;
+
+    printf("%zu: (", visit -> count++);
+
+    visit -> t -> print_fcn(key, value);
+
+    printf(")\n");
+}
+
+/// ht_visit_key(): append a key to the array
+
+static void ht_visit_key( void *context, void *key, void *value ) {
+
+    HTVisit *visit = (HTVisit *) context;
+
+    (void) value;
+
+    visit -> array[visit -> count++] = key;
+}
+
+/// ht_visit_value(): append a non-null value to the array, as
+/// ht_values() does for flat tables
+
+static void ht_visit_value( void *context, void *key, void *value ) {
+
+    HTVisit *visit = (HTVisit *) context;
+
+    (void) key;
+
+    if(value != NULL) {
+
+        visit -> array[visit -> count++] = value;
+    }
+}
+
+/// ht_resize_in_place(): resize the bucket array where it lies and
+/// re-place every pair inside it, false if it cannot be resized there
+///
+/// mapped arrays are resized with mremap, and arrays from an allocator
+/// with a realloc hook with that.  A bitmap marks buckets whose pair has
+/// been placed.  Each unplaced pair is taken out and walked from its new
+/// home past placed buckets; it lands in the first empty bucket, or
+/// swaps with the unplaced pair it finds and that pair walks on.  Placed
+/// pairs never move again, so every bucket between a pair's home and its
+/// bucket ends up occupied, which is all linear probing needs.  The first
+/// bucket array, after the struct and unused once outgrown, holds the
+/// bitmap when it fits
+
+static bool ht_resize_in_place( HashADT t, size_t new_capacity ) {
+
+    //the array after the struct cannot move without moving the handle
+
+    if(t -> table == ht_inline_table(t)) {
+        return false;
+    }
+
+    size_t old_bytes = t -> capacity * sizeof(KeyValuePair);
+
+    size_t new_bytes = new_capacity * sizeof(KeyValuePair);
+
+    size_t words = (new_capacity + 63) / 64;
+
+    //the bitmap first, so running out of memory leaves the table as it was
+
+    bool spare = words * sizeof(uint64_t) <= t -> inline_capacity * sizeof(KeyValuePair);
+
+    uint64_t *placed = spare ? (uint64_t*)ht_inline_table(t)
+        : (uint64_t*)ht_mem_alloc(&t -> allocator, words * sizeof(uint64_t));
+
+    if(placed == NULL) {
+        return false;
+    }
+
+    KeyValuePair *table = t -> table;
+
+    size_t mapping = t -> table_mapping;
+
+    if(new_bytes != old_bytes) {
+
+        table = NULL;
+
+#if HT_MMAP
+
+        if(mapping > 0) {
+
+            //mremap extends with zero pages, moving the mapping if it must
+
+            size_t length = (new_bytes + HUGE_PAGE - 1) & ~(HUGE_PAGE - 1);
+
+            void *ptr = mremap(t -> table, mapping, length, MREMAP_MAYMOVE);
+
+            if(ptr != MAP_FAILED) {
+
+                table = (KeyValuePair *) ptr;
+
+                mapping = length;
+            }
+
+        } else
+
+#endif
+
+        if(t -> allocator.alloc != NULL && t -> allocator.realloc != NULL) {
+
+            table = (KeyValuePair *) t -> allocator.realloc(t -> allocator.context,
+                t -> table, old_bytes, new_bytes);
+
+            if(table != NULL) {
+
+                memset((unsigned char *) table + old_bytes, 0, new_bytes - old_bytes);
+            }
+        }
+
+        if(table == NULL) {
+
+            if(!spare) {
+                ht_mem_free(&t -> allocator, placed, words * sizeof(uint64_t));
+            }
+
+            return false;
+        }
+    }
+
+    memset(placed, 0, words * sizeof(uint64_t));
+
+    t -> table = table;
+
+    t -> table_mapping = mapping;
+
+    t -> capacity = new_capacity;
+
+    size_t mask = new_capacity - 1;
+
+    for(size_t i = 0; i < new_capacity; i++) {
+
+        if(table[i].key == NULL || (placed[i / 64] >> (i % 64)) & 1) {
+            continue;
+        }
+
+        KeyValuePair pair = table[i];
+
+        table[i].key = NULL;
+
+        table[i].value = NULL;
+
+        //walk pairs until one lands in an empty bucket
+
+        while(pair.key != NULL) {
+
+            size_t index = ht_home(t, pair.key);
+
+            while(table[index].key != NULL && (placed[index / 64] >> (index % 64)) & 1) {
+
+                index = (index + 1) & mask;
+
+                HT_COUNT(t -> collisions);
+            }
+
+            KeyValuePair evicted = table[index];
+
+            table[index] = pair;
+
+            placed[index / 64] |= (uint64_t) 1 << (index % 64);
+
+            pair = evicted;
+        }
+    }
+
+    if(!spare) {
+        ht_mem_free(&t -> allocator, placed, words * sizeof(uint64_t));
+    }
+
+    return true;
+}
+
+/// ht_rehash(): move every pair into a new array of new_capacity buckets
+///
+/// tables that grow in place try to reuse their array first.  Returns
+/// false, with the table as it was, if there is no memory for the array
+
+static bool ht_rehash( HashADT t, size_t new_capacity ) {
+
+    uint64_t start = ht_now_ns();
+
+    //the other nodes' copies are made for the new table before pairs
+    //move, and filled afterwards.  A replicating table never resizes in
+    //place, since its copies could not follow
+
+    ht_replicas_free(t);
+
+    if(t -> replica_count > 0 || !t -> grow_in_place || !ht_resize_in_place(t, new_capacity)) {
+
+        size_t new_mapping;
+
+        KeyValuePair* new_table = ht_table_alloc(t, new_capacity, ht_primary_node(t), &new_mapping);
+
+        //out of memory for the array or a copy: put back the other nodes'
+        //copies (every node reads the table if even those cannot be had),
+        //and the table carries on at its old capacity
+
+        if(new_table == NULL || (t -> replica_count > 0
+                && !ht_replicas_alloc(t, new_table, new_capacity, new_mapping))) {
+
+            if(new_table != NULL) {
+
+                ht_table_free(t, new_table, new_capacity, new_mapping);
+            }
+
+            if(t -> replica_count > 0) {
+
+                ht_replicas_build(t);
+            }
+
+            return false;
+        }
+
+        //store the old table data
+
+        KeyValuePair* old_table = t -> table;
+
+        size_t old_capacity = t -> capacity;
+
+        size_t old_mapping = t -> table_mapping;
+
+        //update to new capacity 
+        t -> capacity = new_capacity;
+
+        //iterate through the old table and update the new table
+
+        for(size_t i = 0; i < old_capacity; i++){
+
+            KeyValuePair pair = old_table[i];
+
+            //if it is empty we do not care
+
+            if(pair.key == NULL){
+                continue;
+            }
+
+            //rehash the key with new capacity, linear probe past collisions
+
+            size_t index = ht_home(t, pair.key);
+
+            while(new_table[index].key != NULL) {
+
+                index = (index + 1) & (t -> capacity - 1);
+
+                //update collision counter for each collision
+
+                HT_COUNT(t -> collisions);
+            }
+
+            new_table[index] = pair;
+        }
+
+        //table finished rehashing, update new table
+
+        t -> table = new_table;
+
+        t -> table_mapping = new_mapping;
+
+        //free the old table
+
+        ht_table_free(t, old_table, old_capacity, old_mapping);
+    }
+
+    if(t -> auto_probe) {
+
+        t -> max_probe = ht_probe_bound(new_capacity) << t -> reseeds;
+    }
+
+    if(t -> replica_count > 0) {
+
+        ht_replicas_copy(t);
+    }
+
+    ht_plan_prefault(t);
+
+    t -> rehash_ns += ht_now_ns() - start;
+
+    return true;
+}
+
+/// ht_reseed(): respond to a flooding attack
+///
+/// picks a fresh random seed and rehashes at the same capacity.  Each
+/// reseed doubles max_probe, so keys whose hash values are fully equal
+/// (which no seed separates without a keyed hash) cannot loop reseeding
+
+static void ht_reseed( HashADT t ) {
+
+    HTSeedMode seed_mode = t -> seed_mode;
+
+    uint64_t seed = t -> seed;
+
+    t -> seed_mode = HT_SEED_RANDOM;
+
+    t -> seed = ht_random_seed();
+
+    t -> reseeds++;
+
+    if(!t -> auto_probe) {
+
+        t -> max_probe *= 2;
+    }
+
+    //without memory for the new array, or room in the budget to hold it
+    //beside the old one while pairs move, the pairs stay where the old
+    //seed put them
+
+    size_t array_bytes = ht_array_copies(t, t -> capacity * sizeof(KeyValuePair))
+        * ht_new_array_bytes(t, t -> capacity);
+
+    if(!ht_budget_allows(t, array_bytes) || !ht_rehash(t, t -> capacity)) {
+
+        t -> seed_mode = seed_mode;
+
+        t -> seed = seed;
+
+        t -> reseeds--;
+    }
+}
+
+/// ht_destroy(): the destroy fcn, calls destroy
+///
+/// see headerfile for full documentation
+
+void ht_destroy( HashADT t) {
+
+    // assert that the ADT is not null
+    
+    assert(t != NULL);
+
+    ht_trace_stop(t);
+
+    HTVisit visit = { t, NULL, 0 };
+
+    if(t -> small && t -> delete_fcn != NULL) {
+
+        for(size_t i = 0; i < t -> occupancy; i++) {
+
+            t -> delete_fcn(t -> small_pairs[i].key, t -> small_pairs[i].value);
+        }
+
+    } else if(t -> layout != NULL && t -> delete_fcn != NULL) {
+
+        t -> layout -> each(t, t -> layout_state, ht_visit_delete, &visit);
+    }
+
+    if(t -> layout_state != NULL) {
+
+        t -> layout -> destroy(t, t -> layout_state);
+    }
+    
+    // deallocate any dynamic storage
+    // if delete fcn != NULL, use to deallocate each pair in table
+    
+    if (t -> delete_fcn != NULL) {
+        
+        //use the given delete fcn to free the key value pairs
+        for(size_t i = 0; i < t -> capacity; i++){
+            
+            KeyValuePair pair = t -> table[i];
+            
+            if(pair.key != NULL) {
+                t -> delete_fcn(pair.key, pair.value);
+            }
+        }
+
+    } 
+    
+    //free the slabs of copied keys and values, the table and hashtable itself
+
+    while(t -> slabs != NULL) {
+
+        HTSlab *next = t -> slabs -> next;
+
+        ht_mem_free(&t -> allocator, t -> slabs, sizeof(HTSlab) + t -> slabs -> size);
+
+        t -> slabs = next;
+    }
+
+    //a table destroyed while preparing its next array waits for the
+    //thread; no array has 0 bytes, so the prepared one is discarded
+
+    size_t unused;
+
+    ht_prepared_take(t, 0, &unused);
+
+    //a small table never built its replicas
+
+    if(t -> table != NULL) {
+
+        ht_replicas_free(t);
+    }
+
+    ht_mem_free(&t -> allocator, t -> replicas, t -> replica_count * sizeof(KeyValuePair*));
+
+    ht_mem_free(&t -> allocator, t -> replica_mappings, t -> replica_count * sizeof(size_t));
+
+    if(t -> table != NULL) {
+
+        ht_table_free(t, t -> table, t -> capacity, t -> table_mapping);
+    }
+
+    //the allocator lives in the table, so free the table from a copy
+
+    HTAllocator allocator = t -> allocator;
+
+    ht_mem_free(&allocator, t, ht_block_bytes(t));
+
+}
+
+/// ht_dump() prints info about the table
+///
+/// see headerfile for full documentation
+
+void ht_dump(const HashADT t, bool contents) {
+    
+    //print out all info about table
+
+    printf("Size: %zu\n",t -> occupancy);
+
+    if(t -> small || t -> layout != NULL) {
+
+        //a layout's buckets are spread out, ht_stats() adds them up
+
+        HTStats stats;
+
+        ht_stats(t, &stats);
+
+        printf("Capacity: %" PRIu64 "\n", stats.capacity);
+
+    } else {
+
+        printf("Capacity: %zu\n", t -> capacity);
+    }
+
+#if HASHADT_STATS
+
+    printf("Collisions: %" PRIu64 "\n", t -> collisions);
+
+#endif
+
+    printf("Rehashes: %" PRIu64 "\n", t -> rehashes);
+
+    //if contents true print the contents using print fcn
+
+    if(contents && t -> small) {
+
+        for(size_t i = 0; i < t -> occupancy; i++) {
+
+            printf("%zu: (", i);
+
+            t -> print_fcn(t -> small_pairs[i].key, t -> small_pairs[i].value);
+
+            printf(")\n");
+        }
+
+    } else if(contents && t -> layout != NULL) {
+
+        HTVisit visit = { t, NULL, 0 };
+
+        t -> layout -> each(t, t -> layout_state, ht_visit_print, &visit);
+
+    } else if(contents) {
+        
+        for(size_t i = 0; i < t -> capacity; i++){
+            
+            //get the key value of each bucket
+
+            KeyValuePair pair = t -> table[i];
+            
+            //check if key value pair is null
+            if(pair.key == NULL) {
+                
+                printf("%zu: null\n",i);
+
+            } else {
+
+                printf("%zu: (", i);
+
+                t -> print_fcn(pair.key, pair.value);
+
+                printf(")\n");
+            }
+        }
+    }
+
+}
+
+/// ht_find(): locate the bucket holding key
+///
+/// returns t -> capacity if the key is not in the table
+
+static size_t ht_find( const HashADT t, const KeyValuePair *table, const void *key ) {
+
+    //get index of the key's hash value
+
+    size_t orig_index = ht_home(t, key);
+
+    //set index to the starting index
+
+    size_t index = orig_index;
+
+    HT_COUNT(t -> lookups);
+
+    //check at the designated hashcode spot
+    do{
+
+        KeyValuePair pair = table[index];
+            
+        if(pair.key == NULL) {
+            //hit an empty bucket meaing we are done
+
+            break;
+        }
+        
+
+        if(t->equals_fcn(key,pair.key)) {
+
+            HT_COUNT(t -> hits);
+            
+            return index;
+        }
+
+        // a collision has occured
+
+        //recalculate the new index
+        index = (index + 1) & (t -> capacity - 1);
+        
+        //increase collision counter only if collision has occurred
+        HT_COUNT(t -> collisions);
+        
+    } while(index != orig_index);
+
+    HT_COUNT(t -> misses);
+
+    return t -> capacity;
+
+}
+
+/// ht_stats_bucket(): the log2 histogram bucket a value falls in
+
+static size_t ht_stats_bucket( uint64_t value ) {
+
+    size_t bucket = 0;
+
+    while(value > 0 && bucket < HT_STATS_BUCKETS - 1) {
+
+        value >>= 1;
+
+        bucket++;
+    }
+
+    return bucket;
+}
+
+/// ht_stats(): collect statistics about the table
+///
+/// see headerfile for full documentation
+
+void ht_stats( const HashADT t, HTStats *stats ) {
+
+    assert(t != NULL && stats != NULL);
+
+    //copy the running counters
+
+    stats -> size = t -> occupancy;
+
+    stats -> capacity = t -> capacity;
+
+#if HASHADT_STATS
+
+    stats -> counters = true;
+
+    stats -> lookups = t -> lookups;
+
+    stats -> hits = t -> hits;
+
+    stats -> misses = t -> misses;
+
+    stats -> inserts = t -> inserts;
+
+    stats -> updates = t -> updates;
+
+    stats -> collisions = t -> collisions;
+
+#else
+
+    stats -> counters = false;
+
+    stats -> lookups = stats -> hits = stats -> misses = 0;
+
+    stats -> inserts = stats -> updates = stats -> collisions = 0;
+
+#endif
+
+    stats -> rehashes = t -> rehashes;
+
+    stats -> reseeds = t -> reseeds;
+
+    stats -> evictions = t -> evictions;
+
+    stats -> rehash_ns = t -> rehash_ns;
+
+    //the struct, then every bucket array but the one after it (counted
+    //with the struct), on every node, as ht_memory_usage() counts them
+
+    stats -> bytes_used = ht_block_bytes(t) + t -> replica_count * (sizeof(KeyValuePair *) + sizeof(size_t));
+
+    if(t -> table != NULL) {
+
+        if(t -> table != ht_inline_table(t)) {
+
+            stats -> bytes_used += ht_array_bytes(t -> capacity, t -> table_mapping);
+        }
+
+        for(size_t node = 1; node < t -> replica_count; node++) {
+
+            if(t -> replicas[node] != t -> table) {
+
+                stats -> bytes_used += ht_array_bytes(t -> capacity, t -> replica_mappings[node]);
+            }
+        }
+    }
+
+    stats -> arena_bytes = t -> slab_bytes;
+
+    for(size_t i = 0; i < HT_STATS_BUCKETS; i++) {
+
+        stats -> probe_histogram[i] = 0;
+
+        stats -> cluster_histogram[i] = 0;
+    }
+
+    if(t -> small) {
+
+        //a scan steps over every pair before the one it finds, and the
+        //pairs are one packed run
+
+        stats -> capacity = t -> small_capacity;
+
+        stats -> max_probe = t -> occupancy > 0 ? t -> occupancy - 1 : 0;
+
+        stats -> mean_probe = t -> occupancy > 0 ? (t -> occupancy - 1) / 2.0 : 0.0;
+
+        for(size_t i = 0; i < t -> occupancy; i++) {
+
+            stats -> probe_histogram[ht_stats_bucket(i)]++;
+        }
+
+        if(t -> occupancy > 0) {
+
+            stats -> cluster_histogram[ht_stats_bucket(t -> occupancy)]++;
+        }
+
+        return;
+    }
+
+    if(t -> layout != NULL) {
+
+        t -> layout -> stats(t, t -> layout_state, stats);
+
+        stats -> bytes_used += ht_block_bytes(t);
+
+        return;
+    }
+
+    //scan for each key's distance from home and for runs of occupied buckets
+
+    uint64_t total = 0;
+
+    stats -> max_probe = 0;
+
+    //a run that wraps past the end belongs to the run at the start, so
+    //scanning begins just after an empty bucket
+
+    size_t start = 0;
+
+    while(start < t -> capacity && t -> table[start].key != NULL) {
+
+        start++;
+    }
+
+    uint64_t run = 0;
+
+    for(size_t n = 1; n <= t -> capacity; n++) {
+
+        size_t i = (start + n) % t -> capacity;
+
+        KeyValuePair pair = t -> table[i];
+
+        if(pair.key == NULL) {
+
+            if(run > 0) {
+
+                stats -> cluster_histogram[ht_stats_bucket(run)]++;
+            }
+
+            run = 0;
+
+            continue;
+        }
+
+        run++;
+
+        size_t home = ht_home(t, pair.key);
+
+        uint64_t distance = (i + t -> capacity - home) % t -> capacity;
+
+        stats -> probe_histogram[ht_stats_bucket(distance)]++;
+
+        total += distance;
+
+        if(distance > stats -> max_probe) {
+
+            stats -> max_probe = distance;
+        }
+    }
+
+    if(run > 0) {
+
+        stats -> cluster_histogram[ht_stats_bucket(run)]++;
+    }
+
+    stats -> mean_probe = t -> occupancy > 0 ? (double) total / t -> occupancy : 0.0;
+}
+
+/// ht_rehash_count(): rehashes for growth or reseeding so far
+///
+/// see headerfile for full documentation
+
+uint64_t ht_rehash_count( const HashADT t ) {
+
+    return t -> rehashes + t -> reseeds;
+
+}
+
+/// ht_memory_usage(): bytes held by the table
+///
+/// see headerfile for full documentation
+
+size_t ht_memory_usage( const HashADT t ) {
+
+    assert(t != NULL);
+
+    //the struct with its inline pairs or array, the layout's storage, the
+    //slabs and what the client reports for its pairs
+
+    uint64_t bytes = ht_block_bytes(t) + t -> layout_bytes + t -> slab_bytes + t -> pair_bytes;
+
+    //every bucket array but the one after the struct, on every node
+
+    if(t -> table != NULL) {
+
+        if(t -> table != ht_inline_table(t)) {
+
+            bytes += ht_array_bytes(t -> capacity, t -> table_mapping);
+        }
+
+        for(size_t node = 1; node < t -> replica_count; node++) {
+
+            if(t -> replicas[node] != t -> table) {
+
+                bytes += ht_array_bytes(t -> capacity, t -> replica_mappings[node]);
+            }
+        }
+    }
+
+    bytes += t -> replica_count * (sizeof(KeyValuePair *) + sizeof(size_t));
+
+    //the array being faulted in ahead of the next growth
+
+    bytes += ht_prepared_bytes(t);
+
+    if(t -> trace != NULL) {
+
+        bytes += sizeof(HTTrace) + t -> trace -> size;
+    }
+
+    return (size_t) bytes;
+}
+
+/// ht_error(): why the last put stored nothing
+///
+/// see headerfile for full documentation
+
+HTError ht_error( const HashADT t ) {
+
+    assert(t != NULL);
+
+    return t -> error;
+}
+
+/// ht_trace_flush(): write the buffered trace records to the file
+
+static void ht_trace_flush( HTTrace *trace ) {
+
+    if(trace -> used > 0 && fwrite(trace -> buffer, 1, trace -> used, trace -> file) != trace -> used) {
+
+        trace -> ok = false;
+    }
+
+    trace -> used = 0;
+}
+
+/// ht_trace_start(): begin recording operations to a file
+///
+/// see headerfile for full documentation
+
+bool ht_trace_start(
+    HashADT t,
+    const char *path,
+    size_t (*key_bytes)( const void *key, void *buffer, size_t room ),
+    size_t buffer_bytes
+) {
+
+    assert(t != NULL && path != NULL && t -> trace == NULL);
+
+    //the buffer must hold at least one record of the longest key
+
+    if(buffer_bytes == 0) {
+
+        buffer_bytes = (size_t) 1 << 20;
+    }
+
+    if(buffer_bytes < sizeof(HTTraceRecord) + HT_TRACE_MAX_KEY) {
+
+        buffer_bytes = sizeof(HTTraceRecord) + HT_TRACE_MAX_KEY;
+    }
+
+    FILE *file = fopen(path, "wb");
+
+    if(file == NULL) {
+        return false;
+    }
+
+    HTTrace *trace = (HTTrace*)ht_mem_alloc(&t -> allocator, sizeof(HTTrace));
+
+    assert(trace != NULL);
+
+    trace -> buffer = (unsigned char*)ht_mem_alloc(&t -> allocator, buffer_bytes);
+
+    assert(trace -> buffer != NULL);
+
+    trace -> file = file;
+
+    trace -> size = buffer_bytes;
+
+    trace -> used = 0;
+
+    trace -> key_bytes = key_bytes;
+
+    trace -> start_ns = ht_now_ns();
+
+    HTTraceHeader header;
+
+    header.byte_order = 0x01020304;
+
+    header.record_size = sizeof(HTTraceRecord);
+
+    header.flags = key_bytes != NULL ? HT_TRACE_KEY_BYTES : 0;
+
+    header.reserved = 0;
+
+    header.start_ns = trace -> start_ns;
+
+    trace -> ok = fwrite(HT_TRACE_MAGIC, 1, 8, file) == 8
+        && fwrite(&header, sizeof(header), 1, file) == 1;
+
+    t -> trace = trace;
+
+    return true;
+}
+
+/// ht_trace_stop(): flush and close the trace
+///
+/// see headerfile for full documentation
+
+bool ht_trace_stop( HashADT t ) {
+
+    assert(t != NULL);
+
+    HTTrace *trace = t -> trace;
+
+    if(trace == NULL) {
+        return true;
+    }
+
+    ht_trace_flush(trace);
+
+    bool ok = fclose(trace -> file) == 0 && trace -> ok;
+
+    ht_mem_free(&t -> allocator, trace -> buffer, trace -> size);
+
+    ht_mem_free(&t -> allocator, trace, sizeof(HTTrace));
+
+    t -> trace = NULL;
+
+    return ok;
+}
+
+/// ht_trace_record(): append one operation to the table's trace
+
+static void ht_trace_record( const HashADT t, HTTraceOp op, const void *key, bool found ) {
+
+    HTTrace *trace = t -> trace;
+
+    HTTraceRecord record;
+
+    unsigned char key_buffer[HT_TRACE_MAX_KEY];
+
+    size_t length = 0;
+
+    record.ns = ht_now_ns() - trace -> start_ns;
+
+    //the unseeded hash, so the same key has the same id in every run
+
+    record.hash = t -> hash_fcn != NULL
+        ? (uint64_t) t -> hash_fcn(key) : (uint64_t) t -> keyed_hash_fcn(key, 0);
+
+    record.op = (uint8_t) op;
+
+    record.flags = found ? HT_TRACE_FOUND : 0;
+
+    record.reserved = 0;
+
+    if(trace -> key_bytes != NULL) {
+
+        length = trace -> key_bytes(key, key_buffer, HT_TRACE_MAX_KEY);
+
+        if(length > HT_TRACE_MAX_KEY) {
+
+            length = HT_TRACE_MAX_KEY;
+
+            record.flags |= HT_TRACE_TRUNCATED;
+        }
+    }
+
+    record.key_length = (uint16_t) length;
+
+    if(trace -> used + sizeof(record) + length > trace -> size) {
+
+        ht_trace_flush(trace);
+    }
+
+    memcpy(trace -> buffer + trace -> used, &record, sizeof(record));
+
+    memcpy(trace -> buffer + trace -> used + sizeof(record), key_buffer, length);
+
+    trace -> used += sizeof(record) + length;
+}
+
+/// ht_layout_find(): look a key up in a layout, counting as ht_find() does
+
+static bool ht_layout_find( const HashADT t, const void *key, const void **value ) {
+
+    HT_COUNT(t -> lookups);
+
+    bool found = t -> layout -> find(t, t -> layout_state, key, value);
+
+    if(found) {
+
+        HT_COUNT(t -> hits);
+
+    } else {
+
+        HT_COUNT(t -> misses);
+    }
+
+    return found;
+}
+
+/// ht_grow(): double the bucket array for the next insert
+///
+/// the budget is weighed against the table once grown, not the moment
+/// both arrays are held while pairs move, with arrays counted as
+/// ht_memory_usage() counts them.  A prepared array is already counted
+/// and becomes the new one.  Returns false, with t -> error set, when the
+/// budget or the allocator refuses
+
+static bool ht_grow( HashADT t ) {
+
+    size_t new_capacity = t -> capacity * RESIZE_FACTOR;
+
+    size_t old_bytes = t -> table == ht_inline_table(t) ? 0
+        : ht_array_copies(t, t -> capacity * sizeof(KeyValuePair)) * ht_array_bytes(t -> capacity, t -> table_mapping);
+
+    size_t new_bytes = ht_array_copies(t, new_capacity * sizeof(KeyValuePair)) * ht_new_array_bytes(t, new_capacity);
+
+    size_t more = new_bytes > old_bytes ? new_bytes - old_bytes : 0;
+
+    size_t prepared = ht_prepared_bytes(t);
+
+    more = more > prepared ? more - prepared : 0;
+
+    if(!ht_budget_allows(t, more)) {
+
+        t -> error = HT_ERROR_BUDGET;
+
+        return false;
+    }
+
+    if(!ht_rehash(t, new_capacity)) {
+
+        t -> error = HT_ERROR_MEMORY;
+
+        return false;
+    }
+
+    t -> rehashes++;
+
+    return true;
+}
+
+/// ht_flat_remove(): empty a bucket of the flat array by backward shift,
+/// as in HTSoA.c, so no probe run is broken
+
+static void ht_flat_remove( HashADT t, size_t hole ) {
+
+    size_t mask = t -> capacity - 1;
+
+    for(size_t i = (hole + 1) & mask; t -> table[i].key != NULL; i = (i + 1) & mask) {
+
+        size_t home = ht_home(t, t -> table[i].key);
+
+        //the pair stays if its home lies cyclically in (hole, i]
+
+        if(((i - home) & mask) < ((i - hole) & mask)) {
+            continue;
+        }
+
+        t -> table[hole] = t -> table[i];
+
+        if(t -> replica_count > 0) {
+
+            ht_replicate(t, hole);
+        }
+
+        hole = i;
+    }
+
+    t -> table[hole].key = NULL;
+
+    t -> table[hole].value = NULL;
+
+    if(t -> replica_count > 0) {
+
+        ht_replicate(t, hole);
+    }
+
+    t -> occupancy--;
+}
+
+/// ht_evict(): remove one stored pair to make room, and hand it to the
+/// delete fcn
+///
+/// pairs are taken in bucket order from where the last eviction stopped,
+/// like the hand of a clock, so every pair gets its turn
+
+static void ht_evict( HashADT t ) {
+
+    KeyValuePair victim;
+
+    if(t -> small) {
+
+        size_t index = t -> evict_hand++ % t -> occupancy;
+
+        victim = t -> small_pairs[index];
+
+        //the last pair fills the gap, as in ht_remove()
+
+        t -> occupancy--;
+
+        t -> small_pairs[index] = t -> small_pairs[t -> occupancy];
+
+        t -> small_hashes[index] = t -> small_hashes[t -> occupancy];
+
+    } else {
+
+        size_t index = t -> evict_hand & (t -> capacity - 1);
+
+        while(t -> table[index].key == NULL) {
+
+            index = (index + 1) & (t -> capacity - 1);
+        }
+
+        victim = t -> table[index];
+
+        ht_flat_remove(t, index);
+
+        t -> evict_hand = index + 1;
+    }
+
+    t -> evictions++;
+
+    if(t -> pair_bytes_fcn != NULL) {
+
+        t -> pair_bytes -= t -> pair_bytes_fcn(victim.key, victim.value);
+    }
+
+    if(t -> delete_fcn != NULL) {
+
+        t -> delete_fcn(victim.key, victim.value);
+    }
+}
+
+/// ht_make_room(): apply the budget policy to a new key the table could
+/// not grow for
+///
+/// returns true, clearing t -> error, if the key may go in
+
+static bool ht_make_room( HashADT t ) {
+
+    if(t -> budget_policy == HT_BUDGET_EVICT && t -> occupancy > 0) {
+
+        ht_evict(t);
+
+    } else if(t -> budget_policy == HT_BUDGET_LOAD && !t -> small
+            && t -> occupancy + 2 <= t -> capacity) {
+
+        //past the load threshold, but one bucket always stays empty so
+        //every probe ends
+
+    } else {
+
+        return false;
+    }
+
+    t -> error = HT_OK;
+
+    return true;
+}
+
+/// ht_small_find(): scan a small table's pairs for key, comparing the
+/// cached hashes first
+///
+/// returns t -> occupancy if the key is not in the table
+
+static size_t ht_small_find( const HashADT t, size_t hash, const void *key ) {
+
+    HT_COUNT(t -> lookups);
+
+    for(size_t i = 0; i < t -> occupancy; i++) {
+
+        if(t -> small_hashes[i] == hash && t -> equals_fcn(key, t -> small_pairs[i].key)) {
+
+            HT_COUNT(t -> hits);
+
+            return i;
+        }
+
+        HT_COUNT(t -> collisions);
+    }
+
+    HT_COUNT(t -> misses);
+
+    return t -> occupancy;
+}
+
+/// ht_small_upgrade(): move a full small table's pairs into the storage
+/// of its layout, a bucket array for flat tables
+///
+/// returns false, with t -> error set and the table still small, if the
+/// bucket array would pass the memory budget or cannot be allocated
+
+static bool ht_small_upgrade( HashADT t ) {
+
+    uint64_t start = ht_now_ns();
+
+    if(t -> layout != NULL) {
+
+        t -> small = false;
+
+        t -> layout_state = t -> layout -> create(t);
+
+        for(size_t i = 0; i < t -> occupancy; i++) {
+
+            bool added;
+
+            t -> layout -> insert(t, t -> layout_state, t -> small_pairs[i].key,
+                t -> small_pairs[i].value, &added);
+        }
+
+    } else {
+
+        //the smallest array the pairs and the next insert fit below the
+        //load threshold
+
+        size_t capacity = INITIAL_CAPACITY;
+
+        while((double) (t -> occupancy + 1) / capacity >= LOAD_THRESHOLD) {
+
+            capacity *= RESIZE_FACTOR;
+        }
+
+        size_t bytes = capacity * sizeof(KeyValuePair);
+
+        if(!ht_budget_allows(t, ht_array_copies(t, bytes) * ht_new_array_bytes(t, capacity))) {
+
+            t -> error = HT_ERROR_BUDGET;
+
+            return false;
+        }
+
+        size_t mapping;
+
+        KeyValuePair *table = ht_table_alloc(t, capacity, ht_primary_node(t), &mapping);
+
+        //the other nodes' copies too, or the pairs stay where they are
+
+        if(table == NULL || (t -> replica_count > 0 && !ht_replicas_alloc(t, table, capacity, mapping))) {
+
+            if(table != NULL) {
+
+                ht_table_free(t, table, capacity, mapping);
+            }
+
+            t -> error = HT_ERROR_MEMORY;
+
+            return false;
+        }
+
+        t -> table = table;
+
+        t -> table_mapping = mapping;
+
+        t -> small = false;
+
+        t -> capacity = capacity;
+
+        //the cached hashes are already seeded, so no key is hashed again
+
+        for(size_t i = 0; i < t -> occupancy; i++) {
+
+            size_t index = t -> small_hashes[i] & (capacity - 1);
+
+            while(t -> table[index].key != NULL) {
+
+                index = (index + 1) & (capacity - 1);
+
+                HT_COUNT(t -> collisions);
+            }
+
+            t -> table[index] = t -> small_pairs[i];
+        }
+
+        if(t -> auto_probe) {
+
+            t -> max_probe = ht_probe_bound(capacity);
+        }
+
+        if(t -> replica_count > 0) {
+
+            ht_replicas_copy(t);
+        }
+
+        ht_plan_prefault(t);
+    }
+
+    t -> rehashes++;
+
+    t -> rehash_ns += ht_now_ns() - start;
+
+    return true;
+}
+
+/// ht_has(): check if table has key value pair 
+///
+/// see headerfile for full documentation
+
+bool ht_has( const HashADT t, const void *key ) {
+
+    bool found;
+
+    if(t -> small) {
+
+        found = ht_small_find(t, ht_hash(t, key), key) != t -> occupancy;
+
+    } else if(t -> layout != NULL) {
+
+        const void *value;
+
+        found = ht_layout_find(t, key, &value);
+
+    } else {
+
+        found = ht_find(t, ht_local(t), key) != t -> capacity;
+    }
+
+    if(t -> trace != NULL) {
+
+        ht_trace_record(t, HT_TRACE_HAS, key, found);
+    }
+
+    return found;
+
+}
+
+/// ht_gets(): gets value associated with key from table
+///
+/// see headerfile for full documentation
+
+const void *ht_get( const HashADT t, const void *key ) {
+
+    if(t -> small) {
+
+        size_t index = ht_small_find(t, ht_hash(t, key), key);
+
+        //make sure table has key
+        assert(index != t -> occupancy);
+
+        if(t -> trace != NULL) {
+
+            ht_trace_record(t, HT_TRACE_GET, key, true);
+        }
+
+        return t -> small_pairs[index].value;
+    }
+
+    if(t -> layout != NULL) {
+
+        const void *value;
+
+        bool found = ht_layout_find(t, key, &value);
+
+        //make sure table has key
+        assert(found);
+
+        (void) found;
+
+        if(t -> trace != NULL) {
+
+            ht_trace_record(t, HT_TRACE_GET, key, true);
+        }
+
+        return value;
+    }
+
+    const KeyValuePair *table = ht_local(t);
+
+    size_t index = ht_find(t, table, key);
+    
+    //make sure table has key 
+    assert(index != t -> capacity);
+
+    if(t -> trace != NULL) {
+
+        ht_trace_record(t, HT_TRACE_GET, key, true);
+    }
+
+    return table[index].value;
+
+}
+
+/// ht_insert(): the body of ht_put, which adds tracing around it
+
+static void *ht_insert( HashADT t, const void *key, const void *value ) {
+
+    if(t -> small) {
+
+        size_t hash = ht_hash(t, key);
+
+        size_t index = ht_small_find(t, hash, key);
+
+        if(index != t -> occupancy) {
+
+            void *old_value = t -> small_pairs[index].value;
+
+            t -> small_pairs[index].value = (void *) value;
+
+            HT_COUNT(t -> updates);
+
+            return old_value;
+        }
+
+        //one pair too many, carry on as a table of the layout, or if
+        //that is refused, as the budget policy says
+
+        if(t -> occupancy == t -> small_capacity && !ht_small_upgrade(t) && !ht_make_room(t)) {
+            return NULL;
+        }
+
+        if(t -> small) {
+
+            index = t -> occupancy;
+
+            t -> small_hashes[index] = hash;
+
+            t -> small_pairs[index].key = (void *) key;
+
+            t -> small_pairs[index].value = (void *) value;
+
+            t -> occupancy++;
+
+            HT_COUNT(t -> inserts);
+
+            return NULL;
+        }
+    }
+
+    if(t -> layout != NULL) {
+
+        bool added;
+
+        void *old_value = t -> layout -> insert(t, t -> layout_state, key, value, &added);
+
+        if(added) {
+
+            t -> occupancy++;
+
+            HT_COUNT(t -> inserts);
+
+        } else {
+
+            HT_COUNT(t -> updates);
+        }
+
+        return old_value;
+    }
+ 
+    //check if table needs to be rehashed first
+    
+    double current_threshold = (double) t-> occupancy / t-> capacity;
+
+    if(current_threshold >= LOAD_THRESHOLD) {
+
+        //rehash the table into a larger one; if the budget or the
+        //allocator refuses, an update needs no room, and a new key gets
+        //what the budget policy can make
+
+        if(!ht_grow(t)) {
+
+            if(ht_find(t, t -> table, key) != t -> capacity) {
+
+                t -> error = HT_OK;
+
+            } else if(!ht_make_room(t)) {
+
+                return NULL;
+            }
+        }
+
+    } else if(t -> occupancy >= t -> prepare_at) {
+
+        //start faulting in the array the next growth will use
+
+        ht_prepare(t);
+    }
+
+    //create and put new pair into table
+
+    KeyValuePair new_pair;
+
+    new_pair.key = (void*) key;
+
+    new_pair.value = (void*) value;
+
+    size_t new_index = ht_home(t, key);
+
+    size_t probes = 0;
+
+    //check if the designated spot for the key is available
+
+    if(t->table[new_index].key == NULL) {
+        
+        //no collisions, the designated spot is good
+
+        t->table[new_index] = new_pair;
+
+        if(t -> replica_count > 0) {
+
+            ht_replicate(t, new_index);
+        }
+        
+        t -> occupancy++;
+
+        HT_COUNT(t -> inserts);
+
+        return NULL;
+
+    }
+
+    //we either have a collision or same value
+    
+    do {
+
+    KeyValuePair collision_pair = t -> table[new_index];
+
+    if (t->equals_fcn(key, collision_pair.key)) {
+        
+        void* old_value = collision_pair.value;
+
+        t -> table[new_index].value = (void*) value;
+
+        if(t -> replica_count > 0) {
+
+            ht_replicate(t, new_index);
+        }
+
+        HT_COUNT(t -> updates);
+
+        return old_value;
+    }
+
+    //increment index and collision counter
+
+    HT_COUNT(t -> collisions);
+
+    probes++;
+
+    new_index = (new_index + 1) & (t -> capacity - 1);
+    
+    } while(t->table[new_index].key != NULL);
+    
+    //found an empty spot to put it
+
+    t -> table[new_index] = new_pair;
+
+    if(t -> replica_count > 0) {
+
+        ht_replicate(t, new_index);
+    }
+    
+    t-> occupancy++;
+
+    HT_COUNT(t -> inserts);
+
+    //an unusually long probe means someone is feeding colliding keys
+
+    if(probes > t -> max_probe) {
+
+        ht_reseed(t);
+    }
+
+    return NULL;
+}
+
+/// ht_stored_bytes(): the pair_bytes of the pair stored under key, 0 if
+/// there is none
+
+static size_t ht_stored_bytes( const HashADT t, const void *key ) {
+
+    const void *value;
+
+    if(t -> small) {
+
+        size_t index = ht_small_find(t, ht_hash(t, key), key);
+
+        if(index == t -> occupancy) {
+            return 0;
+        }
+
+        value = t -> small_pairs[index].value;
+
+    } else if(t -> layout != NULL) {
+
+        if(!ht_layout_find(t, key, &value)) {
+            return 0;
+        }
+
+    } else {
 
-    void* key;
+        size_t index = ht_find(t, t -> table, key);
 
-    void* value;
+        if(index == t -> capacity) {
+            return 0;
+        }
 
-} KeyValuePair;
+        value = t -> table[index].value;
+    }
 
+    return t -> pair_bytes_fcn(key, value);
+}
 
-/// The hash table representation of ADT
-/// Uses array of KeyValuePairs to represent hash table
-/// Holds given fcns from client to use
-/// Holds counters to keep track of performance
+/// ht_put():  adds a key value pair to table
+///
+/// see headerfile for full documentation
 
-struct hashtab_s {
+void *ht_put( HashADT t, const void *key, const void *value ) {
 
-    //keep track of capacity
-    size_t capacity;
+    t -> error = HT_OK;
 
-    //track the occupancy
-    size_t occupancy;
+    if(t -> trace == NULL && t -> pair_bytes_fcn == NULL) {
 
-    //track the collisions occured
-    int collisions;
+        return ht_insert(t, key, value);
+    }
 
-    //track # of rehashes
-    int rehashes;
+    //weighed before the insert, since a copied value is overwritten
 
-    //handle all the fcns given to work with by client
+    size_t old_bytes = t -> pair_bytes_fcn != NULL ? ht_stored_bytes(t, key) : 0;
 
-    size_t (*hash_fcn)(const void *key);
+    //an eviction leaves occupancy as it was, so it is counted too
 
-    bool (*equals_fcn)(const void *key1, const void *key2);
+    size_t occupancy = t -> occupancy;
 
-    void (*print_fcn)(const void *key, const void *value);
+    uint64_t evictions = t -> evictions;
 
-    void (*delete_fcn)(void *key, void *value);
+    void *old_value = ht_insert(t, key, value);
 
-    //the hash table itself, an array of KeyValue pairs (struct)
+    bool found = t -> occupancy == occupancy && t -> evictions == evictions && t -> error == HT_OK;
 
-    KeyValuePair* table;
+    if(t -> pair_bytes_fcn != NULL && t -> error == HT_OK) {
 
-};
+        t -> pair_bytes += t -> pair_bytes_fcn(key, value);
 
-/// ht_create(): the ADT create function
-///
-/// see headerfile for full documentation
+        if(found) {
 
-HashADT ht_create(
-    size_t (*hash)( const void *key ),
-    bool (*equals)( const void *key1, const void *key2 ),
-    void (*print)( const void *key, const void *value ),
-    void (*delete)( void *key, void *value )
-) {
+            t -> pair_bytes -= old_bytes;
+        }
+    }
 
-    //check preconditions: make sure hash, equals and print are not null
+    if(t -> trace != NULL) {
 
-    assert(hash != NULL);
+        ht_trace_record(t, HT_TRACE_PUT, key, found);
+    }
 
-    assert(equals != NULL);
+    return old_value;
+}
 
-    assert(print != NULL);
+/// ht_occupancy(): the number of keys
+///
+/// see HTLayout.h for full documentation
 
-    //create and allocate new structure
+size_t ht_occupancy( const HashADT t ) {
 
-    HashADT new;
+    return t -> occupancy;
+}
 
-    new = (HashADT) malloc(sizeof(struct hashtab_s));
+/// ht_remove(): take a key out of the table
+///
+/// see HTLayout.h for full documentation
 
-    //assert that the mem alloc worked
+bool ht_remove( HashADT t, const void *key, void **key_out, void **value_out ) {
 
-    assert(new != NULL);
+    assert(t != NULL && key != NULL);
 
-    //set all the tracking fields 
-    new -> capacity = INITIAL_CAPACITY;
+    //weighed before the remove, since a copied value is overwritten
 
-    new -> occupancy = 0;
+    size_t old_bytes = t -> pair_bytes_fcn != NULL ? ht_stored_bytes(t, key) : 0;
 
-    new -> collisions = 0;
+    if(t -> small) {
 
-    new -> rehashes = 0;
+        size_t index = ht_small_find(t, ht_hash(t, key), key);
 
-    //set the custom functions to be used by this hashtable
+        if(index == t -> occupancy) {
+            return false;
+        }
 
-    new -> hash_fcn = hash;
+        *key_out = t -> small_pairs[index].key;
 
-    new -> equals_fcn = equals;
+        *value_out = t -> small_pairs[index].value;
 
-    new -> print_fcn = print;
+        //the last pair fills the gap, so the pairs stay packed
 
-    new -> delete_fcn = delete;
+        t -> occupancy--;
 
-    //allocate memory for the table of key value pairs using init capacity
+        t -> small_pairs[index] = t -> small_pairs[t -> occupancy];
 
-    new -> table = (KeyValuePair*)calloc(INITIAL_CAPACITY, sizeof(KeyValuePair));
+        t -> small_hashes[index] = t -> small_hashes[t -> occupancy];
 
-    //assert that table alloc was completed
+    } else if(t -> layout != NULL) {
 
-    assert(new -> table != NULL);
+        assert(t -> layout -> remove != NULL);
 
-    return new;
+        if(!t -> layout -> remove(t, t -> layout_state, key, key_out, value_out)) {
+            return false;
+        }
 
-}
+        t -> occupancy--;
 
-/// ht_destroy(): the destroy fcn, calls destroy
-///
-/// see headerfile for full documentation
+    } else {
 
-void ht_destroy( HashADT t) {
+        size_t index = ht_find(t, t -> table, key);
 
-    // assert that the ADT is not null
-    
-    assert(t != NULL);
-    
-    // deallocate any dynamic storage
-    // if delete fcn != NULL, use to deallocate each pair in table
-    
-    if (t -> delete_fcn != NULL) {
-        
-        //use the given delete fcn to free the key value pairs
-        for(size_t i = 0; i < t -> capacity; i++){
-            
-            KeyValuePair pair = t -> table[i];
-            
-            if(pair.key != NULL) {
-                t -> delete_fcn(pair.key, pair.value);
-            }
+        if(index == t -> capacity) {
+            return false;
         }
 
-    } 
-    
-    //free the table and hashtable itself
+        *key_out = t -> table[index].key;
 
-    free(t -> table);
+        *value_out = t -> table[index].value;
+
+        ht_flat_remove(t, index);
+    }
 
-    free(t);
+    t -> pair_bytes -= old_bytes;
 
+    return true;
 }
 
-/// ht_dump() prints info about the table
+/// ht_each(): visit every pair
 ///
-/// see headerfile for full documentation
-
-void ht_dump(const HashADT t, bool contents) {
-    
-    //print out all info about table
-
-    printf("Size: %zu\n",t -> occupancy);
+/// see HTLayout.h for full documentation
 
-    printf("Capacity: %zu\n", t -> capacity);
+void ht_each( const HashADT t, void (*visit)( void *context, void *key, void *value ), void *context ) {
 
-    printf("Collisions: %d\n", t -> collisions);
+    if(t -> small) {
 
-    printf("Rehashes: %d\n", t -> rehashes);
+        for(size_t i = 0; i < t -> occupancy; i++) {
 
-    //if contents true print the contents using print fcn
+            visit(context, t -> small_pairs[i].key, t -> small_pairs[i].value);
+        }
 
-    if(contents) {
-        
-        for(size_t i = 0; i < t -> capacity; i++){
-            
-            //get the key value of each bucket
+    } else if(t -> layout != NULL) {
 
-            KeyValuePair pair = t -> table[i];
-            
-            //check if key value pair is null
-            if(pair.key == NULL) {
-                
-                printf("%zu: null\n",i);
+        t -> layout -> each(t, t -> layout_state, visit, context);
 
-            } else {
+    } else {
 
-                printf("%zu: (", i);
+        for(size_t i = 0; i < t -> capacity; i++) {
 
-                t -> print_fcn(pair.key, pair.value);
+            if(t -> table[i].key != NULL) {
 
-                printf(")\n");
+                visit(context, t -> table[i].key, t -> table[i].value);
             }
         }
     }
-
 }
 
-/// ht_has(): check if table has key value pair 
+/// ht_slab_alloc(): bump allocate size bytes, aligned, from the newest slab
 ///
-/// see headerfile for full documentation
+/// a new slab takes at most a quarter of what the memory budget leaves,
+/// so the bucket array can still grow, and NULL is returned when even the
+/// copy itself does not fit
 
-bool ht_has( const HashADT t, const void *key ) {
-    
-    //get the hashvalue of the key
+static void *ht_slab_alloc( HashADT t, size_t size ) {
 
-    size_t hash_value = t -> hash_fcn(key);
+    HTSlab *slab = t -> slabs;
 
-    //get index of that specific hash fcn
+    size_t start = 0;
 
-    size_t orig_index = hash_value % t -> capacity;
+    if(slab != NULL) {
 
-    //set index to the starting index
+        uintptr_t end = (uintptr_t) (slab -> data + slab -> used);
 
-    size_t index = orig_index;
+        start = slab -> used + ((SLAB_ALIGN - end % SLAB_ALIGN) % SLAB_ALIGN);
+    }
 
-    //check at the designated hashcode spot
-    do{
+    if(slab == NULL || start + size > slab -> size) {
 
-        KeyValuePair pair = t -> table[index];
-            
-        if(pair.key == NULL) {
-            //hit an empty bucket meaing we are done
+        //each slab doubles the last, so there are few of them
 
-            break;
-        }
-        
+        size_t slab_size = slab == NULL ? SLAB_MIN : slab -> size * 2;
 
-        if(t->equals_fcn(key,pair.key)) {
-            
-            return true;
+        if(slab_size > SLAB_MAX) {
+            slab_size = SLAB_MAX;
         }
 
-        // a collision has occured
-
-        hash_value++;
-        
-        //recalculate the new index
-        index = hash_value % t -> capacity;
-        
-        //increase collision counter only if collision has occurred
-        t -> collisions++;
-        
-    } while(index != orig_index);
-
-    return false;
-
-}
-
-/// ht_gets(): gets value associated with key from table
-///
-/// see headerfile for full documentation
+        if(t -> memory_budget > 0) {
 
-const void *ht_get( const HashADT t, const void *key ) {
-    
-    //make sure table has key 
-    assert(ht_has(t, key));
+            size_t used = ht_memory_usage(t) + sizeof(HTSlab);
 
-    size_t hashcode;
+            size_t left = used < t -> memory_budget ? t -> memory_budget - used : 0;
 
-    size_t index;
+            if(slab_size > left / 4) {
+                slab_size = left / 4;
+            }
+        }
 
-    KeyValuePair pair;
+        if(slab_size < size + SLAB_ALIGN) {
+            slab_size = size + SLAB_ALIGN;
+        }
 
-    //get value associated with a key
+        if(!ht_budget_allows(t, sizeof(HTSlab) + slab_size)) {
 
-    hashcode = t -> hash_fcn(key);
+            return NULL;
+        }
 
-    index = hashcode % t->capacity;
+        slab = (HTSlab*)ht_mem_alloc(&t -> allocator, sizeof(HTSlab) + slab_size);
 
-    //get the key value pair at that spot
+        assert(slab != NULL);
 
-    pair = t -> table[index];
+        slab -> next = t -> slabs;
 
-    while ( !(t-> equals_fcn(key,pair.key))) {
-            
-        //increment the hashcode, collision is handled by the get fcn already called
+        slab -> size = slab_size;
 
-        hashcode++;
+        slab -> used = 0;
 
-        index = hashcode % t -> capacity;
+        t -> slabs = slab;
 
-        pair = t -> table[index];
+        t -> slab_bytes += sizeof(HTSlab) + slab_size;
 
+        start = (SLAB_ALIGN - (uintptr_t) slab -> data % SLAB_ALIGN) % SLAB_ALIGN;
     }
 
-    return pair.value;
+    slab -> used = start + size;
 
+    return slab -> data + start;
 }
 
-/// ht_put():  adds a key value pair to table
-///
-/// see headerfile for full documentation
-
-void *ht_put( HashADT t, const void *key, const void *value ) {
- 
-    //check if table needs to be rehashed first
-    
-    double current_threshold = (double) t-> occupancy / t-> capacity;
+/// ht_slab_release(): hand back every copy made since the newest slab was
+/// slab and it had used bytes in use, freeing slabs made since then
 
-    if(current_threshold >= LOAD_THRESHOLD) {
+static void ht_slab_release( HashADT t, HTSlab *slab, size_t used ) {
 
-        //rehash the table
-        
-        KeyValuePair* new_table = 
-            (KeyValuePair*)calloc(t->capacity * RESIZE_FACTOR,sizeof(KeyValuePair));
+    while(t -> slabs != slab) {
 
-        //store the old table data
+        HTSlab *next = t -> slabs -> next;
 
-        KeyValuePair* old_table = t -> table;
+        t -> slab_bytes -= sizeof(HTSlab) + t -> slabs -> size;
 
-        size_t old_capacity = t -> capacity;
+        ht_mem_free(&t -> allocator, t -> slabs, sizeof(HTSlab) + t -> slabs -> size);
 
-        //update to new capacity 
-        t -> capacity = old_capacity * RESIZE_FACTOR;
+        t -> slabs = next;
+    }
 
-        //iterate through the old table and update the new table
+    if(slab != NULL) {
 
-        for(size_t i = 0; i < old_capacity; i++){
-            
-            KeyValuePair pair = old_table[i];
+        slab -> used = used;
+    }
+}
 
-            if(pair.key == NULL){
-                continue;
-            }
+/// ht_put_copy(): adds copies of a key and value to the table
+///
+/// see headerfile for full documentation
 
-            //if it is empty we do not care
-            
-            //rehash the key with new capacity
-            
-            size_t hash = t->hash_fcn(pair.key);
+void *ht_put_copy( HashADT t, const void *key, size_t klen,
+    const void *value, size_t vlen ) {
 
-            size_t index = hash % t->capacity;
+    //the slabs are freed whole, so no delete fcn may free pairs one by
+    //one, and no eviction may drop a pair whose copies stay behind
 
-            if(new_table[index].key != NULL) {
-                
-                //linear probe
+    assert(t != NULL && t -> delete_fcn == NULL);
 
-                do {
-                    
-                    hash++;
+    assert(t -> budget_policy != HT_BUDGET_EVICT);
 
-                    index = hash % t->capacity;
+    assert(key != NULL && klen > 0 && (value != NULL || vlen == 0));
 
-                    //update collision counter for each collision
+    //a table with a value_size copies the value itself
 
-                    t -> collisions++;
+    assert(t -> value_size == 0 || vlen == t -> value_size);
 
-                } while (new_table[index].key != NULL);
+    //where the slabs stood before each copy, to hand the copies back
 
-                //finally found a valid position
-                new_table[index] = pair;
+    HTSlab *value_slab = t -> slabs;
 
-            } else {
+    size_t value_used = value_slab != NULL ? value_slab -> used : 0;
 
-                //found initial valid position
-                new_table[index] = pair;
+    void *value_copy = t -> value_size > 0 ? (void *) value : NULL;
 
-            }
-        }
-        //table finished rehashing, update new table
+    if(vlen > 0 && t -> value_size == 0) {
 
-        t -> table = new_table;
+        value_copy = ht_slab_alloc(t, vlen);
 
-        //update the rehash counter
+        if(value_copy == NULL) {
 
-        t -> rehashes++;
+            t -> error = HT_ERROR_BUDGET;
 
-        //free the old table
+            return NULL;
+        }
 
-        free(old_table);
+        memcpy(value_copy, value, vlen);
     }
 
-    //create and put new pair into table
-
-    KeyValuePair new_pair;
-
-    new_pair.key = (void*) key;
+    //the key is copied last, so an update can hand its bytes back
 
-    new_pair.value = (void*) value;
+    HTSlab *key_slab = t -> slabs;
 
-    size_t  new_hash = t -> hash_fcn(key);
+    size_t key_used = key_slab != NULL ? key_slab -> used : 0;
 
-    size_t new_index = new_hash % t -> capacity;
+    void *key_copy = ht_slab_alloc(t, klen);
 
-    //check if the designated spot for the key is available
+    if(key_copy == NULL) {
 
-    if(t->table[new_index].key == NULL) {
-        
-        //no collisions, the designated spot is good
+        ht_slab_release(t, value_slab, value_used);
 
-        t->table[new_index] = new_pair;
-        
-        t -> occupancy++;
+        t -> error = HT_ERROR_BUDGET;
 
         return NULL;
-
     }
 
-    //we either have a collision or same value
-    
-    do {
-
-    KeyValuePair collision_pair = t -> table[new_index];
+    memcpy(key_copy, key, klen);
 
-    if (t->equals_fcn(key, collision_pair.key)) {
-        
-        void* old_value = collision_pair.value;
+    size_t occupancy = t -> occupancy;
 
-        t -> table[new_index].value = (void*) value;
+    void *old_value = ht_put(t, key_copy, value_copy);
 
-        return old_value;
-    }
+    if(t -> error != HT_OK) {
 
-    //increment hash and collision counter
+        //the table refused the pair, so neither copy is used
 
-    t -> collisions++;
+        ht_slab_release(t, value_slab, value_used);
 
-    new_hash++;
+    } else if(t -> occupancy == occupancy) {
 
-    new_index = new_hash % t -> capacity;
-    
-    } while(t->table[new_index].key != NULL);
-    
-    //found an empty spot to put it
+        //the table kept its own copy of the key
 
-    t -> table[new_index] = new_pair;
-    
-    t-> occupancy++;
+        ht_slab_release(t, key_slab, key_used);
+    }
 
-    return NULL;
+    return old_value;
 }
 
 /// ht_keys(): get collection of keys from table
@@ -456,12 +3583,31 @@ void *ht_put( HashADT t, const void *key, const void *value ) {
 void **ht_keys( const HashADT t ) {
     
     //put enough memory for all valid keys
-    void **keys = (void**)malloc(t->occupancy * sizeof(void*));
+    void **keys = (void**)ht_mem_alloc(&t -> allocator, t->occupancy * sizeof(void*));
     
     //make sure memory was allocated
     assert(keys != NULL);
 
     size_t key_index= 0;
+
+    if(t -> small) {
+
+        for(size_t i = 0; i < t -> occupancy; i++) {
+
+            keys[i] = t -> small_pairs[i].key;
+        }
+
+        return keys;
+    }
+
+    if(t -> layout != NULL) {
+
+        HTVisit visit = { t, keys, 0 };
+
+        t -> layout -> each(t, t -> layout_state, ht_visit_key, &visit);
+
+        return keys;
+    }
     
     //copy the keys over
     for (size_t i = 0; i < t->capacity; i++) {
@@ -485,12 +3631,35 @@ void **ht_keys( const HashADT t ) {
 void **ht_values( const HashADT t ) {
 
      //put enough memory for all valid values
-     void **values = (void**)malloc(t->occupancy * sizeof(void*));
+     void **values = (void**)ht_mem_alloc(&t -> allocator, t->occupancy * sizeof(void*));
 
      //make sure memory was allocated
      assert(values != NULL);
 
      size_t value_index = 0;
+
+     if(t -> small) {
+
+         for(size_t i = 0; i < t -> occupancy; i++) {
+
+             if(t -> small_pairs[i].value != NULL) {
+
+                 values[value_index] = t -> small_pairs[i].value;
+                 value_index++;
+             }
+         }
+
+         return values;
+     }
+
+     if(t -> layout != NULL) {
+
+         HTVisit visit = { t, values, 0 };
+
+         t -> layout -> each(t, t -> layout_state, ht_visit_value, &visit);
+
+         return values;
+     }
     
      //copy the values over  
      for (size_t i = 0; i < t->capacity; i++) {
@@ -8,6 +8,7 @@
 
 #include <stdbool.h>    // bool
 #include <stddef.h>     // size_t
+#include <stdint.h>     // uint64_t
 
 /// Initial capacity of table upon creation
 #define INITIAL_CAPACITY 16
@@ -15,7 +16,8 @@
 /// The load at which the table will rehash
 #define LOAD_THRESHOLD 0.75
 
-/// The table size will double upon each rehash
+/// The table size will double upon each rehash; with INITIAL_CAPACITY it
+/// keeps the capacity a power of two, which the bucket index relies on
 #define RESIZE_FACTOR 2
 
 ///
@@ -32,10 +34,55 @@
 ///   delete function, which causes the delete function to NOT free the
 ///   (key, value) pair.
 ///
+/// - A table's first bucket array is allocated in one block with the
+///   table itself, so a table that never grows makes one allocation.
+///
+/// - Bucket arrays are aligned to a 64 byte cache line.  Large ones can be
+///   backed by huge pages and prefaulted on a background thread (see
+///   HTOptions), which needs the program linked with -pthread.
+///
+/// - ht_put_copy() copies keys and values into slabs the table owns,
+///   for tables that should not hold one allocation per key.
+///
 /// - There is no remove functionality. Entries remain until you call destroy.
 ///
 /// - The destroy calls a no-operation delete if the client passes NULL destroy.
 ///
+/// - Tables made by ht_create() place keys by hash % capacity.  Tables
+///   fed keys from untrusted sources should be made by ht_create_opts()
+///   with a random seed (and ideally a keyed hash) so that nobody can
+///   predict which keys collide.
+///
+/// - Every table watches its probe lengths.  When an insert probes past
+///   max_probe buckets the table assumes it is being flooded, switches to
+///   a fresh random seed and rehashes in place.
+///
+/// - Operation counters (collisions, lookups, ...) are compiled into the
+///   library only when HASHADT_STATS is nonzero, which is the default
+///   unless NDEBUG is defined.  Release builds then have lookups that never
+///   write to the table; build with -DHASHADT_STATS=1 to keep the counters.
+///
+/// - HTOptions can keep a handful of pairs inline in the table, with no
+///   bucket array, until the table outgrows them.
+///
+/// - HTOptions can select a segmented layout, which grows one small
+///   segment at a time instead of copying the whole table, or a
+///   structure-of-arrays layout, whose lookups read keys without values,
+///   or a compact layout, whose buckets are small positions in an array
+///   of the pairs kept in insertion order.
+///
+/// - An SoA table can hold values of a fixed size itself (HTOptions
+///   value_size): ht_put() copies the value in and ht_get() returns a
+///   pointer into the table, so a value needs no allocation of its own.
+///
+/// - ht_memory_usage() reports what a table holds.  A flat table can be
+///   given a memory budget, and a flat table that cannot grow, for its
+///   budget or for want of memory, refuses, evicts or packs in new keys
+///   as HTOptions says, instead of aborting.
+///
+/// - ht_trace_start() records the operations on a table to a file, which
+///   tools/ht_replay runs again against any build or configuration.
+///
 /// - Wherever a function has a precondition, and the client violates the
 ///   condition, and the code detects the violation, then the function will
 ///   assert failure and abort.
@@ -73,6 +120,247 @@ HashADT ht_create(
     void (*delete)( void *key, void *value )
 );
 
+///
+/// How a table seeds the placement of keys.
+///
+typedef enum HTSeedMode {
+    HT_SEED_NONE,       ///< bucket is hash % capacity, as in ht_create()
+    HT_SEED_RANDOM,     ///< per-table seed drawn from the OS at creation
+    HT_SEED_FIXED       ///< the seed given in HTOptions (reproducible runs)
+} HTSeedMode;
+
+///
+/// Memory hooks for a table.  Every block the table allocates for itself
+/// (the table, its bucket array, slabs, trace buffers and the arrays from
+/// ht_keys() and ht_values()) comes from alloc or aligned_alloc and goes
+/// back through free, which is told the size that was requested.
+///
+typedef struct HTAllocator {
+
+    /// Allocate size bytes aligned for any type, or return NULL
+    void *(*alloc)( void *context, size_t size );
+
+    /// Optional: allocate size bytes aligned to alignment (a power of
+    /// two), or return NULL; alloc is used when this is NULL
+    void *(*aligned_alloc)( void *context, size_t alignment, size_t size );
+
+    /// Release a block from alloc or aligned_alloc
+    void (*free)( void *context, void *ptr, size_t size );
+
+    /// Passed to every hook
+    void *context;
+
+    /// Optional: resize a block to new_size bytes, keeping its contents,
+    /// or return NULL and leave it alone.  Lets tables with grow_in_place
+    /// grow without a second array; placed last so initializers that end
+    /// at context still compile.
+    void *(*realloc)( void *context, void *ptr, size_t old_size, size_t new_size );
+
+} HTAllocator;
+
+///
+/// How large bucket arrays are backed by huge pages.
+///
+typedef enum HTHugePages {
+    HT_HUGE_NONE,           ///< ordinary pages
+    HT_HUGE_TRANSPARENT,    ///< mmap aligned to 2 MiB with MADV_HUGEPAGE
+    HT_HUGE_EXPLICIT        ///< MAP_HUGETLB from the hugetlbfs pool, falling
+                            ///< back to transparent when the pool is empty
+} HTHugePages;
+
+///
+/// When the pages of a large bucket array are faulted in.
+///
+typedef enum HTPrefault {
+    HT_PREFAULT_NONE,       ///< on first touch, during the rehash
+    HT_PREFAULT_SYNC,       ///< all at once when the array is mapped
+    HT_PREFAULT_BACKGROUND  ///< the next array is mapped and faulted by a
+                            ///< thread once the table is half way to growing
+} HTPrefault;
+
+///
+/// Where the pages of large bucket arrays live on a NUMA machine.
+///
+typedef enum HTNuma {
+    HT_NUMA_DEFAULT,        ///< wherever the kernel puts them (first touch)
+    HT_NUMA_INTERLEAVE,     ///< page by page round robin over all nodes
+    HT_NUMA_REPLICATE       ///< one copy per node: lookups read the copy on
+                            ///< the caller's node, ht_put writes every copy
+} HTNuma;
+
+///
+/// How a table stores its pairs.
+///
+typedef enum HTLayout {
+    HT_LAYOUT_FLAT,         ///< one bucket array, doubled and copied whole
+    HT_LAYOUT_SEGMENTED,    ///< extendible hashing: a directory of segments
+                            ///< of at most 1024 buckets, split one at a time
+    HT_LAYOUT_SOA,          ///< separate arrays of hash tags, keys and
+                            ///< values; probes compare 16 tags at once and
+                            ///< read a value only for the key they find
+    HT_LAYOUT_COMPACT       ///< a dense array of pairs in insertion
+                            ///< order, probed through an index of 1, 2
+                            ///< or 4 byte positions into it
+} HTLayout;
+
+///
+/// What ht_put() does with a new key when the table cannot grow, because
+/// growing would pass its memory budget or the memory cannot be had.
+///
+typedef enum HTBudgetPolicy {
+    HT_BUDGET_REFUSE,   ///< store nothing; ht_error() says why
+    HT_BUDGET_EVICT,    ///< remove a stored pair, calling the delete
+                        ///< function on it, and store the new one;
+                        ///< not for tables fed by ht_put_copy()
+    HT_BUDGET_LOAD      ///< store it past the load threshold, until one
+                        ///< empty bucket is left, then refuse
+} HTBudgetPolicy;
+
+///
+/// Why the last ht_put() or ht_put_copy() stored nothing.
+///
+typedef enum HTError {
+    HT_OK,              ///< the pair was stored
+    HT_ERROR_BUDGET,    ///< growing would have passed the memory budget
+    HT_ERROR_MEMORY     ///< the memory to grow could not be allocated
+} HTError;
+
+///
+/// Creation options for ht_create_opts().  Always fill an HTOptions with
+/// ht_options_init() first, then change the members of interest.
+///
+typedef struct HTOptions {
+
+    /// How keys are seeded; defaults to HT_SEED_NONE
+    HTSeedMode seed_mode;
+
+    /// The seed used by HT_SEED_FIXED
+    uint64_t seed;
+
+    /// Optional keyed hash function, called with the table seed in place
+    /// of hash (e.g. ht_hash_cstr_keyed).  When NULL, the seed is mixed
+    /// into the result of hash instead, which spreads distinct hash values
+    /// but cannot separate keys whose hash values are equal.
+    size_t (*keyed_hash)( const void *key, uint64_t seed );
+
+    /// Probe length that triggers a reseed; 0 picks a bound from the
+    /// capacity that ordinary load never reaches
+    size_t max_probe;
+
+    /// Where the table gets its memory; NULL uses malloc and free.  The
+    /// table keeps a copy of the hooks, not the pointer.
+    const HTAllocator *allocator;
+
+    /// Bucket arrays of at least huge_threshold bytes (0 picks 2 MiB)
+    /// are mapped straight from the OS, on Linux and when the table has
+    /// no allocator, and can be backed by huge pages
+    HTHugePages huge_pages;
+
+    size_t huge_threshold;
+
+    /// Prefaulting of the same large bucket arrays
+    HTPrefault prefault;
+
+    /// NUMA placement of the same large bucket arrays.  Replication
+    /// multiplies the bucket memory by the node count and slows ht_put,
+    /// so it suits tables that are read far more than written; on a
+    /// machine with one node it does nothing.  Arrays below
+    /// huge_threshold come from the heap, which cannot be placed on a
+    /// node, so a table keeps one copy until its array is mapped.
+    HTNuma numa;
+
+    /// Grow (and reseed) by resizing the bucket array where it lies and
+    /// moving pairs within it, so growth never holds two arrays.  This
+    /// works for mapped arrays (mremap) and for arrays from an allocator
+    /// with realloc; other arrays, replicated ones, and any resize that
+    /// fails, fall back to copying into a new array.
+    bool grow_in_place;
+
+    /// How pairs are stored; defaults to HT_LAYOUT_FLAT.  A segmented
+    /// table never moves more than one segment per ht_put() and never
+    /// allocates more than one segment (or its directory) at a time, at
+    /// the cost of a directory load per operation.  An SoA table suits
+    /// lookup heavy tables, ht_has() most of all.  A compact table spends
+    /// 1 to 4 bytes on an empty bucket instead of 16, and keeps its pairs
+    /// in the order they were added: ht_keys(), ht_values() and ht_dump()
+    /// list them in that order, reading them in one sequential pass.
+    /// Layouts other than flat ignore max_probe, huge_pages, prefault,
+    /// numa and grow_in_place, which are about the flat array.
+    HTLayout layout;
+
+    /// Keep up to this many pairs inside the table's own allocation, found
+    /// by scanning their cached hashes, and make the layout's storage only
+    /// when one more arrives; 0 (the default) makes it at creation.  Suits
+    /// programs with many tables of a few keys.  8 keeps the hashes in one
+    /// cache line; past 16 or so the scan is slower than hashing.  A flat
+    /// table without it (and not mapped or replicated) instead holds its
+    /// first INITIAL_CAPACITY buckets, 256 bytes, in its own allocation;
+    /// they stay there, counted, once the table outgrows them.
+    size_t small_capacity;
+
+    /// Copy values of this many bytes into the table instead of storing
+    /// value pointers; 0 (the default) stores pointers.  Needs
+    /// HT_LAYOUT_SOA and no small_capacity.  ht_put() copies value_size
+    /// bytes from value (zeros when value is NULL), and ht_get(),
+    /// ht_values() and the delete function see a pointer to the copy,
+    /// which stays valid until the next ht_put() or ht_destroy().  Values
+    /// are aligned to value_size rounded up to a power of two, at most 8.
+    size_t value_size;
+
+    /// Most bytes ht_memory_usage() may report once the table grows; 0
+    /// (the default) sets no limit.  Needs HT_LAYOUT_FLAT.  A growth that
+    /// would pass it, or whose memory cannot be allocated, is not made,
+    /// and budget_policy decides what happens to the new key.  Without a
+    /// budget only a failed allocation brings the policy into play.  A
+    /// reseed against flooding is skipped when the budget cannot hold
+    /// the new array beside the old one.
+    size_t memory_budget;
+
+    HTBudgetPolicy budget_policy;
+
+    /// Optional: the bytes the client holds for a pair (the key and value
+    /// objects themselves), counted by ht_memory_usage() and so by the
+    /// budget.  It is called when a pair is stored, replaced or removed,
+    /// and must give the same answer each time for the same pair; with a
+    /// value_size, value points to the value's bytes.
+    size_t (*pair_bytes)( const void *key, const void *value );
+
+} HTOptions;
+
+///
+/// Fill options with the defaults, which match ht_create().
+///
+/// @param options The options to initialize
+///
+/// @pre options is not NULL.
+///
+void ht_options_init( HTOptions *options );
+
+///
+/// Create a new hash table instance with creation options.  If delete is
+/// NULL, destroying the table will NOT free the (key,value) data pairs.
+///
+/// @param hash The hash function for key data
+/// @param equals The equal function for key comparison
+/// @param print The print function for key, value pairs is used by dump().
+/// @param delete The delete function for key, value pairs is used by destroy().
+/// @param options The creation options, or NULL for the defaults
+///
+/// @exception Assert fails if it cannot allocate space
+///
+/// @pre equals and print are valid function pointers.
+/// @pre hash is a valid function pointer, unless options has a keyed_hash.
+///
+/// @return A newly created table
+///
+HashADT ht_create_opts(
+    size_t (*hash)( const void *key ),
+    bool (*equals)( const void *key1, const void *key2 ),
+    void (*print)( const void *key, const void *value ),
+    void (*delete)( void *key, void *value ),
+    const HTOptions *options
+);
+
 ///
 /// Destroy the table instance, and call delete function on (key,value) pair.
 /// 
@@ -86,9 +374,11 @@ void ht_destroy( HashADT t );
 
 ///
 /// Print information about hash table (size, capacity, collisions, rehashes). 
+/// Collisions are only printed when the counters are compiled in.
 /// 
 /// If contents is true, also print the entire contents of the hash table
 /// using the registered print function with each non-null entry.
+/// Programs that want the numbers rather than the text use ht_stats().
 /// 
 /// @param t The table to display
 /// @param contents Do a full dump including the entire table contents
@@ -97,6 +387,229 @@ void ht_destroy( HashADT t );
 ///
 void ht_dump( const HashADT t, bool contents );
 
+/// The number of buckets in the probe and cluster histograms of HTStats
+#define HT_STATS_BUCKETS 32
+
+///
+/// A snapshot of table health, filled by ht_stats().
+///
+/// The histograms are log2 scaled: bucket 0 counts the value 0, and
+/// bucket k counts values in [2^(k-1), 2^k).  The last bucket also holds
+/// everything larger.
+///
+typedef struct HTStats {
+
+    /// Whether the library was built with HASHADT_STATS; without it the
+    /// lookup, hit, miss, insert, update and collision counters read 0
+    bool counters;
+
+    /// Number of keys, and number of buckets
+    uint64_t size;
+
+    uint64_t capacity;
+
+    /// Lookups by ht_has() or ht_get(), and whether they found the key
+    uint64_t lookups;
+
+    uint64_t hits;
+
+    uint64_t misses;
+
+    /// ht_put() calls that added a new key, and that replaced a value
+    uint64_t inserts;
+
+    uint64_t updates;
+
+    /// Occupied buckets stepped over by lookups, inserts and rehashes
+    uint64_t collisions;
+
+    /// Times the table grew, and times flooding forced a new seed
+    uint64_t rehashes;
+
+    uint64_t reseeds;
+
+    /// Pairs removed by HT_BUDGET_EVICT
+    uint64_t evictions;
+
+    /// Total nanoseconds spent moving pairs during rehashes
+    uint64_t rehash_ns;
+
+    /// Longest and mean distance of a stored key from its home bucket;
+    /// a lookup of the key probes this many extra buckets
+    uint64_t max_probe;
+
+    double mean_probe;
+
+    /// Stored keys by distance from their home bucket
+    uint64_t probe_histogram[HT_STATS_BUCKETS];
+
+    /// Runs of consecutive occupied buckets by length
+    uint64_t cluster_histogram[HT_STATS_BUCKETS];
+
+    /// Bytes the table allocated for itself (not keys or values)
+    uint64_t bytes_used;
+
+    /// Bytes of slabs holding the copies made by ht_put_copy()
+    uint64_t arena_bytes;
+
+} HTStats;
+
+///
+/// Collect statistics about the table, without printing anything.  The
+/// probe and cluster figures come from a scan of every bucket, which
+/// rehashes every key, so this costs about as much as a rehash.
+///
+/// @param t The table to measure
+/// @param stats Filled with the statistics
+///
+/// @pre t is a valid instance of table, and stats is not NULL.
+///
+void ht_stats( const HashADT t, HTStats *stats );
+
+///
+/// Count the times the table has moved its pairs to a new array, whether
+/// to grow or to reseed.  Unlike ht_stats() this costs nothing, so a
+/// caller can check it after every ht_put() to spot rehash pauses.
+///
+/// @param t The table
+///
+/// @pre t is a valid instance of table.
+///
+/// @return Rehashes plus reseeds so far
+///
+uint64_t ht_rehash_count( const HashADT t );
+
+///
+/// Count the bytes the table holds: the table itself, its bucket arrays
+/// (every node's copy) or layout storage, an array being prepared for the
+/// next growth, the ht_put_copy() slabs, the trace buffer, and what the
+/// pair_bytes option reports for the stored pairs.  The table itself
+/// includes a flat table's first 256 byte bucket array, which stays
+/// allocated after the first growth (see small_capacity in HTOptions).
+/// Costs no more than ht_rehash_count().
+///
+/// @param t The table
+///
+/// @pre t is a valid instance of table.
+///
+/// @return Bytes held
+///
+size_t ht_memory_usage( const HashADT t );
+
+///
+/// Tell why the last ht_put() or ht_put_copy() on the table stored
+/// nothing, or HT_OK if it stored its pair.
+///
+/// @param t The table
+///
+/// @pre t is a valid instance of table.
+///
+/// @return The outcome of the last put
+///
+HTError ht_error( const HashADT t );
+
+/// First bytes of every trace file, followed by an HTTraceHeader
+#define HT_TRACE_MAGIC "HTTRACE1"
+
+/// Most key bytes kept per trace record; longer keys are truncated
+#define HT_TRACE_MAX_KEY 256
+
+///
+/// The operation a trace record describes.
+///
+typedef enum HTTraceOp {
+    HT_TRACE_PUT,       ///< ht_put(); HT_TRACE_FOUND means it replaced a value
+    HT_TRACE_GET,       ///< ht_get()
+    HT_TRACE_HAS        ///< ht_has(); HT_TRACE_FOUND holds the answer
+} HTTraceOp;
+
+/// Flag bits of HTTraceRecord
+#define HT_TRACE_FOUND     0x01    ///< the key was already in the table
+#define HT_TRACE_TRUNCATED 0x02    ///< the key was longer than HT_TRACE_MAX_KEY
+
+/// Flag bit of HTTraceHeader: records carry key bytes
+#define HT_TRACE_KEY_BYTES 0x01
+
+///
+/// The file header written after HT_TRACE_MAGIC.  Records are stored in
+/// the byte order of the machine that wrote them; byte_order reads
+/// 0x01020304 when the reader shares it.
+///
+typedef struct HTTraceHeader {
+
+    uint32_t byte_order;
+
+    uint32_t record_size;       ///< sizeof(HTTraceRecord)
+
+    uint32_t flags;             ///< HT_TRACE_KEY_BYTES
+
+    uint32_t reserved;
+
+    uint64_t start_ns;          ///< CLOCK_MONOTONIC when tracing started
+
+} HTTraceHeader;
+
+///
+/// One traced operation.  It is followed in the file by key_length key
+/// bytes, when the trace has a key serializer.
+///
+typedef struct HTTraceRecord {
+
+    /// Nanoseconds since tracing started
+    uint64_t ns;
+
+    /// The client hash of the key, unseeded, so it identifies the key
+    /// across runs even when no key bytes are kept
+    uint64_t hash;
+
+    uint16_t key_length;
+
+    uint8_t op;                 ///< an HTTraceOp
+
+    uint8_t flags;              ///< HT_TRACE_FOUND, HT_TRACE_TRUNCATED
+
+    uint32_t reserved;
+
+} HTTraceRecord;
+
+///
+/// Start recording every ht_put(), ht_get() and ht_has() on the table to
+/// a file.  Records collect in a buffer of buffer_bytes that is written
+/// out whenever it fills, and by ht_trace_stop() or ht_destroy().  A
+/// table that is not tracing pays one untaken branch per operation.
+///
+/// @param t The table to trace
+/// @param path The file to create, replacing any file already there
+/// @param key_bytes Optional serializer that copies up to room bytes
+///        identifying key into buffer and returns how many it needs; with
+///        NULL only the key hash is recorded
+/// @param buffer_bytes Size of the record buffer; 0 picks 1 MiB
+///
+/// @exception Assert fails if it cannot allocate space
+///
+/// @pre t is a valid instance of table that is not already tracing.
+///
+/// @return false if the file could not be created
+///
+bool ht_trace_start(
+    HashADT t,
+    const char *path,
+    size_t (*key_bytes)( const void *key, void *buffer, size_t room ),
+    size_t buffer_bytes
+);
+
+///
+/// Write out any buffered records and close the trace file.  Does nothing
+/// if the table is not tracing.
+///
+/// @param t The table
+///
+/// @pre t is a valid instance of table.
+///
+/// @return false if writing the file failed at any point of the trace
+///
+bool ht_trace_stop( HashADT t );
+
 ///
 /// Get the value associated with a key from the table.  This function
 /// uses the registered hash function to locate the key, and the
@@ -109,7 +622,8 @@ void ht_dump( const HashADT t, bool contents );
 /// @pre has( t, key) is true.
 /// @pre t is a valid instance of table, and key is not NULL.
 /// 
-/// @return The value associated with the key
+/// @return The value associated with the key; with a value_size, a
+/// pointer to the table's copy of it
 ///
 const void *ht_get( const HashADT t, const void *key );
 
@@ -136,16 +650,62 @@ bool ht_has( const HashADT t, const void *key );
 /// @param key The key
 /// @param value The value
 /// 
-/// @exception Assert fails if it cannot allocate space
+/// @exception Assert fails if it cannot allocate space for anything but
+/// a larger flat bucket array
 /// 
 /// @pre t is a valid instance of table.
 /// 
-/// @post if size reached the LOAD_THRESHOLD, table has grown by RESIZE_FACTOR.
+/// @post if size reached the LOAD_THRESHOLD, table has grown by RESIZE_FACTOR,
+/// unless the memory budget or the allocator refused; then the budget
+/// policy decides, and ht_error() tells if the pair was not stored.
+/// @post if the insert probed past max_probe, table has a new random seed.
 /// 
-/// @return The old value associated with the key, if one exists.
+/// @return The old value associated with the key, if one exists, and NULL
+/// if the pair was not stored.  With a
+/// value_size, the copy has no old pointer: an update returns a pointer
+/// to the copy, now holding the new value, and an add returns NULL.
 ///
 void *ht_put( HashADT t, const void *key, const void *value );
 
+///
+/// Add a copy of a key and value to the table, or update an existing
+/// key's value with a copy.  The copies live in slabs the table owns and
+/// releases all at once in ht_destroy(), so a table of many small keys
+/// makes a few large allocations instead of one per key.
+///
+/// The key must be a flat object: the klen bytes at key are the whole key,
+/// as the table's hash and equals functions see it (a C string with its
+/// NUL, a uint64_t, a struct without pointers).  Copies start on a 16
+/// byte boundary.
+///
+/// The slabs count toward a memory budget.  When the budget leaves no room
+/// for the copies, or the table refuses the pair, nothing is copied or
+/// stored and ht_error() says why.  A slab cannot give back one pair's
+/// copies, so the table may not evict.
+///
+/// @param t The table
+/// @param key The bytes of the key
+/// @param klen The number of key bytes
+/// @param value The bytes of the value, or NULL when vlen is 0
+/// @param vlen The number of value bytes; 0 stores a NULL value.  With a
+///        value_size it must be value_size, and the value is copied into
+///        the table rather than a slab
+///
+/// @exception Assert fails if it cannot allocate space
+///
+/// @pre t is a valid instance of table created with a NULL delete function.
+/// @pre t's budget_policy is not HT_BUDGET_EVICT.
+/// @pre key is not NULL and klen is not 0.
+///
+/// @post if size reached the LOAD_THRESHOLD, table has grown by RESIZE_FACTOR.
+/// @post if the insert probed past max_probe, table has a new random seed.
+///
+/// @return The old value associated with the key, if one exists, and NULL
+/// if the pair was not stored, as for ht_put()
+///
+void *ht_put_copy( HashADT t, const void *key, size_t klen,
+    const void *value, size_t vlen );
+
 ///
 /// Get the collection of keys from the table.  This function allocates
 /// space to store the keys, which the caller is responsible for freeing.
@@ -156,7 +716,9 @@ void *ht_put( HashADT t, const void *key, const void *value );
 /// 
 /// @pre t is a valid instance of table.
 /// 
-/// @post client is responsible for freeing the returned array.
+/// @post client is responsible for freeing the returned array, with free()
+/// or, when the table has an allocator, with its free hook and a size of
+/// the key count times sizeof(void*).
 /// 
 /// @return A dynamic array of keys
 ///
@@ -172,7 +734,8 @@ void **ht_keys( const HashADT t );
 /// 
 /// @pre t is a valid instance of table.
 /// 
-/// @post client is responsible for freeing the returned array.
+/// @post client is responsible for freeing the returned array, as for
+/// ht_keys().
 /// 
 /// @return A dynamic array of values
 ///
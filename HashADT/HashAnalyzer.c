@@ -0,0 +1,401 @@
+//
+// File name: HashAnalyzer.c
+//
+// Description:
+// Statistical checks of a client hash function against the way HashADT
+// uses it (low bits, linear probing)
+//
+// @author Nick Creeley - nc8004
+//
+// version control:
+// git hw6 repository
+//
+// // // // // // // // // // // // // // // // // // // // // // // // // // // // // //
+
+//include standard libraries
+
+#include <stdbool.h>
+
+#include <stddef.h>
+
+#include <stdlib.h>
+
+#include <stdint.h>
+
+#include <assert.h>
+
+#include <stdio.h>
+
+#include <math.h>
+
+//include header files
+
+#include "HashADT.h"
+
+#include "HashAnalyzer.h"
+
+//the load factors simulated, up to past the rehash threshold
+
+static const double analyze_loads[HT_ANALYZE_LOADS] = { 0.25, 0.5, LOAD_THRESHOLD, 0.9 };
+
+//at most this many keys take part in the avalanche test
+
+#define AVALANCHE_KEYS 2000
+
+//the number of hash output bits checked by the avalanche test
+
+#define HASH_BITS (sizeof(size_t) * 8)
+
+/// log2_floor(): the index of the highest set bit
+
+static size_t log2_floor( size_t x ) {
+
+    size_t bits = 0;
+
+    while(x > 1) {
+
+        x >>= 1;
+
+        bits++;
+    }
+
+    return bits;
+}
+
+/// analyze_buckets(): chi-square, entropy and low bit bias of hash % buckets
+
+static void analyze_buckets( const size_t *hashes, size_t count, HashReport *report ) {
+
+    size_t buckets = report -> buckets;
+
+    size_t *counts = (size_t*)calloc(buckets, sizeof(size_t));
+
+    assert(counts != NULL);
+
+    size_t low_bits = log2_floor(buckets);
+
+    size_t ones[HASH_BITS] = { 0 };
+
+    for(size_t i = 0; i < count; i++) {
+
+        size_t index = hashes[i] % buckets;
+
+        counts[index]++;
+
+        for(size_t bit = 0; bit < low_bits; bit++) {
+
+            ones[bit] += (index >> bit) & 1;
+        }
+    }
+
+    //chi-square against the uniform expectation
+
+    double expected = (double) count / buckets;
+
+    double chi = 0.0;
+
+    double entropy = 0.0;
+
+    for(size_t i = 0; i < buckets; i++) {
+
+        double diff = counts[i] - expected;
+
+        chi += diff * diff / expected;
+
+        if(counts[i] > 0) {
+
+            double p = (double) counts[i] / count;
+
+            entropy -= p * log2(p);
+        }
+    }
+
+    double freedom = (double) buckets - 1;
+
+    report -> chi_square = chi;
+
+    report -> chi_square_z = (chi - freedom) / sqrt(2.0 * freedom);
+
+    report -> bucket_entropy = entropy;
+
+    //the entropy an ideal hash reaches; bounded by log2(count) for sparse samples
+
+    double ideal = log2((double) buckets);
+
+    if((double) count < buckets) {
+
+        ideal = log2((double) count);
+    }
+
+    report -> ideal_entropy = ideal;
+
+    //worst biased low bit
+
+    report -> low_bit_bias = 0.0;
+
+    for(size_t bit = 0; bit < low_bits; bit++) {
+
+        double bias = fabs((double) ones[bit] / count - 0.5);
+
+        if(bias > report -> low_bit_bias) {
+
+            report -> low_bit_bias = bias;
+        }
+    }
+
+    free(counts);
+}
+
+/// analyze_probes(): simulate ht_put's linear probing at one load factor
+///
+/// the hash values of the first load * capacity keys are placed in a
+/// bitmap of occupied buckets exactly the way HT_SEED_NONE tables do
+
+static void analyze_probes( const size_t *hashes, size_t count, double load,
+        HashLoadReport *result ) {
+
+    //largest power of two capacity, at least the initial one, that the
+    //sample fills to the wanted load
+
+    size_t capacity = INITIAL_CAPACITY;
+
+    while((double) capacity * 2 * load <= (double) count) {
+
+        capacity *= 2;
+    }
+
+    size_t inserted = (size_t) (capacity * load);
+
+    if(inserted > count) {
+
+        inserted = count;
+    }
+
+    bool *occupied = (bool*)calloc(capacity, sizeof(bool));
+
+    assert(occupied != NULL);
+
+    size_t total = 0;
+
+    size_t worst = 0;
+
+    for(size_t i = 0; i < inserted; i++) {
+
+        size_t index = hashes[i] % capacity;
+
+        size_t probes = 0;
+
+        while(occupied[index]) {
+
+            index = (index + 1) % capacity;
+
+            probes++;
+        }
+
+        occupied[index] = true;
+
+        total += probes;
+
+        if(probes > worst) {
+
+            worst = probes;
+        }
+    }
+
+    double actual = (double) inserted / capacity;
+
+    result -> load = actual;
+
+    result -> capacity = capacity;
+
+    result -> inserted = inserted;
+
+    result -> expected_probe = actual / (2.0 * (1.0 - actual));
+
+    result -> observed_probe = inserted > 0 ? (double) total / inserted : 0.0;
+
+    result -> max_probe = worst;
+
+    free(occupied);
+}
+
+/// analyze_avalanche(): how often each output bit flips per input bit
+
+static void analyze_avalanche( size_t (*hash)( const void *key ),
+        const void *const *keys, size_t count,
+        const HashKeyFlipper *flipper, HashReport *report ) {
+
+    size_t bits = flipper -> bits;
+
+    //flips[in * HASH_BITS + out] counts output bit out flipping for input bit in
+
+    size_t *flips = (size_t*)calloc(bits * HASH_BITS, sizeof(size_t));
+
+    size_t *trials = (size_t*)calloc(bits, sizeof(size_t));
+
+    assert(flips != NULL && trials != NULL);
+
+    if(count > AVALANCHE_KEYS) {
+
+        count = AVALANCHE_KEYS;
+    }
+
+    for(size_t k = 0; k < count; k++) {
+
+        size_t original = hash(keys[k]);
+
+        for(size_t in = 0; in < bits; in++) {
+
+            const void *flipped = flipper -> flip(flipper -> context, keys[k], in);
+
+            if(flipped == NULL) {
+                continue;
+            }
+
+            size_t diff = original ^ hash(flipped);
+
+            trials[in]++;
+
+            for(size_t out = 0; out < HASH_BITS; out++) {
+
+                flips[in * HASH_BITS + out] += (diff >> out) & 1;
+            }
+        }
+    }
+
+    double sum = 0.0;
+
+    double worst = 0.0;
+
+    size_t pairs = 0;
+
+    for(size_t in = 0; in < bits; in++) {
+
+        if(trials[in] == 0) {
+            continue;
+        }
+
+        for(size_t out = 0; out < HASH_BITS; out++) {
+
+            double bias = fabs((double) flips[in * HASH_BITS + out] / trials[in] - 0.5);
+
+            sum += bias;
+
+            pairs++;
+
+            if(bias > worst) {
+
+                worst = bias;
+            }
+        }
+    }
+
+    report -> avalanche_tested = pairs > 0;
+
+    report -> avalanche_mean_bias = pairs > 0 ? sum / pairs : 0.0;
+
+    report -> avalanche_worst_bias = worst;
+
+    free(flips);
+
+    free(trials);
+}
+
+/// ht_analyze_hash(): run all checks
+///
+/// see headerfile for full documentation
+
+void ht_analyze_hash(
+    size_t (*hash)( const void *key ),
+    const void *const *keys,
+    size_t count,
+    const HashKeyFlipper *flipper,
+    HashReport *report
+) {
+
+    assert(hash != NULL && keys != NULL && report != NULL);
+
+    assert(count > 0);
+
+    //hash every key once
+
+    size_t *hashes = (size_t*)malloc(count * sizeof(size_t));
+
+    assert(hashes != NULL);
+
+    for(size_t i = 0; i < count; i++) {
+
+        hashes[i] = hash(keys[i]);
+    }
+
+    report -> key_count = count;
+
+    //the capacity a HashADT holding every key would have
+
+    report -> buckets = INITIAL_CAPACITY;
+
+    while((double) count / report -> buckets >= LOAD_THRESHOLD) {
+
+        report -> buckets *= RESIZE_FACTOR;
+    }
+
+    analyze_buckets(hashes, count, report);
+
+    for(size_t i = 0; i < HT_ANALYZE_LOADS; i++) {
+
+        analyze_probes(hashes, count, analyze_loads[i], &report -> loads[i]);
+    }
+
+    report -> avalanche_tested = false;
+
+    report -> avalanche_mean_bias = 0.0;
+
+    report -> avalanche_worst_bias = 0.0;
+
+    if(flipper != NULL && flipper -> bits > 0) {
+
+        analyze_avalanche(hash, keys, count, flipper, report);
+    }
+
+    free(hashes);
+}
+
+/// ht_print_hash_report(): print a report
+///
+/// see headerfile for full documentation
+
+void ht_print_hash_report( const HashReport *report, FILE *out ) {
+
+    fprintf(out, "Keys: %zu\n", report -> key_count);
+
+    fprintf(out, "Buckets: %zu\n", report -> buckets);
+
+    fprintf(out, "Chi-square: %.1f (z = %.2f)\n",
+        report -> chi_square, report -> chi_square_z);
+
+    fprintf(out, "Bucket entropy: %.3f of %.3f bits\n",
+        report -> bucket_entropy, report -> ideal_entropy);
+
+    fprintf(out, "Low bit bias: %.4f\n", report -> low_bit_bias);
+
+    if(report -> avalanche_tested) {
+
+        fprintf(out, "Avalanche bias: mean %.4f, worst %.4f\n",
+            report -> avalanche_mean_bias, report -> avalanche_worst_bias);
+
+    } else {
+
+        fprintf(out, "Avalanche bias: not tested\n");
+    }
+
+    fprintf(out, "Load   Capacity   Expected probe   Observed probe   Max probe\n");
+
+    for(size_t i = 0; i < HT_ANALYZE_LOADS; i++) {
+
+        const HashLoadReport *load = &report -> loads[i];
+
+        fprintf(out, "%.2f   %8zu   %14.3f   %14.3f   %9zu\n",
+            load -> load, load -> capacity, load -> expected_probe,
+            load -> observed_probe, load -> max_probe);
+    }
+}
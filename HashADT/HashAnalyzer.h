@@ -0,0 +1,147 @@
+/// \file HashAnalyzer.h
+/// \brief Measure how well a client hash function suits HashADT.
+///
+/// @author Nick Creeley - nc8004
+
+#ifndef HASHANALYZER_H
+#define HASHANALYZER_H
+
+#include <stdbool.h>    // bool
+#include <stddef.h>     // size_t
+#include <stdio.h>      // FILE
+
+///
+/// General Notes on the hash analyzer
+///
+/// - HashADT places a key at hash % capacity and probes linearly, with a
+///   capacity that is always a power of two.  A hash function is only as
+///   good as the low bits it produces, so every measurement below looks at
+///   hash % capacity rather than the full hash value.
+///
+/// - The sample keys should be distinct.  Duplicate keys hash alike and
+///   are counted against the hash function.
+///
+/// - Probe lengths are counted the way ht_put() counts collisions: one
+///   per occupied bucket stepped over before the key finds its place.
+///
+
+/// The load factors at which linear probing is simulated
+#define HT_ANALYZE_LOADS 4
+
+///
+/// Probe length measurements for one simulated load factor.
+///
+typedef struct HashLoadReport {
+
+    /// The load factor simulated (occupancy / capacity)
+    double load;
+
+    /// The capacity used, and the number of sample keys inserted
+    size_t capacity;
+
+    size_t inserted;
+
+    /// Mean collisions per insert that linear probing with an ideal
+    /// hash would give at this load: load / (2 (1 - load))
+    double expected_probe;
+
+    /// Mean and worst collisions per insert with the client hash
+    double observed_probe;
+
+    size_t max_probe;
+
+} HashLoadReport;
+
+///
+/// Everything ht_analyze_hash() measures about a hash function.
+///
+typedef struct HashReport {
+
+    /// The number of sample keys hashed
+    size_t key_count;
+
+    /// Buckets used for the distribution tests (the power of two HashADT
+    /// would grow to for key_count keys)
+    size_t buckets;
+
+    /// Pearson chi-square of the bucket counts, and its distance from the
+    /// ideal in standard deviations; |z| above ~3 is suspicious
+    double chi_square;
+
+    double chi_square_z;
+
+    /// Shannon entropy of hash % buckets in bits, and the ideal value for
+    /// this many keys and buckets
+    double bucket_entropy;
+
+    double ideal_entropy;
+
+    /// Worst |P(bit set) - 0.5| over the low log2(buckets) bits
+    double low_bit_bias;
+
+    /// Whether the avalanche test ran (it needs a key flipper)
+    bool avalanche_tested;
+
+    /// Mean and worst |P(output bit flips) - 0.5| over every pair of
+    /// flipped input bit and output bit; 0 is ideal, 0.5 is hopeless
+    double avalanche_mean_bias;
+
+    double avalanche_worst_bias;
+
+    /// Linear probing simulated at HT_ANALYZE_LOADS load factors
+    HashLoadReport loads[HT_ANALYZE_LOADS];
+
+} HashReport;
+
+///
+/// Produces copies of a key with a single bit flipped, for the avalanche
+/// test.  Keys are opaque to the analyzer, so only the client knows how
+/// to build a flipped key.
+///
+typedef struct HashKeyFlipper {
+
+    /// Return key with input bit flipped, or NULL if the key has no such
+    /// bit (e.g. a short string).  The result only needs to stay valid
+    /// until the next call.
+    const void *(*flip)( void *context, const void *key, size_t bit );
+
+    /// The number of input bits to try, starting from bit 0
+    size_t bits;
+
+    /// Passed to flip
+    void *context;
+
+} HashKeyFlipper;
+
+///
+/// Run a hash function over a sample of keys and measure it.
+///
+/// @param hash The hash function under test
+/// @param keys The sample keys
+/// @param count The number of sample keys
+/// @param flipper How to flip key bits, or NULL to skip the avalanche test
+/// @param report Filled with the measurements
+///
+/// @exception Assert fails if it cannot allocate space
+///
+/// @pre hash, keys and report are not NULL, and count is at least 1.
+///
+void ht_analyze_hash(
+    size_t (*hash)( const void *key ),
+    const void *const *keys,
+    size_t count,
+    const HashKeyFlipper *flipper,
+    HashReport *report
+);
+
+///
+/// Print a report in a human readable form.
+///
+/// @param report The report to print
+/// @param out The stream to print to
+///
+/// @pre report and out are not NULL.
+///
+void ht_print_hash_report( const HashReport *report, FILE *out );
+
+#endif // HASHANALYZER_H
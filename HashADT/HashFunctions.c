@@ -0,0 +1,583 @@
+//
+// File name: HashFunctions.c
+//
+// Description:
+// Bundled hash and equals callbacks for HashADT, with the byte hashing
+// variant picked from the CPU features at startup
+//
+// @author Nick Creeley - nc8004
+//
+// version control:
+// git hw6 repository
+//
+// // // // // // // // // // // // // // // // // // // // // // // // // // // // // //
+
+//include standard libraries
+
+#include <stdbool.h>
+
+#include <stddef.h>
+
+#include <stdint.h>
+
+#include <string.h>
+
+//include header file
+
+#include "HashFunctions.h"
+
+//the x86 variants need gcc/clang target attributes and cpuid support
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define HT_HASH_X86 1
+#include <nmmintrin.h>
+#include <wmmintrin.h>
+#else
+#define HT_HASH_X86 0
+#endif
+
+//odd 64-bit constants used by the multiply/fold hash
+
+#define P0 0xa0761d6478bd642fULL
+#define P1 0xe7037ed1a0b428dbULL
+#define P2 0x8ebc6af09c88c6e3ULL
+#define P3 0x589965cc75374cc3ULL
+
+/// read64(): unaligned little endian 64-bit load
+
+static inline uint64_t read64( const uint8_t *p ) {
+
+    uint64_t v;
+
+    memcpy(&v, p, sizeof(v));
+
+    return v;
+}
+
+/// read32(): unaligned little endian 32-bit load
+
+static inline uint64_t read32( const uint8_t *p ) {
+
+    uint32_t v;
+
+    memcpy(&v, p, sizeof(v));
+
+    return v;
+}
+
+/// mum(): multiply two 64-bit values into 128 bits and fold the halves
+
+static inline uint64_t mum( uint64_t a, uint64_t b ) {
+
+#if defined(__SIZEOF_INT128__)
+
+    __uint128_t r = (__uint128_t) a * b;
+
+    return (uint64_t) r ^ (uint64_t) (r >> 64);
+
+#else
+
+    //portable 64x64 -> 128 multiply from 32-bit halves
+
+    uint64_t ha = a >> 32, la = (uint32_t) a;
+
+    uint64_t hb = b >> 32, lb = (uint32_t) b;
+
+    uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+
+    uint64_t t = rl + (rm0 << 32);
+
+    uint64_t c = t < rl;
+
+    uint64_t lo = t + (rm1 << 32);
+
+    c += lo < t;
+
+    uint64_t hi = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+
+    return lo ^ hi;
+
+#endif
+}
+
+/// ht_mix64(): murmur3 64-bit finalizer
+///
+/// see headerfile for full documentation
+
+uint64_t ht_mix64( uint64_t x ) {
+
+    x ^= x >> 33;
+
+    x *= 0xff51afd7ed558ccdULL;
+
+    x ^= x >> 33;
+
+    x *= 0xc4ceb9fe1a85ec53ULL;
+
+    x ^= x >> 33;
+
+    return x;
+}
+
+/// hash_portable(): wyhash-style multiply/fold hash, works everywhere
+
+static size_t hash_portable( const void *data, size_t length, uint64_t seed ) {
+
+    const uint8_t *p = (const uint8_t *) data;
+
+    uint64_t a, b;
+
+    seed ^= mum(seed ^ P0, P1);
+
+    if(length <= 16) {
+
+        if(length >= 4) {
+
+            //two overlapping 4 byte reads from each end cover 4..16 bytes
+
+            size_t shift = (length >> 3) << 2;
+
+            a = (read32(p) << 32) | read32(p + shift);
+
+            b = (read32(p + length - 4) << 32) | read32(p + length - 4 - shift);
+
+        } else if(length > 0) {
+
+            a = ((uint64_t) p[0] << 16) | ((uint64_t) p[length >> 1] << 8) | p[length - 1];
+
+            b = 0;
+
+        } else {
+
+            a = b = 0;
+        }
+
+    } else {
+
+        size_t i = length;
+
+        if(i > 48) {
+
+            //three independent lanes keep the multipliers busy
+
+            uint64_t s1 = seed, s2 = seed;
+
+            do {
+
+                seed = mum(read64(p) ^ P1, read64(p + 8) ^ seed);
+
+                s1 = mum(read64(p + 16) ^ P2, read64(p + 24) ^ s1);
+
+                s2 = mum(read64(p + 32) ^ P3, read64(p + 40) ^ s2);
+
+                p += 48;
+
+                i -= 48;
+
+            } while(i > 48);
+
+            seed ^= s1 ^ s2;
+        }
+
+        while(i > 16) {
+
+            seed = mum(read64(p) ^ P1, read64(p + 8) ^ seed);
+
+            p += 16;
+
+            i -= 16;
+        }
+
+        //the last 16 bytes, overlapping what was already consumed
+
+        a = read64(p + i - 16);
+
+        b = read64(p + i - 8);
+    }
+
+    return (size_t) mum(P1 ^ length, mum(a ^ P1, b ^ seed));
+}
+
+#if HT_HASH_X86
+
+/// hash_crc32c(): two crc32c lanes over 16 byte strides, then mixed
+///
+/// crc32 alone only yields 32 bits and is linear, so the lanes are
+/// combined and run through the 64-bit finalizer
+
+__attribute__((target("sse4.2")))
+static size_t hash_crc32c( const void *data, size_t length, uint64_t seed ) {
+
+    const uint8_t *p = (const uint8_t *) data;
+
+    uint64_t lo = (uint32_t) seed;
+
+    uint64_t hi = (uint32_t) (seed >> 32) ^ 0x9e3779b9U;
+
+    size_t i = length;
+
+    while(i >= 16) {
+
+        lo = _mm_crc32_u64(lo, read64(p));
+
+        hi = _mm_crc32_u64(hi, read64(p + 8));
+
+        p += 16;
+
+        i -= 16;
+    }
+
+    if(i >= 8) {
+
+        lo = _mm_crc32_u64(lo, read64(p));
+
+        p += 8;
+
+        i -= 8;
+    }
+
+    if(i > 0) {
+
+        //pad the remaining bytes with zeros, the length mix keeps them apart
+
+        uint64_t tail = 0;
+
+        memcpy(&tail, p, i);
+
+        hi = _mm_crc32_u64(hi, tail);
+    }
+
+    return (size_t) ht_mix64(((hi << 32) | lo) ^ (length * P0));
+}
+
+/// hash_aesni(): one aes round per 16 byte block, two to finalize
+
+__attribute__((target("aes,sse4.1")))
+static size_t hash_aesni( const void *data, size_t length, uint64_t seed ) {
+
+    const uint8_t *p = (const uint8_t *) data;
+
+    __m128i key = _mm_set_epi64x((long long) (seed ^ P0), (long long) (length ^ P1));
+
+    __m128i state = _mm_set_epi64x((long long) P2, (long long) (seed ^ P3));
+
+    size_t i = length;
+
+    while(i >= 16) {
+
+        __m128i block = _mm_loadu_si128((const __m128i *) p);
+
+        state = _mm_aesenc_si128(_mm_xor_si128(state, block), key);
+
+        p += 16;
+
+        i -= 16;
+    }
+
+    if(i > 0) {
+
+        uint8_t tail[16] = { 0 };
+
+        memcpy(tail, p, i);
+
+        __m128i block = _mm_loadu_si128((const __m128i *) tail);
+
+        state = _mm_aesenc_si128(_mm_xor_si128(state, block), key);
+    }
+
+    state = _mm_aesenc_si128(state, key);
+
+    state = _mm_aesenc_si128(state, key);
+
+    uint64_t low = (uint64_t) _mm_cvtsi128_si64(state);
+
+    uint64_t high = (uint64_t) _mm_extract_epi64(state, 1);
+
+    return (size_t) (low ^ high);
+}
+
+#endif
+
+/// hash_routine(): pick the byte hash routine for a variant, if supported
+
+static size_t (*hash_routine( HTHashImpl impl ))( const void *, size_t, uint64_t ) {
+
+#if HT_HASH_X86
+
+    __builtin_cpu_init();
+
+    if(impl == HT_HASH_AESNI && __builtin_cpu_supports("aes")
+            && __builtin_cpu_supports("sse4.1")) {
+
+        return hash_aesni;
+    }
+
+    if(impl == HT_HASH_CRC32C && __builtin_cpu_supports("sse4.2")) {
+
+        return hash_crc32c;
+    }
+
+#endif
+
+    if(impl == HT_HASH_PORTABLE) {
+
+        return hash_portable;
+    }
+
+    return NULL;
+}
+
+//the variant in use, and the routine that implements it
+
+static HTHashImpl hash_impl = HT_HASH_PORTABLE;
+
+static size_t (*hash_fcn)( const void *data, size_t length, uint64_t seed ) = NULL;
+
+/// hash_init(): choose the best supported variant, runs at startup
+
+#if defined(__GNUC__) || defined(__clang__)
+__attribute__((constructor))
+#endif
+static void hash_init( void ) {
+
+    //fastest and strongest first
+
+    static const HTHashImpl preference[] = {
+        HT_HASH_AESNI, HT_HASH_CRC32C, HT_HASH_PORTABLE
+    };
+
+    for(size_t i = 0; i < sizeof(preference) / sizeof(preference[0]); i++) {
+
+        size_t (*routine)( const void *, size_t, uint64_t ) = hash_routine(preference[i]);
+
+        if(routine != NULL) {
+
+            hash_impl = preference[i];
+
+            hash_fcn = routine;
+
+            return;
+        }
+    }
+}
+
+/// ht_hash_buffer(): hash bytes with the selected variant
+///
+/// see headerfile for full documentation
+
+size_t ht_hash_buffer( const void *data, size_t length, uint64_t seed ) {
+
+    //compilers without constructors resolve on first use
+
+    if(hash_fcn == NULL) {
+
+        hash_init();
+    }
+
+    return hash_fcn(data, length, seed);
+}
+
+/// ht_hash_implementation(): report the selected variant
+///
+/// see headerfile for full documentation
+
+HTHashImpl ht_hash_implementation( void ) {
+
+    if(hash_fcn == NULL) {
+
+        hash_init();
+    }
+
+    return hash_impl;
+}
+
+/// ht_hash_select(): force a variant
+///
+/// see headerfile for full documentation
+
+bool ht_hash_select( HTHashImpl impl ) {
+
+    size_t (*routine)( const void *, size_t, uint64_t ) = hash_routine(impl);
+
+    if(routine == NULL) {
+
+        return false;
+    }
+
+    hash_impl = impl;
+
+    hash_fcn = routine;
+
+    return true;
+}
+
+/// ht_hash_cstr(): hash callback for strings
+///
+/// see headerfile for full documentation
+
+size_t ht_hash_cstr( const void *key ) {
+
+    const char *str = (const char *) key;
+
+    return ht_hash_buffer(str, strlen(str), 0);
+}
+
+/// ht_equals_cstr(): equals callback for strings
+///
+/// see headerfile for full documentation
+
+bool ht_equals_cstr( const void *key1, const void *key2 ) {
+
+    return strcmp((const char *) key1, (const char *) key2) == 0;
+}
+
+/// ht_hash_u64(): hash callback for 64-bit integers
+///
+/// see headerfile for full documentation
+
+size_t ht_hash_u64( const void *key ) {
+
+    return (size_t) ht_mix64(*(const uint64_t *) key);
+}
+
+/// ht_equals_u64(): equals callback for 64-bit integers
+///
+/// see headerfile for full documentation
+
+bool ht_equals_u64( const void *key1, const void *key2 ) {
+
+    return *(const uint64_t *) key1 == *(const uint64_t *) key2;
+}
+
+/// ht_hash_bytes(): hash callback for HashBytes keys
+///
+/// see headerfile for full documentation
+
+size_t ht_hash_bytes( const void *key ) {
+
+    const HashBytes *bytes = (const HashBytes *) key;
+
+    return ht_hash_buffer(bytes -> data, bytes -> length, 0);
+}
+
+/// ht_equals_bytes(): equals callback for HashBytes keys
+///
+/// see headerfile for full documentation
+
+bool ht_equals_bytes( const void *key1, const void *key2 ) {
+
+    const HashBytes *a = (const HashBytes *) key1;
+
+    const HashBytes *b = (const HashBytes *) key2;
+
+    return a -> length == b -> length
+        && (a -> length == 0 || memcmp(a -> data, b -> data, a -> length) == 0);
+}
+
+//one siphash round over the four state words
+
+#define ROTL(x, b) (uint64_t) (((x) << (b)) | ((x) >> (64 - (b))))
+
+#define SIPROUND(v0, v1, v2, v3) do { \
+    v0 += v1; v1 = ROTL(v1, 13); v1 ^= v0; v0 = ROTL(v0, 32); \
+    v2 += v3; v3 = ROTL(v3, 16); v3 ^= v2; \
+    v0 += v3; v3 = ROTL(v3, 21); v3 ^= v0; \
+    v2 += v1; v1 = ROTL(v1, 17); v1 ^= v2; v2 = ROTL(v2, 32); \
+} while(0)
+
+/// ht_siphash13(): SipHash with one compression and three finalization rounds
+///
+/// see headerfile for full documentation
+
+uint64_t ht_siphash13( const void *data, size_t length, uint64_t k0, uint64_t k1 ) {
+
+    const uint8_t *p = (const uint8_t *) data;
+
+    uint64_t v0 = k0 ^ 0x736f6d6570736575ULL;
+
+    uint64_t v1 = k1 ^ 0x646f72616e646f6dULL;
+
+    uint64_t v2 = k0 ^ 0x6c7967656e657261ULL;
+
+    uint64_t v3 = k1 ^ 0x7465646279746573ULL;
+
+    size_t i = length;
+
+    while(i >= 8) {
+
+        uint64_t m = read64(p);
+
+        v3 ^= m;
+
+        SIPROUND(v0, v1, v2, v3);
+
+        v0 ^= m;
+
+        p += 8;
+
+        i -= 8;
+    }
+
+    //the last block holds the leftover bytes and the length in the top byte
+
+    uint64_t last = (uint64_t) length << 56;
+
+    for(size_t j = 0; j < i; j++) {
+
+        last |= (uint64_t) p[j] << (8 * j);
+    }
+
+    v3 ^= last;
+
+    SIPROUND(v0, v1, v2, v3);
+
+    v0 ^= last;
+
+    v2 ^= 0xff;
+
+    SIPROUND(v0, v1, v2, v3);
+
+    SIPROUND(v0, v1, v2, v3);
+
+    SIPROUND(v0, v1, v2, v3);
+
+    return v0 ^ v1 ^ v2 ^ v3;
+}
+
+/// siphash_seeded(): expand a 64-bit table seed into the 128-bit key
+
+static size_t siphash_seeded( const void *data, size_t length, uint64_t seed ) {
+
+    return (size_t) ht_siphash13(data, length, seed, ht_mix64(seed ^ P2));
+}
+
+/// ht_hash_cstr_keyed(): keyed hash callback for strings
+///
+/// see headerfile for full documentation
+
+size_t ht_hash_cstr_keyed( const void *key, uint64_t seed ) {
+
+    const char *str = (const char *) key;
+
+    return siphash_seeded(str, strlen(str), seed);
+}
+
+/// ht_hash_u64_keyed(): keyed hash callback for 64-bit integers
+///
+/// see headerfile for full documentation
+
+size_t ht_hash_u64_keyed( const void *key, uint64_t seed ) {
+
+    return siphash_seeded(key, sizeof(uint64_t), seed);
+}
+
+/// ht_hash_bytes_keyed(): keyed hash callback for HashBytes keys
+///
+/// see headerfile for full documentation
+
+size_t ht_hash_bytes_keyed( const void *key, uint64_t seed ) {
+
+    const HashBytes *bytes = (const HashBytes *) key;
+
+    return siphash_seeded(bytes -> data, bytes -> length, seed);
+}
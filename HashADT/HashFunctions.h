@@ -0,0 +1,196 @@
+/// \file HashFunctions.h
+/// \brief Ready-made hash and equals callbacks for HashADT clients.
+///
+/// @author Nick Creeley - nc8004
+
+#ifndef HASHFUNCTIONS_H
+#define HASHFUNCTIONS_H
+
+#include <stdbool.h>    // bool
+#include <stddef.h>     // size_t
+#include <stdint.h>     // uint64_t
+
+///
+/// General Notes on the bundled hash functions
+///
+/// - Every ht_hash_* function below matches the hash parameter of
+///   ht_create(), and every ht_equals_* function matches its equals
+///   parameter, so clients can pass them directly.
+///
+/// - The byte hashing routine comes in several variants: a portable
+///   wyhash-style multiply/fold hash, an SSE4.2 CRC32C hash and an AES-NI
+///   hash.  The best variant the CPU supports is chosen (via cpuid) when
+///   the program starts; ht_hash_implementation() reports which one.
+///
+/// - Hash values are only stable within one process.  Different variants
+///   (and therefore different machines) produce different values, so hash
+///   values must never be persisted.
+///
+/// - The unkeyed functions do not protect a table from deliberately
+///   colliding keys.  The *_keyed functions run SipHash-1-3 under a secret
+///   seed and match the keyed_hash member of HTOptions (see HashADT.h).
+///
+
+///
+/// The byte hashing variants that can be selected.
+///
+typedef enum HTHashImpl {
+    HT_HASH_PORTABLE,   ///< wyhash-style 64-bit multiply and fold
+    HT_HASH_CRC32C,     ///< SSE4.2 crc32 instruction, two lanes
+    HT_HASH_AESNI       ///< AES-NI rounds over 16 byte blocks
+} HTHashImpl;
+
+///
+/// Key type understood by ht_hash_bytes() and ht_equals_bytes(): a
+/// pointer to length bytes of key data.
+///
+typedef struct HashBytes {
+    const void *data;
+    size_t length;
+} HashBytes;
+
+///
+/// Hash a buffer of bytes with the selected variant.
+///
+/// @param data The bytes to hash
+/// @param length The number of bytes at data
+/// @param seed A value mixed into the hash; 0 is fine for unkeyed use
+///
+/// @pre data is not NULL unless length is 0.
+///
+/// @return The hash value of the bytes
+///
+size_t ht_hash_buffer( const void *data, size_t length, uint64_t seed );
+
+///
+/// Mix the bits of a 64-bit integer so every input bit affects every
+/// output bit (the murmur3 finalizer).  Useful to post-process a weak
+/// integer hash.
+///
+/// @param x The value to mix
+///
+/// @return The mixed value
+///
+uint64_t ht_mix64( uint64_t x );
+
+///
+/// Hash callback for NUL terminated strings.
+///
+/// @param key A const char *
+///
+/// @return The hash value of the string contents
+///
+size_t ht_hash_cstr( const void *key );
+
+///
+/// Equals callback for NUL terminated strings.
+///
+/// @param key1 A const char *
+/// @param key2 A const char *
+///
+/// @return Whether the strings have the same contents
+///
+bool ht_equals_cstr( const void *key1, const void *key2 );
+
+///
+/// Hash callback for 64-bit unsigned integer keys.
+///
+/// @param key A const uint64_t *
+///
+/// @return The mixed integer value
+///
+size_t ht_hash_u64( const void *key );
+
+///
+/// Equals callback for 64-bit unsigned integer keys.
+///
+/// @param key1 A const uint64_t *
+/// @param key2 A const uint64_t *
+///
+/// @return Whether the integers are equal
+///
+bool ht_equals_u64( const void *key1, const void *key2 );
+
+///
+/// Hash callback for HashBytes keys.
+///
+/// @param key A const HashBytes *
+///
+/// @return The hash value of the referenced bytes
+///
+size_t ht_hash_bytes( const void *key );
+
+///
+/// Equals callback for HashBytes keys.
+///
+/// @param key1 A const HashBytes *
+/// @param key2 A const HashBytes *
+///
+/// @return Whether both keys reference the same length and bytes
+///
+bool ht_equals_bytes( const void *key1, const void *key2 );
+
+///
+/// Report the byte hashing variant currently in use.
+///
+/// @return The variant chosen at startup or by ht_hash_select()
+///
+HTHashImpl ht_hash_implementation( void );
+
+///
+/// Force a byte hashing variant, e.g. to compare variants in a benchmark.
+/// This changes every hash value, so it must only be called while no
+/// table built with the bundled callbacks is alive.
+///
+/// @param impl The variant to use
+///
+/// @return false if the CPU does not support impl (nothing changes)
+///
+bool ht_hash_select( HTHashImpl impl );
+
+///
+/// Keyed SipHash-1-3 of a buffer of bytes.  Without the key, an attacker
+/// cannot predict which inputs collide.
+///
+/// @param data The bytes to hash
+/// @param length The number of bytes at data
+/// @param k0 The low half of the 128-bit key
+/// @param k1 The high half of the 128-bit key
+///
+/// @pre data is not NULL unless length is 0.
+///
+/// @return The 64-bit SipHash-1-3 value
+///
+uint64_t ht_siphash13( const void *data, size_t length, uint64_t k0, uint64_t k1 );
+
+///
+/// Keyed hash callback for NUL terminated strings.
+///
+/// @param key A const char *
+/// @param seed The table seed
+///
+/// @return The SipHash-1-3 value of the string contents under seed
+///
+size_t ht_hash_cstr_keyed( const void *key, uint64_t seed );
+
+///
+/// Keyed hash callback for 64-bit unsigned integer keys.
+///
+/// @param key A const uint64_t *
+/// @param seed The table seed
+///
+/// @return The SipHash-1-3 value of the integer under seed
+///
+size_t ht_hash_u64_keyed( const void *key, uint64_t seed );
+
+///
+/// Keyed hash callback for HashBytes keys.
+///
+/// @param key A const HashBytes *
+/// @param seed The table seed
+///
+/// @return The SipHash-1-3 value of the referenced bytes under seed
+///
+size_t ht_hash_bytes_keyed( const void *key, uint64_t seed );
+
+#endif // HASHFUNCTIONS_H
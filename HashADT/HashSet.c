@@ -0,0 +1,214 @@
+//
+// File name: HashSet.c
+//
+// Description:
+// Implementation of the HashSet functions: a HashADT table of the
+// structure-of-arrays layout whose values are all NULL, so it never makes
+// a value array.
+//
+// @author Nick Creeley - nc8004
+//
+// version control:
+// git hw6 repository
+//
+// // // // // // // // // // // // // // // // // // // // // // // // // // // // // //
+
+//include standard libraries
+
+#include <stdbool.h>
+
+#include <stddef.h>
+
+#include <stdlib.h>
+
+#include <assert.h>
+
+//include header files
+
+#include "HashSet.h"
+
+#include "HTLayout.h"
+
+/// The set: its table and the client's key delete function
+
+struct hashset_s {
+
+    HashADT table;
+
+    void (*delete_fcn)(void *key);
+
+};
+
+/// hs_print_nothing(): print callback required by ht_create_opts; a set
+/// has no dump of its own
+
+static void hs_print_nothing( const void *key, const void *value ) {
+
+    (void) key;
+
+    (void) value;
+}
+
+/// hs_delete_key(): hand a stored key to the client's delete fcn
+
+static void hs_delete_key( void *context, void *key, void *value ) {
+
+    HashSet s = (HashSet) context;
+
+    (void) value;
+
+    s -> delete_fcn(key);
+}
+
+/// hs_create(): the set create function
+///
+/// see headerfile for full documentation
+
+HashSet hs_create(
+    size_t (*hash)( const void *key ),
+    bool (*equals)( const void *key1, const void *key2 ),
+    void (*delete)( void *key )
+) {
+
+    return hs_create_opts(hash, equals, delete, NULL);
+}
+
+/// hs_create_opts(): the set create function with options
+///
+/// see headerfile for full documentation
+
+HashSet hs_create_opts(
+    size_t (*hash)( const void *key ),
+    bool (*equals)( const void *key1, const void *key2 ),
+    void (*delete)( void *key ),
+    const HTOptions *options
+) {
+
+    HTOptions set_options;
+
+    if(options != NULL) {
+
+        set_options = *options;
+
+    } else {
+
+        ht_options_init(&set_options);
+    }
+
+    //a budget needs the flat layout, and a set has no values to copy
+
+    set_options.layout = HT_LAYOUT_SOA;
+
+    set_options.memory_budget = 0;
+
+    set_options.value_size = 0;
+
+    //the set deletes keys itself, the table's delete fcn would also get
+    //the value
+
+    HashADT table = ht_create_opts(hash, equals, hs_print_nothing, NULL, &set_options);
+
+    //the set lives in the table's memory, from the table's allocator
+
+    HashSet new = (HashSet) ht_layout_alloc(table, sizeof(struct hashset_s));
+
+    assert(new != NULL);
+
+    new -> table = table;
+
+    new -> delete_fcn = delete;
+
+    return new;
+}
+
+/// hs_destroy(): the set destroy function
+///
+/// see headerfile for full documentation
+
+void hs_destroy( HashSet s ) {
+
+    assert(s != NULL);
+
+    HashADT table = s -> table;
+
+    if(s -> delete_fcn != NULL) {
+
+        ht_each(table, hs_delete_key, s);
+    }
+
+    ht_layout_free(table, s, sizeof(struct hashset_s));
+
+    ht_destroy(table);
+}
+
+/// hs_insert(): add a key to the set
+///
+/// see headerfile for full documentation
+
+bool hs_insert( HashSet s, const void *key ) {
+
+    assert(s != NULL && key != NULL);
+
+    size_t occupancy = ht_occupancy(s -> table);
+
+    ht_put(s -> table, key, NULL);
+
+    return ht_occupancy(s -> table) != occupancy;
+}
+
+/// hs_contains(): check if the set has a key
+///
+/// see headerfile for full documentation
+
+bool hs_contains( const HashSet s, const void *key ) {
+
+    assert(s != NULL && key != NULL);
+
+    return ht_has(s -> table, key);
+}
+
+/// hs_remove(): take a key out of the set
+///
+/// see headerfile for full documentation
+
+bool hs_remove( HashSet s, const void *key ) {
+
+    assert(s != NULL && key != NULL);
+
+    void *stored_key;
+
+    void *value;
+
+    if(!ht_remove(s -> table, key, &stored_key, &value)) {
+        return false;
+    }
+
+    if(s -> delete_fcn != NULL) {
+
+        s -> delete_fcn(stored_key);
+    }
+
+    return true;
+}
+
+/// hs_size(): count the keys
+///
+/// see headerfile for full documentation
+
+size_t hs_size( const HashSet s ) {
+
+    assert(s != NULL);
+
+    return ht_occupancy(s -> table);
+}
+
+/// hs_table(): the set's table
+///
+/// see headerfile for full documentation
+
+HashADT hs_table( const HashSet s ) {
+
+    assert(s != NULL);
+
+    return s -> table;
+}
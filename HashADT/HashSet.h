@@ -0,0 +1,159 @@
+/// \file HashSet.h
+/// \brief A generic hash set: HashADT storing keys only.
+///
+/// @author Nick Creeley - nc8004
+
+#ifndef HASHSET_H
+#define HASHSET_H
+
+#include <stdbool.h>    // bool
+#include <stddef.h>     // size_t
+
+#include "HashADT.h"
+
+///
+/// General Notes on HashSet Operation
+///
+/// - A HashSet is a HashADT table of the HT_LAYOUT_SOA layout whose
+///   values are all NULL.  That layout makes no value array until a value
+///   arrives, so a set holds an 8 byte key pointer and a 1 byte tag per
+///   bucket, about half of what ht_put(t, key, key) takes in a flat table.
+///
+/// - Probing, growth, seeding, allocator hooks and tracing are HashADT's;
+///   the same hash and equals functions work for both.
+///
+/// - The set assumes ownership of the keys it stores.  The delete
+///   function, if not NULL, frees a key when hs_remove() takes it out and
+///   when hs_destroy() runs.
+///
+/// - Wherever a function has a precondition, and the client violates the
+///   condition, and the code detects the violation, then the function will
+///   assert failure and abort.
+///
+
+///
+/// The HashSet data type is a pointer to an opaque structure.
+///
+typedef struct hashset_s *HashSet;
+
+///
+/// Create a new set.
+///
+/// @param hash The hash function for keys
+/// @param equals The equal function for key comparison
+/// @param delete The delete function for keys, or NULL to leave them be
+///
+/// @exception Assert fails if it cannot allocate space
+///
+/// @pre hash and equals are valid function pointers.
+///
+/// @return A newly created set
+///
+HashSet hs_create(
+    size_t (*hash)( const void *key ),
+    bool (*equals)( const void *key1, const void *key2 ),
+    void (*delete)( void *key )
+);
+
+///
+/// Create a new set with HashADT creation options.  The layout member is
+/// ignored; a set always uses HT_LAYOUT_SOA.  memory_budget and
+/// value_size are ignored too, since a budget needs HT_LAYOUT_FLAT and a
+/// set stores no values.
+///
+/// @param hash The hash function for keys
+/// @param equals The equal function for key comparison
+/// @param delete The delete function for keys, or NULL to leave them be
+/// @param options The creation options, or NULL for the defaults
+///
+/// @exception Assert fails if it cannot allocate space
+///
+/// @pre equals is a valid function pointer.
+/// @pre hash is a valid function pointer, unless options has a keyed_hash.
+///
+/// @return A newly created set
+///
+HashSet hs_create_opts(
+    size_t (*hash)( const void *key ),
+    bool (*equals)( const void *key1, const void *key2 ),
+    void (*delete)( void *key ),
+    const HTOptions *options
+);
+
+///
+/// Destroy the set, calling the delete function on every key.
+///
+/// @param s The set to destroy
+///
+/// @pre s is a valid instance of set.
+///
+/// @post s is not a valid instance of set.
+///
+void hs_destroy( HashSet s );
+
+///
+/// Add a key to the set.  If an equal key is already there, the set keeps
+/// that one and the caller keeps key.
+///
+/// @param s The set
+/// @param key The key
+///
+/// @exception Assert fails if it cannot allocate space
+///
+/// @pre s is a valid instance of set, and key is not NULL.
+///
+/// @return true if key was added, false if an equal key was there
+///
+bool hs_insert( HashSet s, const void *key );
+
+///
+/// Check if the set has a key.
+///
+/// @param s The set
+/// @param key The key
+///
+/// @pre s is a valid instance of set, and key is not NULL.
+///
+/// @return Whether an equal key is in the set
+///
+bool hs_contains( const HashSet s, const void *key );
+
+///
+/// Take a key out of the set, calling the delete function on the stored
+/// key.  Keys after it in its probe run move back, so the set is left as
+/// if the key had never been added.
+///
+/// @param s The set
+/// @param key The key
+///
+/// @pre s is a valid instance of set, and key is not NULL.
+///
+/// @return true if an equal key was in the set
+///
+bool hs_remove( HashSet s, const void *key );
+
+///
+/// Count the keys in the set.
+///
+/// @param s The set
+///
+/// @pre s is a valid instance of set.
+///
+/// @return The number of keys
+///
+size_t hs_size( const HashSet s );
+
+///
+/// The HashADT table holding the set, for ht_stats(), ht_keys() and
+/// ht_trace_start().  It must not be given to ht_put() with a value that
+/// is not NULL, or destroyed.
+///
+/// @param s The set
+///
+/// @pre s is a valid instance of set.
+///
+/// @return The set's table
+///
+HashADT hs_table( const HashSet s );
+
+#endif // HASHSET_H
@@ -0,0 +1,900 @@
+//
+// File name: bench.c
+//
+// Description:
+// Throughput and latency benchmark of ht_put, ht_get and ht_has over
+// uniform and Zipfian workloads, integer and string keys, hit/miss mixes
+// and table sizes from L1 resident to ten times the last level cache.
+// Every HashADT configuration is compared with a plain open addressing
+// reference table using the same hash functions, and, when built with
+// -DBENCH_UNORDERED_MAP and linked with bench_unordered_map.cpp, with a
+// std::unordered_map.  Results are JSON, with hardware counters per
+// operation when --perf is given.
+//
+//   cc -O2 -DNDEBUG -IHashADT -Ibench bench/bench.c bench/bench_common.c
+//       HashADT/HashADT.c HashADT/HTSegmented.c HashADT/HTSoA.c
+//       HashADT/HTCompact.c HashADT/HashFunctions.c -lm -pthread -o hashadt_bench
+//   ./hashadt_bench --help
+//
+// with the std::unordered_map baseline:
+//
+//   cc -O2 -DNDEBUG -DBENCH_UNORDERED_MAP -IHashADT -Ibench -c bench/bench.c
+//       bench/bench_common.c HashADT/HashADT.c HashADT/HTSegmented.c
+//       HashADT/HTSoA.c HashADT/HTCompact.c HashADT/HashFunctions.c
+//   c++ -O2 -DNDEBUG -IHashADT -Ibench -c bench/bench_unordered_map.cpp
+//   c++ *.o -lm -pthread -o hashadt_bench
+//
+// @author Nick Creeley - nc8004
+//
+// version control:
+// git hw6 repository
+//
+// // // // // // // // // // // // // // // // // // // // // // // // // // // // // //
+
+//include standard libraries
+
+#include <stdbool.h>
+
+#include <stddef.h>
+
+#include <stdlib.h>
+
+#include <stdint.h>
+
+#include <inttypes.h>
+
+#include <string.h>
+
+#include <assert.h>
+
+#include <stdio.h>
+
+//include header files
+
+#include "HashADT.h"
+
+#include "HashFunctions.h"
+
+#include "bench_common.h"
+
+#ifdef BENCH_UNORDERED_MAP
+#include "bench_unordered_map.h"
+#endif
+
+//width of a generated string key, including the NUL
+
+#define STRING_KEY 24
+
+//most sizes a run can sweep
+
+#define MAX_SIZES 32
+
+/// The settings of one run, from the command line
+
+typedef struct Settings {
+
+    const char *config;         //configuration name, or "all"
+
+    bool int_keys;
+
+    bool string_keys;
+
+    bool uniform;
+
+    bool zipf;
+
+    double theta;
+
+    double hit_ratio;
+
+    size_t sizes[MAX_SIZES];
+
+    size_t size_count;
+
+    size_t ops;
+
+    uint64_t seed;
+
+    bool reference;
+
+    bool unordered_map;         //only when built with BENCH_UNORDERED_MAP
+
+    BenchPerf *perf;            //hardware counters, NULL unless --perf
+
+    FILE *out;
+
+} Settings;
+
+/// A key set: count present keys followed by count absent keys
+
+typedef struct KeySet {
+
+    bool strings;
+
+    size_t count;
+
+    uint64_t *ints;
+
+    char *strings_data;
+
+    const void **keys;
+
+} KeySet;
+
+/// The operations a benchmarked table supports
+
+typedef struct Target {
+
+    const char *name;
+
+    void *(*create)( const BenchConfig *config, bool strings );
+
+    void (*put)( void *table, const void *key, const void *value );
+
+    const void *(*get)( void *table, const void *key );
+
+    bool (*has)( void *table, const void *key );
+
+    void (*destroy)( void *table );
+
+} Target;
+
+/// print_nothing(): print callback required by ht_create
+
+static void print_nothing( const void *key, const void *value ) {
+
+    (void) key;
+
+    (void) value;
+}
+
+/// hashadt_create(): a HashADT with the configuration's options
+
+static void *hashadt_create( const BenchConfig *config, bool strings ) {
+
+    HTOptions options;
+
+    config -> options(&options);
+
+    if(strings) {
+
+        return ht_create_opts(ht_hash_cstr, ht_equals_cstr, print_nothing, NULL, &options);
+    }
+
+    return ht_create_opts(ht_hash_u64, ht_equals_u64, print_nothing, NULL, &options);
+}
+
+static void hashadt_put( void *table, const void *key, const void *value ) {
+
+    ht_put((HashADT) table, key, value);
+}
+
+static const void *hashadt_get( void *table, const void *key ) {
+
+    return ht_get((HashADT) table, key);
+}
+
+static bool hashadt_has( void *table, const void *key ) {
+
+    return ht_has((HashADT) table, key);
+}
+
+static void hashadt_destroy( void *table ) {
+
+    ht_destroy((HashADT) table);
+}
+
+/// The reference table: power of two linear probing, masked index, no
+/// counters or options, growing at the same load as HashADT
+
+typedef struct RefTable {
+
+    size_t mask;
+
+    size_t size;
+
+    const void **keys;
+
+    const void **values;
+
+    size_t (*hash)( const void *key );
+
+    bool (*equals)( const void *key1, const void *key2 );
+
+} RefTable;
+
+static void *ref_create( const BenchConfig *config, bool strings ) {
+
+    (void) config;
+
+    RefTable *ref = (RefTable*)malloc(sizeof(RefTable));
+
+    assert(ref != NULL);
+
+    ref -> mask = INITIAL_CAPACITY - 1;
+
+    ref -> size = 0;
+
+    ref -> keys = (const void**)calloc(INITIAL_CAPACITY, sizeof(void*));
+
+    ref -> values = (const void**)calloc(INITIAL_CAPACITY, sizeof(void*));
+
+    assert(ref -> keys != NULL && ref -> values != NULL);
+
+    ref -> hash = strings ? ht_hash_cstr : ht_hash_u64;
+
+    ref -> equals = strings ? ht_equals_cstr : ht_equals_u64;
+
+    return ref;
+}
+
+static size_t ref_slot( const RefTable *ref, const void *key ) {
+
+    size_t i = ref -> hash(key) & ref -> mask;
+
+    while(ref -> keys[i] != NULL && !ref -> equals(key, ref -> keys[i])) {
+
+        i = (i + 1) & ref -> mask;
+    }
+
+    return i;
+}
+
+static void ref_put( void *table, const void *key, const void *value ) {
+
+    RefTable *ref = (RefTable*) table;
+
+    if(ref -> size + 1 > (ref -> mask + 1) * LOAD_THRESHOLD) {
+
+        size_t old_capacity = ref -> mask + 1;
+
+        const void **old_keys = ref -> keys;
+
+        const void **old_values = ref -> values;
+
+        ref -> mask = old_capacity * RESIZE_FACTOR - 1;
+
+        ref -> keys = (const void**)calloc(ref -> mask + 1, sizeof(void*));
+
+        ref -> values = (const void**)calloc(ref -> mask + 1, sizeof(void*));
+
+        assert(ref -> keys != NULL && ref -> values != NULL);
+
+        for(size_t i = 0; i < old_capacity; i++) {
+
+            if(old_keys[i] != NULL) {
+
+                size_t slot = ref_slot(ref, old_keys[i]);
+
+                ref -> keys[slot] = old_keys[i];
+
+                ref -> values[slot] = old_values[i];
+            }
+        }
+
+        free(old_keys);
+
+        free(old_values);
+    }
+
+    size_t slot = ref_slot(ref, key);
+
+    if(ref -> keys[slot] == NULL) {
+
+        ref -> keys[slot] = key;
+
+        ref -> size++;
+    }
+
+    ref -> values[slot] = value;
+}
+
+static const void *ref_get( void *table, const void *key ) {
+
+    RefTable *ref = (RefTable*) table;
+
+    return ref -> values[ref_slot(ref, key)];
+}
+
+static bool ref_has( void *table, const void *key ) {
+
+    RefTable *ref = (RefTable*) table;
+
+    return ref -> keys[ref_slot(ref, key)] != NULL;
+}
+
+static void ref_destroy( void *table ) {
+
+    RefTable *ref = (RefTable*) table;
+
+    free(ref -> keys);
+
+    free(ref -> values);
+
+    free(ref);
+}
+
+static const Target hashadt_target = {
+    "HashADT", hashadt_create, hashadt_put, hashadt_get, hashadt_has, hashadt_destroy
+};
+
+static const Target reference_target = {
+    "reference", ref_create, ref_put, ref_get, ref_has, ref_destroy
+};
+
+#ifdef BENCH_UNORDERED_MAP
+
+/// umap_create(): a std::unordered_map, which has no configuration
+
+static void *umap_create( const BenchConfig *config, bool strings ) {
+
+    (void) config;
+
+    return bench_umap_create(strings);
+}
+
+static const Target unordered_map_target = {
+    "unordered_map", umap_create, bench_umap_put, bench_umap_get, bench_umap_has, bench_umap_destroy
+};
+
+#endif
+
+/// keys_create(): count present and count absent distinct keys
+
+static void keys_create( KeySet *set, size_t count, bool strings, BenchRng *rng ) {
+
+    size_t total = 2 * count;
+
+    set -> strings = strings;
+
+    set -> count = count;
+
+    set -> ints = (uint64_t*)malloc(total * sizeof(uint64_t));
+
+    set -> keys = (const void**)malloc(total * sizeof(void*));
+
+    set -> strings_data = strings ? (char*)malloc(total * STRING_KEY) : NULL;
+
+    assert(set -> ints != NULL && set -> keys != NULL);
+
+    assert(!strings || set -> strings_data != NULL);
+
+    //distinct values: an odd multiplier is a bijection on 64-bit integers
+
+    uint64_t salt = bench_rng_next(rng);
+
+    for(size_t i = 0; i < total; i++) {
+
+        set -> ints[i] = (i + salt) * 0x9e3779b97f4a7c15ULL;
+    }
+
+    for(size_t i = 0; i < total; i++) {
+
+        if(strings) {
+
+            char *str = set -> strings_data + i * STRING_KEY;
+
+            snprintf(str, STRING_KEY, "key:%016" PRIx64, set -> ints[i]);
+
+            set -> keys[i] = str;
+
+        } else {
+
+            set -> keys[i] = &set -> ints[i];
+        }
+    }
+
+    //shuffle each half so a key's rank says nothing about its address
+
+    for(size_t half = 0; half < total; half += count) {
+
+        for(size_t i = count - 1; i > 0; i--) {
+
+            size_t j = (size_t) bench_rng_below(rng, i + 1);
+
+            const void *swap = set -> keys[half + i];
+
+            set -> keys[half + i] = set -> keys[half + j];
+
+            set -> keys[half + j] = swap;
+        }
+    }
+}
+
+static void keys_destroy( KeySet *set ) {
+
+    free(set -> ints);
+
+    free(set -> keys);
+
+    free(set -> strings_data);
+}
+
+/// timer_overhead(): median cost of a pair of clock reads; per operation
+/// latencies include it, so it is reported alongside them
+
+static uint64_t timer_overhead( void ) {
+
+    BenchHistogram hist;
+
+    bench_hist_reset(&hist);
+
+    for(size_t i = 0; i < 100000; i++) {
+
+        uint64_t start = bench_now_ns();
+
+        bench_hist_record(&hist, bench_now_ns() - start);
+    }
+
+    return bench_hist_percentile(&hist, 50.0);
+}
+
+/// report(): one JSON result object
+
+static void report( const Settings *settings, bool *first, const char *table,
+        const char *config, const char *op, const KeySet *keys,
+        const char *dist, double hit_ratio, size_t ops, uint64_t elapsed,
+        const BenchHistogram *latency, const BenchPerf *perf ) {
+
+    FILE *out = settings -> out;
+
+    fprintf(out, "%s\n    {\"table\": ", *first ? "" : ",");
+
+    *first = false;
+
+    bench_json_string(out, table);
+
+    fprintf(out, ", \"config\": ");
+
+    bench_json_string(out, config);
+
+    fprintf(out, ", \"op\": \"%s\", \"keys\": \"%s\", \"dist\": \"%s\"",
+        op, keys -> strings ? "string" : "int", dist);
+
+    fprintf(out, ", \"size\": %zu, \"hit_ratio\": %.3f, \"ops\": %zu",
+        keys -> count, hit_ratio, ops);
+
+    double ns = ops > 0 ? (double) elapsed / ops : 0.0;
+
+    fprintf(out, ", \"ns_per_op\": %.2f, \"mops_per_s\": %.3f, ",
+        ns, ns > 0 ? 1000.0 / ns : 0.0);
+
+    bench_hist_json(latency, out);
+
+    if(perf != NULL) {
+
+        fprintf(out, ", \"perf\": ");
+
+        bench_perf_json(perf, ops, out);
+    }
+
+    fprintf(out, "}");
+
+    fflush(out);
+}
+
+/// run_one(): build one table and run the lookup mix against it
+
+static void run_one( const Settings *settings, bool *first, const Target *target,
+        const BenchConfig *config, const KeySet *keys, bool zipf,
+        const BenchZipf *zipf_ranks, BenchRng *rng ) {
+
+    size_t n = keys -> count;
+
+    const char *dist = zipf ? "zipf" : "uniform";
+
+    BenchHistogram latency;
+
+    //build phase: time the whole build, then per insert on a second table
+
+    BenchPerf *perf = settings -> perf;
+
+    void *table = target -> create(config, keys -> strings);
+
+    if(perf != NULL) {
+        bench_perf_start(perf);
+    }
+
+    uint64_t start = bench_now_ns();
+
+    for(size_t i = 0; i < n; i++) {
+
+        target -> put(table, keys -> keys[i], keys -> keys[i]);
+    }
+
+    uint64_t elapsed = bench_now_ns() - start;
+
+    if(perf != NULL) {
+        bench_perf_stop(perf);
+    }
+
+    target -> destroy(table);
+
+    bench_hist_reset(&latency);
+
+    table = target -> create(config, keys -> strings);
+
+    for(size_t i = 0; i < n; i++) {
+
+        uint64_t op_start = bench_now_ns();
+
+        target -> put(table, keys -> keys[i], keys -> keys[i]);
+
+        bench_hist_record(&latency, bench_now_ns() - op_start);
+    }
+
+    report(settings, first, target -> name, config -> name, "put", keys, "sequential",
+        0.0, n, elapsed, &latency, perf);
+
+    //lookup phase: draw the operation sequence up front so the random
+    //number generator is not timed
+
+    size_t ops = settings -> ops;
+
+    const void **sequence = (const void**)malloc(ops * sizeof(void*));
+
+    bool *hit = (bool*)malloc(ops * sizeof(bool));
+
+    assert(sequence != NULL && hit != NULL);
+
+    for(size_t i = 0; i < ops; i++) {
+
+        uint64_t rank = zipf ? bench_zipf_next(zipf_ranks, rng) : bench_rng_below(rng, n);
+
+        hit[i] = bench_rng_unit(rng) < settings -> hit_ratio;
+
+        //misses come from the absent half, with the same skew
+
+        sequence[i] = keys -> keys[hit[i] ? rank : n + rank];
+    }
+
+    //present keys are looked up with ht_get, absent ones with ht_has
+
+    size_t found = 0;
+
+    if(perf != NULL) {
+        bench_perf_start(perf);
+    }
+
+    start = bench_now_ns();
+
+    for(size_t i = 0; i < ops; i++) {
+
+        if(hit[i]) {
+
+            found += target -> get(table, sequence[i]) != NULL;
+
+        } else {
+
+            found += target -> has(table, sequence[i]);
+        }
+    }
+
+    elapsed = bench_now_ns() - start;
+
+    if(perf != NULL) {
+        bench_perf_stop(perf);
+    }
+
+    bench_hist_reset(&latency);
+
+    for(size_t i = 0; i < ops; i++) {
+
+        uint64_t op_start = bench_now_ns();
+
+        if(hit[i]) {
+
+            found += target -> get(table, sequence[i]) != NULL;
+
+        } else {
+
+            found += target -> has(table, sequence[i]);
+        }
+
+        bench_hist_record(&latency, bench_now_ns() - op_start);
+    }
+
+    report(settings, first, target -> name, config -> name, "lookup", keys, dist,
+        settings -> hit_ratio, ops, elapsed, &latency, perf);
+
+    //every hit must have been found, and no miss
+
+    size_t expected = 0;
+
+    for(size_t i = 0; i < ops; i++) {
+
+        expected += hit[i];
+    }
+
+    if(found != 2 * expected) {
+
+        fprintf(stderr, "%s/%s: lookups found %zu keys, expected %zu\n",
+            target -> name, config -> name, found, 2 * expected);
+
+        exit(EXIT_FAILURE);
+    }
+
+    free(sequence);
+
+    free(hit);
+
+    target -> destroy(table);
+}
+
+/// default_sizes(): L1 resident up to 10x the last level cache
+///
+/// an entry costs its slot (16 bytes at ~0.56 mean load) plus its key
+
+static void default_sizes( Settings *settings, size_t max_size ) {
+
+    size_t llc = bench_llc_bytes();
+
+    size_t largest = 10 * llc / 48;
+
+    if(max_size > 0 && largest > max_size) {
+
+        largest = max_size;
+    }
+
+    settings -> size_count = 0;
+
+    for(size_t n = 1024; settings -> size_count < MAX_SIZES - 1; n *= 8) {
+
+        if(n >= largest) {
+            break;
+        }
+
+        settings -> sizes[settings -> size_count++] = n;
+    }
+
+    settings -> sizes[settings -> size_count++] = largest;
+}
+
+/// usage(): print the command line help
+
+static void usage( const char *program ) {
+
+    fprintf(stderr,
+        "usage: %s [options]\n"
+        "  --config NAME     table configuration, or all (default all):",
+        program);
+
+    for(const BenchConfig *config = bench_configs; config -> name != NULL; config++) {
+
+        fprintf(stderr, " %s", config -> name);
+    }
+
+    fprintf(stderr, "\n"
+        "  --keys K          int, string or both (default both)\n"
+        "  --dist D          uniform, zipf or both (default both)\n"
+        "  --theta T         zipf skew (default 0.99)\n"
+        "  --hit-ratio R     fraction of lookups that find their key (default 0.9)\n"
+        "  --sizes A,B,...   table sizes in keys (default 1K up to 10x LLC)\n"
+        "  --max-size N      cap on the default sizes\n"
+        "  --ops N           lookups per table (default 1000000)\n"
+        "  --seed S          workload seed (default 1)\n"
+        "  --no-reference    skip the reference table\n"
+        "  --no-unordered-map\n"
+        "                    skip the std::unordered_map baseline, when built\n"
+        "                    with -DBENCH_UNORDERED_MAP\n"
+        "  --perf            count cycles, instructions and cache, TLB and branch\n"
+        "                    misses per operation (perf_event_open, Linux)\n"
+        "  --out FILE        write JSON to FILE instead of stdout\n");
+}
+
+/// main(): parse settings and run every combination
+
+int main( int argc, char *argv[] ) {
+
+    Settings settings = {
+        "all", true, true, true, true, 0.99, 0.9, { 0 }, 0, 1000000, 1, true, true, NULL, stdout
+    };
+
+    BenchPerf perf;
+
+    size_t max_size = 0;
+
+    for(int i = 1; i < argc; i++) {
+
+        const char *arg = argv[i];
+
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+
+        if(strcmp(arg, "--no-reference") == 0) {
+
+            settings.reference = false;
+
+            continue;
+        }
+
+        if(strcmp(arg, "--no-unordered-map") == 0) {
+
+            settings.unordered_map = false;
+
+            continue;
+        }
+
+        if(strcmp(arg, "--perf") == 0) {
+
+            settings.perf = &perf;
+
+            continue;
+        }
+
+        if(value == NULL || strncmp(arg, "--", 2) != 0) {
+
+            usage(argv[0]);
+
+            return EXIT_FAILURE;
+        }
+
+        i++;
+
+        if(strcmp(arg, "--config") == 0) {
+
+            settings.config = value;
+
+        } else if(strcmp(arg, "--keys") == 0) {
+
+            settings.int_keys = strcmp(value, "string") != 0;
+
+            settings.string_keys = strcmp(value, "int") != 0;
+
+        } else if(strcmp(arg, "--dist") == 0) {
+
+            settings.uniform = strcmp(value, "zipf") != 0;
+
+            settings.zipf = strcmp(value, "uniform") != 0;
+
+        } else if(strcmp(arg, "--theta") == 0) {
+
+            settings.theta = atof(value);
+
+        } else if(strcmp(arg, "--hit-ratio") == 0) {
+
+            settings.hit_ratio = atof(value);
+
+        } else if(strcmp(arg, "--sizes") == 0) {
+
+            char *rest = (char *) value;
+
+            while(*rest != '\0' && settings.size_count < MAX_SIZES) {
+
+                settings.sizes[settings.size_count++] = strtoull(rest, &rest, 10);
+
+                if(*rest == ',') {
+                    rest++;
+                }
+            }
+
+        } else if(strcmp(arg, "--max-size") == 0) {
+
+            max_size = strtoull(value, NULL, 10);
+
+        } else if(strcmp(arg, "--ops") == 0) {
+
+            settings.ops = strtoull(value, NULL, 10);
+
+        } else if(strcmp(arg, "--seed") == 0) {
+
+            settings.seed = strtoull(value, NULL, 10);
+
+        } else if(strcmp(arg, "--out") == 0) {
+
+            settings.out = fopen(value, "w");
+
+            if(settings.out == NULL) {
+
+                perror(value);
+
+                return EXIT_FAILURE;
+            }
+
+        } else {
+
+            usage(argv[0]);
+
+            return EXIT_FAILURE;
+        }
+    }
+
+    if(strcmp(settings.config, "all") != 0 && bench_config_find(settings.config) == NULL) {
+
+        usage(argv[0]);
+
+        return EXIT_FAILURE;
+    }
+
+    if(settings.size_count == 0) {
+
+        default_sizes(&settings, max_size);
+    }
+
+    //without any counter the results still carry the reason, once per result
+
+    if(settings.perf != NULL && !bench_perf_open(settings.perf)) {
+
+        fprintf(stderr, "hardware counters unavailable: %s\n", strerror(settings.perf -> error));
+    }
+
+    FILE *out = settings.out;
+
+    fprintf(out, "{\n  \"benchmark\": \"hashadt\",\n  \"hash\": %d,\n", (int) ht_hash_implementation());
+
+    fprintf(out, "  \"llc_bytes\": %zu,\n  \"timer_overhead_ns\": %" PRIu64 ",\n",
+        bench_llc_bytes(), timer_overhead());
+
+    fprintf(out, "  \"results\": [");
+
+    bool first = true;
+
+    BenchRng rng;
+
+    bench_rng_seed(&rng, settings.seed);
+
+    for(size_t s = 0; s < settings.size_count; s++) {
+
+        size_t n = settings.sizes[s];
+
+        BenchZipf zipf;
+
+        if(settings.zipf) {
+
+            bench_zipf_init(&zipf, n, settings.theta);
+        }
+
+        for(int strings = 0; strings <= 1; strings++) {
+
+            if((strings && !settings.string_keys) || (!strings && !settings.int_keys)) {
+                continue;
+            }
+
+            KeySet keys;
+
+            keys_create(&keys, n, strings, &rng);
+
+            for(int skewed = 0; skewed <= 1; skewed++) {
+
+                if((skewed && !settings.zipf) || (!skewed && !settings.uniform)) {
+                    continue;
+                }
+
+                for(const BenchConfig *config = bench_configs; config -> name != NULL; config++) {
+
+                    if(strcmp(settings.config, "all") == 0 || strcmp(settings.config, config -> name) == 0) {
+
+                        run_one(&settings, &first, &hashadt_target, config, &keys, skewed, &zipf, &rng);
+                    }
+                }
+
+                if(settings.reference) {
+
+                    run_one(&settings, &first, &reference_target, &bench_configs[0], &keys, skewed, &zipf, &rng);
+                }
+
+#ifdef BENCH_UNORDERED_MAP
+
+                if(settings.unordered_map) {
+
+                    run_one(&settings, &first, &unordered_map_target, &bench_configs[0], &keys, skewed, &zipf, &rng);
+                }
+
+#endif
+            }
+
+            keys_destroy(&keys);
+        }
+    }
+
+    fprintf(out, "\n  ]\n}\n");
+
+    if(out != stdout) {
+        fclose(out);
+    }
+
+    if(settings.perf != NULL) {
+        bench_perf_close(settings.perf);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,823 @@
+//
+// File name: bench_common.c
+//
+// Description:
+// Helpers shared by the HashADT benchmarks: clock, random numbers,
+// Zipfian ranks, latency histograms, table configurations and JSON
+//
+// @author Nick Creeley - nc8004
+//
+// version control:
+// git hw6 repository
+//
+// // // // // // // // // // // // // // // // // // // // // // // // // // // // // //
+
+//clock_gettime() and sysconf() are POSIX, syscall() is a GNU extension
+
+#define _GNU_SOURCE
+
+//include standard libraries
+
+#include <stdbool.h>
+
+#include <stddef.h>
+
+#include <stdlib.h>
+
+#include <stdint.h>
+
+#include <inttypes.h>
+
+#include <string.h>
+
+#include <assert.h>
+
+#include <stdio.h>
+
+#include <math.h>
+
+#include <time.h>
+
+#include <unistd.h>
+
+#include <errno.h>
+
+#ifdef __linux__
+
+#include <linux/perf_event.h>
+
+#include <sys/ioctl.h>
+
+#include <sys/syscall.h>
+
+#endif
+
+//include header files
+
+#include "bench_common.h"
+
+/// bench_now_ns(): monotonic clock
+///
+/// see headerfile for full documentation
+
+uint64_t bench_now_ns( void ) {
+
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t) now.tv_sec * 1000000000u + (uint64_t) now.tv_nsec;
+}
+
+/// splitmix64(): expands a seed into generator state
+
+static uint64_t splitmix64( uint64_t *state ) {
+
+    uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+
+    return z ^ (z >> 31);
+}
+
+/// bench_rng_seed(): seed a generator
+///
+/// see headerfile for full documentation
+
+void bench_rng_seed( BenchRng *rng, uint64_t seed ) {
+
+    for(size_t i = 0; i < 4; i++) {
+
+        rng -> s[i] = splitmix64(&seed);
+    }
+}
+
+/// rotl(): rotate left
+
+static inline uint64_t rotl( uint64_t x, int k ) {
+
+    return (x << k) | (x >> (64 - k));
+}
+
+/// bench_rng_next(): next 64 random bits
+///
+/// see headerfile for full documentation
+
+uint64_t bench_rng_next( BenchRng *rng ) {
+
+    uint64_t *s = rng -> s;
+
+    uint64_t result = rotl(s[1] * 5, 7) * 9;
+
+    uint64_t t = s[1] << 17;
+
+    s[2] ^= s[0];
+
+    s[3] ^= s[1];
+
+    s[1] ^= s[2];
+
+    s[0] ^= s[3];
+
+    s[2] ^= t;
+
+    s[3] = rotl(s[3], 45);
+
+    return result;
+}
+
+/// bench_rng_below(): uniform value below a bound (Lemire's method)
+///
+/// see headerfile for full documentation
+
+uint64_t bench_rng_below( BenchRng *rng, uint64_t bound ) {
+
+    assert(bound > 0);
+
+#if defined(__SIZEOF_INT128__)
+
+    return (uint64_t) (((__uint128_t) bench_rng_next(rng) * bound) >> 64);
+
+#else
+
+    return bench_rng_next(rng) % bound;
+
+#endif
+}
+
+/// bench_rng_unit(): uniform double in [0, 1)
+///
+/// see headerfile for full documentation
+
+double bench_rng_unit( BenchRng *rng ) {
+
+    return (double) (bench_rng_next(rng) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/// bench_zipf_init(): prepare a Zipfian generator
+///
+/// see headerfile for full documentation
+
+void bench_zipf_init( BenchZipf *zipf, uint64_t n, double theta ) {
+
+    assert(n > 0 && theta > 0.0 && theta < 1.0);
+
+    double zetan = 0.0;
+
+    for(uint64_t i = 1; i <= n; i++) {
+
+        zetan += 1.0 / pow((double) i, theta);
+    }
+
+    double zeta2 = 1.0 + 1.0 / pow(2.0, theta);
+
+    zipf -> n = n;
+
+    zipf -> theta = theta;
+
+    zipf -> alpha = 1.0 / (1.0 - theta);
+
+    zipf -> zetan = zetan;
+
+    zipf -> eta = (1.0 - pow(2.0 / n, 1.0 - theta)) / (1.0 - zeta2 / zetan);
+
+    zipf -> half_pow_theta = 1.0 + pow(0.5, theta);
+}
+
+/// bench_zipf_next(): draw a rank
+///
+/// see headerfile for full documentation
+
+uint64_t bench_zipf_next( const BenchZipf *zipf, BenchRng *rng ) {
+
+    double u = bench_rng_unit(rng);
+
+    double uz = u * zipf -> zetan;
+
+    if(uz < 1.0) {
+        return 0;
+    }
+
+    if(uz < zipf -> half_pow_theta) {
+        return zipf -> n > 1 ? 1 : 0;
+    }
+
+    uint64_t rank = (uint64_t) (zipf -> n * pow(zipf -> eta * u - zipf -> eta + 1.0, zipf -> alpha));
+
+    return rank < zipf -> n ? rank : zipf -> n - 1;
+}
+
+/// bench_hist_reset(): empty a histogram
+///
+/// see headerfile for full documentation
+
+void bench_hist_reset( BenchHistogram *hist ) {
+
+    memset(hist, 0, sizeof(*hist));
+
+    hist -> min = UINT64_MAX;
+}
+
+/// hist_index(): the power and sub-bucket a value falls in
+///
+/// values below BENCH_HIST_SUB are exact (power 0); above that, power
+/// p holds [SUB << (p - 1), SUB << p) in SUB steps of 1 << (p - 1)
+
+static void hist_index( uint64_t value, size_t *power, size_t *sub ) {
+
+    if(value < BENCH_HIST_SUB) {
+
+        *power = 0;
+
+        *sub = (size_t) value;
+
+        return;
+    }
+
+    //the shift that leaves the value in [SUB, 2 SUB); 6 is log2(SUB)
+
+    size_t shift = (size_t) (63 - __builtin_clzll(value)) - 6;
+
+    *power = shift + 1;
+
+    *sub = (size_t) (value >> shift) - BENCH_HIST_SUB;
+
+    if(*power >= BENCH_HIST_POW) {
+
+        *power = BENCH_HIST_POW - 1;
+
+        *sub = BENCH_HIST_SUB - 1;
+    }
+}
+
+/// hist_value(): the upper edge of a power and sub-bucket
+
+static uint64_t hist_value( size_t power, size_t sub ) {
+
+    if(power == 0) {
+        return sub;
+    }
+
+    return (((uint64_t) sub + BENCH_HIST_SUB + 1) << (power - 1)) - 1;
+}
+
+/// bench_hist_record(): record one value
+///
+/// see headerfile for full documentation
+
+void bench_hist_record( BenchHistogram *hist, uint64_t value ) {
+
+    size_t power, sub;
+
+    hist_index(value, &power, &sub);
+
+    hist -> counts[power][sub]++;
+
+    hist -> total++;
+
+    hist -> sum += (double) value;
+
+    if(value < hist -> min) {
+        hist -> min = value;
+    }
+
+    if(value > hist -> max) {
+        hist -> max = value;
+    }
+}
+
+/// bench_hist_merge(): add one histogram to another
+///
+/// see headerfile for full documentation
+
+void bench_hist_merge( BenchHistogram *into, const BenchHistogram *from ) {
+
+    for(size_t p = 0; p < BENCH_HIST_POW; p++) {
+
+        for(size_t s = 0; s < BENCH_HIST_SUB; s++) {
+
+            into -> counts[p][s] += from -> counts[p][s];
+        }
+    }
+
+    into -> total += from -> total;
+
+    into -> sum += from -> sum;
+
+    if(from -> min < into -> min) {
+        into -> min = from -> min;
+    }
+
+    if(from -> max > into -> max) {
+        into -> max = from -> max;
+    }
+}
+
+/// bench_hist_percentile(): the value at a percentile
+///
+/// see headerfile for full documentation
+
+uint64_t bench_hist_percentile( const BenchHistogram *hist, double percentile ) {
+
+    if(hist -> total == 0) {
+        return 0;
+    }
+
+    uint64_t wanted = (uint64_t) ceil(hist -> total * percentile / 100.0);
+
+    if(wanted == 0) {
+        wanted = 1;
+    }
+
+    uint64_t seen = 0;
+
+    for(size_t p = 0; p < BENCH_HIST_POW; p++) {
+
+        for(size_t s = 0; s < BENCH_HIST_SUB; s++) {
+
+            seen += hist -> counts[p][s];
+
+            if(seen >= wanted) {
+
+                uint64_t value = hist_value(p, s);
+
+                return value < hist -> max ? value : hist -> max;
+            }
+        }
+    }
+
+    return hist -> max;
+}
+
+/// bench_hist_json(): histogram summary as JSON members
+///
+/// see headerfile for full documentation
+
+void bench_hist_json( const BenchHistogram *hist, FILE *out ) {
+
+    fprintf(out, "\"count\": %" PRIu64 ", \"mean_ns\": %.1f, \"min_ns\": %" PRIu64,
+        hist -> total, hist -> total > 0 ? hist -> sum / hist -> total : 0.0,
+        hist -> total > 0 ? hist -> min : 0);
+
+    fprintf(out, ", \"p50_ns\": %" PRIu64 ", \"p90_ns\": %" PRIu64 ", \"p99_ns\": %" PRIu64,
+        bench_hist_percentile(hist, 50.0), bench_hist_percentile(hist, 90.0),
+        bench_hist_percentile(hist, 99.0));
+
+    fprintf(out, ", \"p999_ns\": %" PRIu64 ", \"p9999_ns\": %" PRIu64 ", \"max_ns\": %" PRIu64,
+        bench_hist_percentile(hist, 99.9), bench_hist_percentile(hist, 99.99), hist -> max);
+}
+
+/// config_default(): ht_create() behaviour
+
+static void config_default( HTOptions *options ) {
+
+    ht_options_init(options);
+}
+
+/// config_seeded(): random seed mixed into the client hash
+
+static void config_seeded( HTOptions *options ) {
+
+    ht_options_init(options);
+
+    options -> seed_mode = HT_SEED_RANDOM;
+}
+
+/// hooked_alloc(): HTAllocator alloc that forwards to malloc
+
+static void *hooked_alloc( void *context, size_t size ) {
+
+    (void) context;
+
+    return malloc(size);
+}
+
+/// hooked_aligned_alloc(): HTAllocator aligned_alloc via posix_memalign
+
+static void *hooked_aligned_alloc( void *context, size_t alignment, size_t size ) {
+
+    (void) context;
+
+    void *ptr = NULL;
+
+    return posix_memalign(&ptr, alignment, size) == 0 ? ptr : NULL;
+}
+
+/// hooked_free(): HTAllocator free that forwards to free
+
+static void hooked_free( void *context, void *ptr, size_t size ) {
+
+    (void) context;
+
+    (void) size;
+
+    free(ptr);
+}
+
+static const HTAllocator hooked_allocator = {
+    hooked_alloc, hooked_aligned_alloc, hooked_free, NULL, NULL
+};
+
+/// config_hooked(): malloc behind the allocator hooks, to price them and
+/// the cache line aligned bucket arrays they bring
+
+static void config_hooked( HTOptions *options ) {
+
+    ht_options_init(options);
+
+    options -> allocator = &hooked_allocator;
+}
+
+/// config_hugepage(): transparent huge pages for large bucket arrays,
+/// prefaulted by a background thread before each growth
+
+static void config_hugepage( HTOptions *options ) {
+
+    ht_options_init(options);
+
+    options -> huge_pages = HT_HUGE_TRANSPARENT;
+
+    options -> prefault = HT_PREFAULT_BACKGROUND;
+}
+
+/// config_interleave(): large bucket arrays spread page by page over
+/// every NUMA node
+
+static void config_interleave( HTOptions *options ) {
+
+    ht_options_init(options);
+
+    options -> numa = HT_NUMA_INTERLEAVE;
+}
+
+/// config_replicated(): one copy of the bucket array per NUMA node
+
+static void config_replicated( HTOptions *options ) {
+
+    ht_options_init(options);
+
+    options -> numa = HT_NUMA_REPLICATE;
+}
+
+/// config_inplace(): grow by resizing the bucket array where it lies
+
+static void config_inplace( HTOptions *options ) {
+
+    ht_options_init(options);
+
+    options -> grow_in_place = true;
+}
+
+/// config_segmented(): extendible hashing over small segments
+
+static void config_segmented( HTOptions *options ) {
+
+    ht_options_init(options);
+
+    options -> layout = HT_LAYOUT_SEGMENTED;
+}
+
+/// config_small(): the first 8 pairs inline, for tables of a few keys
+
+static void config_small( HTOptions *options ) {
+
+    ht_options_init(options);
+
+    options -> small_capacity = 8;
+}
+
+/// config_compact(): dense pairs behind an index of 32 bit positions
+
+static void config_compact( HTOptions *options ) {
+
+    ht_options_init(options);
+
+    options -> layout = HT_LAYOUT_COMPACT;
+}
+
+/// config_soa(): tags, keys and values in separate arrays
+
+static void config_soa( HTOptions *options ) {
+
+    ht_options_init(options);
+
+    options -> layout = HT_LAYOUT_SOA;
+}
+
+//every configuration a benchmark can be pointed at
+
+const BenchConfig bench_configs[] = {
+    { "default", config_default },
+    { "seeded", config_seeded },
+    { "hooked", config_hooked },
+    { "hugepage", config_hugepage },
+    { "interleave", config_interleave },
+    { "replicated", config_replicated },
+    { "inplace", config_inplace },
+    { "segmented", config_segmented },
+    { "small", config_small },
+    { "soa", config_soa },
+    { "compact", config_compact },
+    { NULL, NULL }
+};
+
+/// bench_config_find(): look up a configuration by name
+///
+/// see headerfile for full documentation
+
+const BenchConfig *bench_config_find( const char *name ) {
+
+    for(const BenchConfig *config = bench_configs; config -> name != NULL; config++) {
+
+        if(strcmp(config -> name, name) == 0) {
+
+            return config;
+        }
+    }
+
+    return NULL;
+}
+
+/// bench_llc_bytes(): last level cache size
+///
+/// see headerfile for full documentation
+
+size_t bench_llc_bytes( void ) {
+
+#ifdef _SC_LEVEL3_CACHE_SIZE
+
+    long size = sysconf(_SC_LEVEL3_CACHE_SIZE);
+
+    if(size > 0) {
+        return (size_t) size;
+    }
+
+#endif
+
+    FILE *in = fopen("/sys/devices/system/cpu/cpu0/cache/index3/size", "r");
+
+    if(in != NULL) {
+
+        size_t kilobytes = 0;
+
+        int found = fscanf(in, "%zuK", &kilobytes);
+
+        fclose(in);
+
+        if(found == 1 && kilobytes > 0) {
+            return kilobytes * 1024;
+        }
+    }
+
+    return (size_t) 32 << 20;
+}
+
+//event names as they appear in the JSON
+
+static const char *perf_names[BENCH_PERF_EVENTS] = {
+    "cycles", "instructions", "l1d_misses", "llc_misses", "dtlb_misses", "branch_misses"
+};
+
+#ifdef __linux__
+
+/// perf_cache(): config word of a PERF_TYPE_HW_CACHE read miss event
+
+static uint64_t perf_cache( uint64_t cache ) {
+
+    return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+}
+
+#endif
+
+/// bench_perf_open(): open every event that the kernel allows
+///
+/// see headerfile for full documentation
+
+bool bench_perf_open( BenchPerf *perf ) {
+
+    bool any = false;
+
+    perf -> error = 0;
+
+    for(size_t i = 0; i < BENCH_PERF_EVENTS; i++) {
+
+        perf -> fds[i] = -1;
+
+        perf -> values[i] = 0;
+
+        perf -> valid[i] = false;
+    }
+
+#ifdef __linux__
+
+    static const struct {
+        uint32_t type;
+        uint64_t config;
+    } events[BENCH_PERF_EVENTS] = {
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+        { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D },
+        { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_LL },
+        { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+    };
+
+    for(size_t i = 0; i < BENCH_PERF_EVENTS; i++) {
+
+        struct perf_event_attr attr;
+
+        memset(&attr, 0, sizeof(attr));
+
+        attr.size = sizeof(attr);
+
+        attr.type = events[i].type;
+
+        attr.config = events[i].type == PERF_TYPE_HW_CACHE
+            ? perf_cache(events[i].config) : events[i].config;
+
+        attr.disabled = 1;
+
+        attr.exclude_kernel = 1;
+
+        attr.exclude_hv = 1;
+
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        long fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+
+        if(fd < 0) {
+
+            perf -> error = errno;
+
+            continue;
+        }
+
+        perf -> fds[i] = (int) fd;
+
+        any = true;
+    }
+
+#else
+
+    perf -> error = ENOSYS;
+
+#endif
+
+    return any;
+}
+
+/// bench_perf_start(): zero and enable the counters
+///
+/// see headerfile for full documentation
+
+void bench_perf_start( BenchPerf *perf ) {
+
+#ifdef __linux__
+
+    for(size_t i = 0; i < BENCH_PERF_EVENTS; i++) {
+
+        if(perf -> fds[i] >= 0) {
+
+            ioctl(perf -> fds[i], PERF_EVENT_IOC_RESET, 0);
+
+            ioctl(perf -> fds[i], PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+
+#else
+
+    (void) perf;
+
+#endif
+}
+
+/// bench_perf_stop(): disable and read the counters
+///
+/// see headerfile for full documentation
+
+void bench_perf_stop( BenchPerf *perf ) {
+
+#ifdef __linux__
+
+    for(size_t i = 0; i < BENCH_PERF_EVENTS; i++) {
+
+        perf -> valid[i] = false;
+
+        if(perf -> fds[i] < 0) {
+            continue;
+        }
+
+        ioctl(perf -> fds[i], PERF_EVENT_IOC_DISABLE, 0);
+
+        //value, time enabled, time running
+
+        uint64_t reading[3];
+
+        if(read(perf -> fds[i], reading, sizeof(reading)) != (ssize_t) sizeof(reading)
+                || reading[2] == 0) {
+            continue;
+        }
+
+        //scale up for the time the event was multiplexed out
+
+        perf -> values[i] = reading[2] < reading[1]
+            ? (uint64_t) ((double) reading[0] * reading[1] / reading[2]) : reading[0];
+
+        perf -> valid[i] = true;
+    }
+
+#else
+
+    (void) perf;
+
+#endif
+}
+
+/// bench_perf_json(): per operation counts as JSON
+///
+/// see headerfile for full documentation
+
+void bench_perf_json( const BenchPerf *perf, size_t ops, FILE *out ) {
+
+    fprintf(out, "{");
+
+    bool any = false;
+
+    for(size_t i = 0; i < BENCH_PERF_EVENTS; i++) {
+
+        fprintf(out, "%s\"%s\": ", i == 0 ? "" : ", ", perf_names[i]);
+
+        if(perf -> valid[i] && ops > 0) {
+
+            fprintf(out, "%.3f", (double) perf -> values[i] / ops);
+
+            any = true;
+
+        } else {
+
+            fprintf(out, "null");
+        }
+    }
+
+    if(perf -> valid[BENCH_PERF_CYCLES] && perf -> valid[BENCH_PERF_INSTRUCTIONS]
+            && perf -> values[BENCH_PERF_CYCLES] > 0) {
+
+        fprintf(out, ", \"ipc\": %.3f",
+            (double) perf -> values[BENCH_PERF_INSTRUCTIONS] / perf -> values[BENCH_PERF_CYCLES]);
+    }
+
+    if(!any) {
+
+        fprintf(out, ", \"unavailable\": ");
+
+        bench_json_string(out, perf -> error != 0 ? strerror(perf -> error) : "no events");
+    }
+
+    fprintf(out, "}");
+}
+
+/// bench_perf_close(): close the counters
+///
+/// see headerfile for full documentation
+
+void bench_perf_close( BenchPerf *perf ) {
+
+    for(size_t i = 0; i < BENCH_PERF_EVENTS; i++) {
+
+        if(perf -> fds[i] >= 0) {
+
+            close(perf -> fds[i]);
+
+            perf -> fds[i] = -1;
+        }
+    }
+}
+
+/// bench_json_string(): JSON string literal
+///
+/// see headerfile for full documentation
+
+void bench_json_string( FILE *out, const char *str ) {
+
+    fputc('"', out);
+
+    for(const char *c = str; *c != '\0'; c++) {
+
+        if(*c == '"' || *c == '\\') {
+
+            fprintf(out, "\\%c", *c);
+
+        } else if((unsigned char) *c < 0x20) {
+
+            fprintf(out, "\\u%04x", (unsigned char) *c);
+
+        } else {
+
+            fputc(*c, out);
+        }
+    }
+
+    fputc('"', out);
+}
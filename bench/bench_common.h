@@ -0,0 +1,266 @@
+/// \file bench_common.h
+/// \brief Timing, random workloads, latency histograms and JSON output
+/// shared by the HashADT benchmarks.
+///
+/// @author Nick Creeley - nc8004
+
+#ifndef BENCH_COMMON_H
+#define BENCH_COMMON_H
+
+#include <stdbool.h>    // bool
+#include <stddef.h>     // size_t
+#include <stdint.h>     // uint64_t
+#include <stdio.h>      // FILE
+
+#include "HashADT.h"
+
+///
+/// Monotonic time in nanoseconds.
+///
+/// @return Nanoseconds since an arbitrary fixed point
+///
+uint64_t bench_now_ns( void );
+
+///
+/// xoshiro256** random number generator.  Every benchmark seeds its own,
+/// so runs are reproducible.
+///
+typedef struct BenchRng {
+    uint64_t s[4];
+} BenchRng;
+
+///
+/// Seed a generator.
+///
+/// @param rng The generator
+/// @param seed Any value; equal seeds give equal sequences
+///
+void bench_rng_seed( BenchRng *rng, uint64_t seed );
+
+///
+/// Next 64 random bits.
+///
+/// @param rng The generator
+///
+/// @return A uniformly distributed 64-bit value
+///
+uint64_t bench_rng_next( BenchRng *rng );
+
+///
+/// A uniformly distributed value in [0, bound).
+///
+/// @param rng The generator
+/// @param bound The exclusive upper bound
+///
+/// @pre bound > 0.
+///
+/// @return The value
+///
+uint64_t bench_rng_below( BenchRng *rng, uint64_t bound );
+
+///
+/// A uniformly distributed double in [0, 1).
+///
+/// @param rng The generator
+///
+/// @return The value
+///
+double bench_rng_unit( BenchRng *rng );
+
+///
+/// Zipfian rank generator over [0, n), where rank r is drawn with
+/// probability proportional to 1 / (r + 1)^theta (Gray et al.).
+///
+typedef struct BenchZipf {
+    uint64_t n;
+    double theta;
+    double alpha;
+    double zetan;
+    double eta;
+    double half_pow_theta;
+} BenchZipf;
+
+///
+/// Prepare a Zipfian generator.  This sums n terms, so prepare once per
+/// key set size and reuse it.
+///
+/// @param zipf The generator to prepare
+/// @param n The number of ranks
+/// @param theta The skew, 0 < theta < 1; 0.99 is the YCSB default
+///
+void bench_zipf_init( BenchZipf *zipf, uint64_t n, double theta );
+
+///
+/// Draw a rank; rank 0 is the hottest.
+///
+/// @param zipf The prepared generator
+/// @param rng The random source
+///
+/// @return A rank in [0, n)
+///
+uint64_t bench_zipf_next( const BenchZipf *zipf, BenchRng *rng );
+
+/// Sub-buckets per power of two in a BenchHistogram (about 1.5% precision)
+#define BENCH_HIST_SUB 64
+
+/// Powers of two a BenchHistogram covers (values up to 2^45 ns, ~9 hours)
+#define BENCH_HIST_POW 40
+
+///
+/// HDR-style log-linear latency histogram: each power of two range is
+/// split into BENCH_HIST_SUB equal sub-buckets, so every recorded value
+/// keeps about two significant digits at any magnitude.
+///
+typedef struct BenchHistogram {
+    uint64_t counts[BENCH_HIST_POW][BENCH_HIST_SUB];
+    uint64_t total;
+    uint64_t min;
+    uint64_t max;
+    double sum;
+} BenchHistogram;
+
+///
+/// Empty a histogram.
+///
+/// @param hist The histogram
+///
+void bench_hist_reset( BenchHistogram *hist );
+
+///
+/// Record one value.
+///
+/// @param hist The histogram
+/// @param value The value, usually nanoseconds
+///
+void bench_hist_record( BenchHistogram *hist, uint64_t value );
+
+///
+/// Add every value of one histogram to another.
+///
+/// @param into The histogram that receives the values
+/// @param from The histogram to add
+///
+void bench_hist_merge( BenchHistogram *into, const BenchHistogram *from );
+
+///
+/// The value at a percentile.
+///
+/// @param hist The histogram
+/// @param percentile From 0 to 100
+///
+/// @return The upper edge of the sub-bucket holding that percentile, or
+///         0 if the histogram is empty
+///
+uint64_t bench_hist_percentile( const BenchHistogram *hist, double percentile );
+
+///
+/// Write a histogram summary as JSON object members (without braces):
+/// count, mean, min, p50, p90, p99, p99.9, p99.99 and max.
+///
+/// @param hist The histogram
+/// @param out The stream
+///
+void bench_hist_json( const BenchHistogram *hist, FILE *out );
+
+///
+/// A named set of creation options, so every benchmark can be run against
+/// every way of configuring a table.
+///
+typedef struct BenchConfig {
+    const char *name;
+    void (*options)( HTOptions *options );
+} BenchConfig;
+
+/// The configurations every benchmark knows, terminated by a NULL name
+extern const BenchConfig bench_configs[];
+
+///
+/// Look up a configuration by name.
+///
+/// @param name The name given on the command line
+///
+/// @return The configuration, or NULL if the name is unknown
+///
+const BenchConfig *bench_config_find( const char *name );
+
+///
+/// Size of the last level cache in bytes, from sysconf or sysfs.
+///
+/// @return The size, or 32 MB if it cannot be found
+///
+size_t bench_llc_bytes( void );
+
+/// The hardware events a BenchPerf counts
+typedef enum BenchPerfEvent {
+    BENCH_PERF_CYCLES,
+    BENCH_PERF_INSTRUCTIONS,
+    BENCH_PERF_L1D_MISSES,
+    BENCH_PERF_LLC_MISSES,
+    BENCH_PERF_DTLB_MISSES,
+    BENCH_PERF_BRANCH_MISSES,
+    BENCH_PERF_EVENTS
+} BenchPerfEvent;
+
+///
+/// Hardware performance counters (Linux perf_event_open) around a region
+/// of a benchmark.  Each event is opened on its own, so a kernel or
+/// container that refuses some events still reports the others; where
+/// none can be opened every call is a no-op and the JSON says why.
+///
+typedef struct BenchPerf {
+    int fds[BENCH_PERF_EVENTS];
+    uint64_t values[BENCH_PERF_EVENTS];
+    bool valid[BENCH_PERF_EVENTS];
+    int error;
+} BenchPerf;
+
+///
+/// Open the counters for the calling thread.
+///
+/// @param perf The counters
+///
+/// @return Whether at least one event could be opened
+///
+bool bench_perf_open( BenchPerf *perf );
+
+///
+/// Zero and start the counters.
+///
+/// @param perf The opened counters
+///
+void bench_perf_start( BenchPerf *perf );
+
+///
+/// Stop the counters and read them, scaled up if the kernel multiplexed
+/// them.
+///
+/// @param perf The started counters
+///
+void bench_perf_stop( BenchPerf *perf );
+
+///
+/// Write the last reading as a JSON object, each event divided by ops;
+/// unavailable events are null.
+///
+/// @param perf The stopped counters
+/// @param ops The number of operations measured
+/// @param out The stream
+///
+void bench_perf_json( const BenchPerf *perf, size_t ops, FILE *out );
+
+///
+/// Close the counters.
+///
+/// @param perf The counters
+///
+void bench_perf_close( BenchPerf *perf );
+
+///
+/// Write a JSON string literal with escaping.
+///
+/// @param out The stream
+/// @param str The string
+///
+void bench_json_string( FILE *out, const char *str );
+
+#endif // BENCH_COMMON_H
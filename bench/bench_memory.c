@@ -0,0 +1,610 @@
+//
+// File name: bench_memory.c
+//
+// Description:
+// Memory footprint of HashADT tables: steady state bytes per entry, peak
+// heap and peak RSS across the rehashes of a build, and allocator call
+// counts for building and destroying each table size under every table
+// configuration.  Large bucket arrays are mapped straight from the OS, so
+// mmap, munmap and mremap are counted with the heap.  Keys are borrowed
+// from one array, malloc'd one by one by the client, or copied into the
+// table's slabs by ht_put_copy().  malloc and friends are interposed
+// (glibc only) to count calls and live bytes; RSS comes from
+// /proc/self/status.  Results are JSON.
+//
+//   cc -O2 -DNDEBUG -IHashADT -Ibench bench/bench_memory.c bench/bench_common.c
+//       HashADT/HashADT.c HashADT/HTSegmented.c HashADT/HTSoA.c
+//       HashADT/HTCompact.c HashADT/HashFunctions.c -lm -pthread -o hashadt_bench_memory
+//   ./hashadt_bench_memory [--config NAME|all] [--sizes A,B,...]
+//       [--client-keys|--copy-keys] [--out FILE]
+//
+// @author Nick Creeley - nc8004
+//
+// version control:
+// git hw6 repository
+//
+// // // // // // // // // // // // // // // // // // // // // // // // // // // // // //
+
+//malloc_usable_size() and the __libc_* entry points are glibc extensions
+
+#define _GNU_SOURCE
+
+//include standard libraries
+
+#include <stdbool.h>
+
+#include <stddef.h>
+
+#include <stdlib.h>
+
+#include <stdint.h>
+
+#include <inttypes.h>
+
+#include <string.h>
+
+#include <assert.h>
+
+#include <stdio.h>
+
+#include <errno.h>
+
+//include header files
+
+#include "HashADT.h"
+
+#include "HashFunctions.h"
+
+#include "bench_common.h"
+
+//most sizes a run can sweep
+
+#define MAX_SIZES 32
+
+/// Who allocates the keys
+
+typedef enum KeyMode {
+    KEYS_BORROWED,          //the benchmark's own array, no allocation
+    KEYS_CLIENT,            //one malloc per key, freed by the delete fcn
+    KEYS_COPIED             //ht_put_copy() into table slabs
+} KeyMode;
+
+static const char *key_mode_names[] = { "borrowed", "client", "copied" };
+
+/// Allocator activity, updated by the interposed functions
+
+typedef struct AllocCounters {
+
+    uint64_t mallocs;
+
+    uint64_t callocs;
+
+    uint64_t reallocs;
+
+    uint64_t aligned;
+
+    uint64_t frees;
+
+    uint64_t maps;          //mmap and mremap calls
+
+    uint64_t unmaps;
+
+    int64_t live;           //usable bytes currently allocated
+
+    int64_t peak;           //highest live since the last reset
+
+} AllocCounters;
+
+static AllocCounters counters;
+
+#ifdef __GLIBC__
+
+#include <malloc.h>
+
+#include <stdarg.h>
+
+#include <sys/mman.h>
+
+#include <sys/syscall.h>
+
+#include <unistd.h>
+
+#define INTERPOSED true
+
+//glibc's own allocator, which the wrappers below forward to
+
+extern void *__libc_malloc( size_t size );
+
+extern void *__libc_calloc( size_t count, size_t size );
+
+extern void *__libc_realloc( void *ptr, size_t size );
+
+extern void *__libc_memalign( size_t alignment, size_t size );
+
+extern void __libc_free( void *ptr );
+
+/// track(): account for a block appearing (bytes > 0) or going (bytes < 0)
+
+static void track( int64_t bytes ) {
+
+    int64_t live = __atomic_add_fetch(&counters.live, bytes, __ATOMIC_RELAXED);
+
+    int64_t peak = __atomic_load_n(&counters.peak, __ATOMIC_RELAXED);
+
+    while(live > peak && !__atomic_compare_exchange_n(&counters.peak, &peak, live,
+            true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+void *malloc( size_t size ) {
+
+    void *ptr = __libc_malloc(size);
+
+    __atomic_add_fetch(&counters.mallocs, 1, __ATOMIC_RELAXED);
+
+    if(ptr != NULL) {
+        track((int64_t) malloc_usable_size(ptr));
+    }
+
+    return ptr;
+}
+
+void *calloc( size_t count, size_t size ) {
+
+    void *ptr = __libc_calloc(count, size);
+
+    __atomic_add_fetch(&counters.callocs, 1, __ATOMIC_RELAXED);
+
+    if(ptr != NULL) {
+        track((int64_t) malloc_usable_size(ptr));
+    }
+
+    return ptr;
+}
+
+void *realloc( void *old, size_t size ) {
+
+    int64_t old_size = old != NULL ? (int64_t) malloc_usable_size(old) : 0;
+
+    void *ptr = __libc_realloc(old, size);
+
+    __atomic_add_fetch(&counters.reallocs, 1, __ATOMIC_RELAXED);
+
+    if(ptr != NULL) {
+
+        track((int64_t) malloc_usable_size(ptr) - old_size);
+
+    } else if(size == 0) {
+
+        track(-old_size);
+    }
+
+    return ptr;
+}
+
+void *aligned_alloc( size_t alignment, size_t size ) {
+
+    void *ptr = __libc_memalign(alignment, size);
+
+    __atomic_add_fetch(&counters.aligned, 1, __ATOMIC_RELAXED);
+
+    if(ptr != NULL) {
+        track((int64_t) malloc_usable_size(ptr));
+    }
+
+    return ptr;
+}
+
+int posix_memalign( void **out, size_t alignment, size_t size ) {
+
+    void *ptr = aligned_alloc(alignment, size);
+
+    if(ptr == NULL) {
+        return ENOMEM;
+    }
+
+    *out = ptr;
+
+    return 0;
+}
+
+void free( void *ptr ) {
+
+    if(ptr == NULL) {
+        return;
+    }
+
+    __atomic_add_fetch(&counters.frees, 1, __ATOMIC_RELAXED);
+
+    track(-(int64_t) malloc_usable_size(ptr));
+
+    __libc_free(ptr);
+}
+
+/// page_round(): the bytes a mapping of length really occupies
+
+static int64_t page_round( size_t length ) {
+
+    return (int64_t) ((length + 4095) & ~(size_t) 4095);
+}
+
+//the mapping calls go straight to the kernel, bypassing glibc's wrappers
+
+void *mmap( void *addr, size_t length, int prot, int flags, int fd, off_t offset ) {
+
+    void *ptr = (void *) syscall(SYS_mmap, addr, length, prot, flags, fd, offset);
+
+    __atomic_add_fetch(&counters.maps, 1, __ATOMIC_RELAXED);
+
+    if(ptr != MAP_FAILED) {
+        track(page_round(length));
+    }
+
+    return ptr;
+}
+
+int munmap( void *addr, size_t length ) {
+
+    int result = (int) syscall(SYS_munmap, addr, length);
+
+    __atomic_add_fetch(&counters.unmaps, 1, __ATOMIC_RELAXED);
+
+    if(result == 0) {
+        track(-page_round(length));
+    }
+
+    return result;
+}
+
+void *mremap( void *old, size_t old_size, size_t new_size, int flags, ... ) {
+
+    void *target = NULL;
+
+    if(flags & MREMAP_FIXED) {
+
+        va_list args;
+
+        va_start(args, flags);
+
+        target = va_arg(args, void *);
+
+        va_end(args);
+    }
+
+    void *ptr = (void *) syscall(SYS_mremap, old, old_size, new_size, flags, target);
+
+    __atomic_add_fetch(&counters.maps, 1, __ATOMIC_RELAXED);
+
+    if(ptr != MAP_FAILED) {
+        track(page_round(new_size) - page_round(old_size));
+    }
+
+    return ptr;
+}
+
+#else
+
+#define INTERPOSED false
+
+#endif
+
+/// snapshot(): copy the counters and restart peak tracking from now
+
+static AllocCounters snapshot( void ) {
+
+    AllocCounters now = counters;
+
+    counters.peak = counters.live;
+
+    return now;
+}
+
+/// proc_status_kb(): a "Name:   123 kB" field of /proc/self/status
+
+static int64_t proc_status_kb( const char *field ) {
+
+    FILE *in = fopen("/proc/self/status", "r");
+
+    if(in == NULL) {
+        return -1;
+    }
+
+    char line[256];
+
+    size_t length = strlen(field);
+
+    int64_t kb = -1;
+
+    while(fgets(line, sizeof(line), in) != NULL) {
+
+        if(strncmp(line, field, length) == 0 && line[length] == ':') {
+
+            kb = strtoll(line + length + 1, NULL, 10);
+
+            break;
+        }
+    }
+
+    fclose(in);
+
+    return kb;
+}
+
+/// reset_peak_rss(): restart VmHWM at the current RSS (Linux 4.0+)
+
+static bool reset_peak_rss( void ) {
+
+    FILE *out = fopen("/proc/self/clear_refs", "w");
+
+    if(out == NULL) {
+        return false;
+    }
+
+    bool done = fputs("5", out) >= 0;
+
+    return fclose(out) == 0 && done;
+}
+
+/// print_nothing(): print callback required by ht_create
+
+static void print_nothing( const void *key, const void *value ) {
+
+    (void) key;
+
+    (void) value;
+}
+
+/// delete_key(): frees client allocated keys
+
+static void delete_key( void *key, void *value ) {
+
+    (void) value;
+
+    free(key);
+}
+
+/// json_counts(): allocator calls between two snapshots
+
+static void json_counts( FILE *out, const AllocCounters *before, const AllocCounters *after ) {
+
+    fprintf(out, "{\"malloc\": %" PRIu64 ", \"calloc\": %" PRIu64 ", \"realloc\": %" PRIu64
+        ", \"aligned\": %" PRIu64 ", \"free\": %" PRIu64 ", \"map\": %" PRIu64 ", \"unmap\": %" PRIu64 "}",
+        after -> mallocs - before -> mallocs, after -> callocs - before -> callocs,
+        after -> reallocs - before -> reallocs, after -> aligned - before -> aligned,
+        after -> frees - before -> frees, after -> maps - before -> maps,
+        after -> unmaps - before -> unmaps);
+}
+
+/// run_one(): build and destroy one table, measuring memory throughout
+
+static void run_one( const BenchConfig *config, size_t n, KeyMode mode,
+        const uint64_t *values, FILE *out, bool first ) {
+
+    HTOptions options;
+
+    config -> options(&options);
+
+    //measure from a settled heap
+
+    bool peak_reset = reset_peak_rss();
+
+    int64_t rss_before = proc_status_kb("VmRSS");
+
+    AllocCounters base = snapshot();
+
+    HashADT t = ht_create_opts(ht_hash_u64, ht_equals_u64, print_nothing,
+        mode == KEYS_CLIENT ? delete_key : NULL, &options);
+
+    for(size_t i = 0; i < n; i++) {
+
+        const uint64_t *key = &values[i];
+
+        if(mode == KEYS_COPIED) {
+
+            ht_put_copy(t, key, sizeof(uint64_t), NULL, 0);
+
+            continue;
+        }
+
+        if(mode == KEYS_CLIENT) {
+
+            uint64_t *copy = (uint64_t*)malloc(sizeof(uint64_t));
+
+            assert(copy != NULL);
+
+            *copy = values[i];
+
+            key = copy;
+        }
+
+        ht_put(t, key, NULL);
+    }
+
+    AllocCounters built = snapshot();
+
+    int64_t rss_built = proc_status_kb("VmRSS");
+
+    int64_t rss_peak = proc_status_kb("VmHWM");
+
+    HTStats stats;
+
+    ht_stats(t, &stats);
+
+    AllocCounters stats_done = snapshot();
+
+    uint64_t start = bench_now_ns();
+
+    ht_destroy(t);
+
+    uint64_t destroy_ns = bench_now_ns() - start;
+
+    AllocCounters destroyed = snapshot();
+
+    //report
+
+    int64_t steady = built.live - base.live;
+
+    int64_t peak = built.peak - base.live;
+
+    fprintf(out, "%s\n    {\"config\": ", first ? "" : ",");
+
+    bench_json_string(out, config -> name);
+
+    fprintf(out, ", \"size\": %zu, \"keys\": \"%s\", \"capacity\": %" PRIu64,
+        n, key_mode_names[mode], stats.capacity);
+
+    fprintf(out, ",\n     \"heap_bytes\": %" PRId64 ", \"bytes_per_entry\": %.2f"
+        ", \"peak_heap_bytes\": %" PRId64 ", \"peak_to_steady\": %.2f, \"table_bytes_used\": %" PRIu64
+        ", \"arena_bytes\": %" PRIu64,
+        steady, n > 0 ? (double) steady / n : 0.0, peak,
+        steady > 0 ? (double) peak / steady : 0.0, stats.bytes_used, stats.arena_bytes);
+
+    fprintf(out, ",\n     \"rss_before_kb\": %" PRId64 ", \"rss_built_kb\": %" PRId64
+        ", \"peak_rss_kb\": %" PRId64 ", \"peak_rss_reset\": %s",
+        rss_before, rss_built, rss_peak, peak_reset ? "true" : "false");
+
+    fprintf(out, ",\n     \"build_calls\": ");
+
+    json_counts(out, &base, &built);
+
+    fprintf(out, ",\n     \"destroy_calls\": ");
+
+    json_counts(out, &stats_done, &destroyed);
+
+    fprintf(out, ", \"destroy_ns\": %" PRIu64 "}", destroy_ns);
+
+    fflush(out);
+}
+
+/// usage(): print the command line help
+
+static void usage( const char *program ) {
+
+    fprintf(stderr, "usage: %s [--config NAME|all] [--sizes A,B,...] "
+        "[--client-keys|--copy-keys] [--out FILE]\nconfigurations:", program);
+
+    for(const BenchConfig *config = bench_configs; config -> name != NULL; config++) {
+
+        fprintf(stderr, " %s", config -> name);
+    }
+
+    fprintf(stderr, "\n");
+}
+
+/// main(): parse settings and run every size under every configuration
+
+int main( int argc, char *argv[] ) {
+
+    const char *only = "all";
+
+    KeyMode mode = KEYS_BORROWED;
+
+    size_t sizes[MAX_SIZES] = { 1024, 8192, 65536, 524288, 4194304, 16777216 };
+
+    size_t size_count = 6;
+
+    FILE *out = stdout;
+
+    for(int i = 1; i < argc; i++) {
+
+        if(strcmp(argv[i], "--client-keys") == 0) {
+
+            mode = KEYS_CLIENT;
+
+        } else if(strcmp(argv[i], "--copy-keys") == 0) {
+
+            mode = KEYS_COPIED;
+
+        } else if(strcmp(argv[i], "--config") == 0 && i + 1 < argc) {
+
+            only = argv[++i];
+
+        } else if(strcmp(argv[i], "--sizes") == 0 && i + 1 < argc) {
+
+            char *rest = argv[++i];
+
+            size_count = 0;
+
+            while(*rest != '\0' && size_count < MAX_SIZES) {
+
+                sizes[size_count++] = strtoull(rest, &rest, 10);
+
+                if(*rest == ',') {
+                    rest++;
+                }
+            }
+
+        } else if(strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+
+            out = fopen(argv[++i], "w");
+
+            if(out == NULL) {
+
+                perror(argv[i]);
+
+                return EXIT_FAILURE;
+            }
+
+        } else {
+
+            usage(argv[0]);
+
+            return EXIT_FAILURE;
+        }
+    }
+
+    if(strcmp(only, "all") != 0 && bench_config_find(only) == NULL) {
+
+        usage(argv[0]);
+
+        return EXIT_FAILURE;
+    }
+
+    //one key array, big enough for the largest size
+
+    size_t largest = 0;
+
+    for(size_t s = 0; s < size_count; s++) {
+
+        if(sizes[s] > largest) {
+            largest = sizes[s];
+        }
+    }
+
+    uint64_t *values = (uint64_t*)malloc((largest > 0 ? largest : 1) * sizeof(uint64_t));
+
+    assert(values != NULL);
+
+    for(size_t i = 0; i < largest; i++) {
+
+        values[i] = i * 0x9e3779b97f4a7c15ULL;
+    }
+
+    fprintf(out, "{\n  \"benchmark\": \"hashadt_memory\",\n  \"interposed\": %s,\n  \"results\": [",
+        INTERPOSED ? "true" : "false");
+
+    bool first = true;
+
+    for(size_t s = 0; s < size_count; s++) {
+
+        for(const BenchConfig *config = bench_configs; config -> name != NULL; config++) {
+
+            if(strcmp(only, "all") == 0 || strcmp(only, config -> name) == 0) {
+
+                run_one(config, sizes[s], mode, values, out, first);
+
+                first = false;
+            }
+        }
+    }
+
+    fprintf(out, "\n  ]\n}\n");
+
+    if(out != stdout) {
+        fclose(out);
+    }
+
+    free(values);
+
+    return EXIT_SUCCESS;
+}
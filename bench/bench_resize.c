@@ -0,0 +1,321 @@
+//
+// File name: bench_resize.c
+//
+// Description:
+// Tail latency of ht_put while a table grows to a large size.  Every
+// insert is timed into an HDR-style histogram; inserts that made the
+// table rehash are recorded separately with their pause, so P99/P99.9/max
+// can be told apart from ordinary probing.  Runs once per table
+// configuration, so every growth and rehash strategy the library offers
+// is measured the same way.
+//
+//   cc -O2 -DNDEBUG -IHashADT -Ibench bench/bench_resize.c bench/bench_common.c
+//       HashADT/HashADT.c HashADT/HTSegmented.c HashADT/HTSoA.c
+//       HashADT/HTCompact.c HashADT/HashFunctions.c -lm -pthread -o hashadt_bench_resize
+//   ./hashadt_bench_resize [--config NAME|all] [--keys int|string]
+//       [--count N] [--seed S] [--out FILE]
+//
+// @author Nick Creeley - nc8004
+//
+// version control:
+// git hw6 repository
+//
+// // // // // // // // // // // // // // // // // // // // // // // // // // // // // //
+
+//include standard libraries
+
+#include <stdbool.h>
+
+#include <stddef.h>
+
+#include <stdlib.h>
+
+#include <stdint.h>
+
+#include <inttypes.h>
+
+#include <string.h>
+
+#include <assert.h>
+
+#include <stdio.h>
+
+//include header files
+
+#include "HashADT.h"
+
+#include "HashFunctions.h"
+
+#include "bench_common.h"
+
+//width of a generated string key, including the NUL
+
+#define STRING_KEY 24
+
+//most rehashes listed individually per run (2^64 keys need fewer)
+
+#define MAX_PAUSES 64
+
+/// One insert that rehashed the table
+
+typedef struct Pause {
+
+    size_t op;          //index of the insert (table size before it)
+
+    uint64_t ns;        //latency of that insert
+
+} Pause;
+
+/// print_nothing(): print callback required by ht_create
+
+static void print_nothing( const void *key, const void *value ) {
+
+    (void) key;
+
+    (void) value;
+}
+
+/// run_config(): grow one table to count keys and report its pauses
+
+static void run_config( const BenchConfig *config, const void **keys, size_t count,
+        bool strings, FILE *out, bool first ) {
+
+    HTOptions options;
+
+    config -> options(&options);
+
+    HashADT t = strings
+        ? ht_create_opts(ht_hash_cstr, ht_equals_cstr, print_nothing, NULL, &options)
+        : ht_create_opts(ht_hash_u64, ht_equals_u64, print_nothing, NULL, &options);
+
+    //three views of the same inserts: all, without rehash, only rehash
+
+    static BenchHistogram all, steady, resizing;
+
+    bench_hist_reset(&all);
+
+    bench_hist_reset(&steady);
+
+    bench_hist_reset(&resizing);
+
+    Pause pauses[MAX_PAUSES];
+
+    size_t pause_count = 0;
+
+    uint64_t pause_total = 0;
+
+    uint64_t rehashes = ht_rehash_count(t);
+
+    uint64_t start = bench_now_ns();
+
+    for(size_t i = 0; i < count; i++) {
+
+        uint64_t op_start = bench_now_ns();
+
+        ht_put(t, keys[i], keys[i]);
+
+        uint64_t ns = bench_now_ns() - op_start;
+
+        bench_hist_record(&all, ns);
+
+        uint64_t now = ht_rehash_count(t);
+
+        if(now != rehashes) {
+
+            rehashes = now;
+
+            bench_hist_record(&resizing, ns);
+
+            pause_total += ns;
+
+            if(pause_count < MAX_PAUSES) {
+
+                pauses[pause_count].op = i;
+
+                pauses[pause_count].ns = ns;
+
+                pause_count++;
+            }
+
+        } else {
+
+            bench_hist_record(&steady, ns);
+        }
+    }
+
+    uint64_t elapsed = bench_now_ns() - start;
+
+    HTStats stats;
+
+    ht_stats(t, &stats);
+
+    fprintf(out, "%s\n    {\"config\": ", first ? "" : ",");
+
+    bench_json_string(out, config -> name);
+
+    fprintf(out, ", \"keys\": \"%s\", \"count\": %zu, \"elapsed_ns\": %" PRIu64,
+        strings ? "string" : "int", count, elapsed);
+
+    fprintf(out, ", \"capacity\": %" PRIu64 ", \"rehash_ns\": %" PRIu64 ", \"pause_ns\": %" PRIu64,
+        stats.capacity, stats.rehash_ns, pause_total);
+
+    fprintf(out, ",\n     \"all\": {");
+
+    bench_hist_json(&all, out);
+
+    fprintf(out, "},\n     \"steady\": {");
+
+    bench_hist_json(&steady, out);
+
+    fprintf(out, "},\n     \"resizing\": {");
+
+    bench_hist_json(&resizing, out);
+
+    fprintf(out, "},\n     \"pauses\": [");
+
+    for(size_t p = 0; p < pause_count; p++) {
+
+        fprintf(out, "%s{\"op\": %zu, \"ns\": %" PRIu64 "}",
+            p == 0 ? "" : ", ", pauses[p].op, pauses[p].ns);
+    }
+
+    fprintf(out, "]}");
+
+    fflush(out);
+
+    ht_destroy(t);
+}
+
+/// usage(): print the command line help
+
+static void usage( const char *program ) {
+
+    fprintf(stderr, "usage: %s [--config NAME|all] [--keys int|string] "
+        "[--count N] [--seed S] [--out FILE]\nconfigurations:", program);
+
+    for(const BenchConfig *config = bench_configs; config -> name != NULL; config++) {
+
+        fprintf(stderr, " %s", config -> name);
+    }
+
+    fprintf(stderr, "\n");
+}
+
+/// main(): parse settings and run every selected configuration
+
+int main( int argc, char *argv[] ) {
+
+    const char *only = "all";
+
+    bool strings = false;
+
+    size_t count = (size_t) 1 << 24;
+
+    uint64_t seed = 1;
+
+    FILE *out = stdout;
+
+    for(int i = 1; i + 1 < argc; i += 2) {
+
+        if(strcmp(argv[i], "--config") == 0) {
+
+            only = argv[i + 1];
+
+        } else if(strcmp(argv[i], "--keys") == 0) {
+
+            strings = strcmp(argv[i + 1], "string") == 0;
+
+        } else if(strcmp(argv[i], "--count") == 0) {
+
+            count = strtoull(argv[i + 1], NULL, 10);
+
+        } else if(strcmp(argv[i], "--seed") == 0) {
+
+            seed = strtoull(argv[i + 1], NULL, 10);
+
+        } else if(strcmp(argv[i], "--out") == 0) {
+
+            out = fopen(argv[i + 1], "w");
+
+            if(out == NULL) {
+
+                perror(argv[i + 1]);
+
+                return EXIT_FAILURE;
+            }
+
+        } else {
+
+            usage(argv[0]);
+
+            return EXIT_FAILURE;
+        }
+    }
+
+    if(argc % 2 == 0 || (strcmp(only, "all") != 0 && bench_config_find(only) == NULL)) {
+
+        usage(argv[0]);
+
+        return EXIT_FAILURE;
+    }
+
+    //distinct random keys
+
+    BenchRng rng;
+
+    bench_rng_seed(&rng, seed);
+
+    uint64_t *ints = (uint64_t*)malloc(count * sizeof(uint64_t));
+
+    char *text = strings ? (char*)malloc(count * STRING_KEY) : NULL;
+
+    const void **keys = (const void**)malloc(count * sizeof(void*));
+
+    assert(ints != NULL && keys != NULL && (!strings || text != NULL));
+
+    uint64_t salt = bench_rng_next(&rng);
+
+    for(size_t i = 0; i < count; i++) {
+
+        ints[i] = (i + salt) * 0x9e3779b97f4a7c15ULL;
+
+        if(strings) {
+
+            snprintf(text + i * STRING_KEY, STRING_KEY, "key:%016" PRIx64, ints[i]);
+
+            keys[i] = text + i * STRING_KEY;
+
+        } else {
+
+            keys[i] = &ints[i];
+        }
+    }
+
+    fprintf(out, "{\n  \"benchmark\": \"hashadt_resize\",\n  \"results\": [");
+
+    bool first = true;
+
+    for(const BenchConfig *config = bench_configs; config -> name != NULL; config++) {
+
+        if(strcmp(only, "all") == 0 || strcmp(only, config -> name) == 0) {
+
+            run_config(config, keys, count, strings, out, first);
+
+            first = false;
+        }
+    }
+
+    fprintf(out, "\n  ]\n}\n");
+
+    if(out != stdout) {
+        fclose(out);
+    }
+
+    free(ints);
+
+    free(text);
+
+    free(keys);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,763 @@
+//
+// File name: bench_threads.c
+//
+// Description:
+// Scaling of concurrent HashADT access from 1 to N threads.  HashADT has
+// no internal locking, so each access mode wraps it the way a client
+// would: one global mutex around every call, or a reader/writer lock
+// that lets lookups run in parallel (only sound when the library was
+// built without HASHADT_STATS, since counted lookups write to the table).
+// Threads are pinned, and placed across NUMA nodes either spread or
+// compact.  Reports aggregate throughput, per thread operation counts,
+// Jain's fairness index and speedup over one thread as JSON.
+//
+//   cc -O2 -DNDEBUG -IHashADT -Ibench bench/bench_threads.c bench/bench_common.c
+//       HashADT/HashADT.c HashADT/HTSegmented.c HashADT/HTSoA.c
+//       HashADT/HTCompact.c HashADT/HashFunctions.c -lm -lpthread -o hashadt_bench_threads
+//   ./hashadt_bench_threads --help
+//
+// @author Nick Creeley - nc8004
+//
+// version control:
+// git hw6 repository
+//
+// // // // // // // // // // // // // // // // // // // // // // // // // // // // // //
+
+//pthread_setaffinity_np() and CPU_SET are GNU extensions
+
+#define _GNU_SOURCE
+
+//include standard libraries
+
+#include <stdbool.h>
+
+#include <stddef.h>
+
+#include <stdlib.h>
+
+#include <stdint.h>
+
+#include <inttypes.h>
+
+#include <string.h>
+
+#include <assert.h>
+
+#include <stdio.h>
+
+#include <time.h>
+
+#include <pthread.h>
+
+#include <sched.h>
+
+#include <unistd.h>
+
+//include header files
+
+#include "HashADT.h"
+
+#include "HashFunctions.h"
+
+#include "bench_common.h"
+
+//most thread counts and read ratios a run can sweep
+
+#define MAX_POINTS 32
+
+//most CPUs the placement tables hold
+
+#define MAX_CPUS 1024
+
+//operations drawn ahead of time per thread, then replayed in a loop
+
+#define SEQUENCE 65536
+
+/// How threads reach the table
+
+typedef enum Mode {
+    MODE_MUTEX,
+    MODE_RWLOCK
+} Mode;
+
+static const char *mode_names[] = { "mutex", "rwlock" };
+
+/// The settings of one run, from the command line
+
+typedef struct Settings {
+
+    size_t threads[MAX_POINTS];
+
+    size_t thread_count;
+
+    double reads[MAX_POINTS];
+
+    size_t read_count;
+
+    double theta;           //zipf skew of key popularity, 0 for uniform
+
+    size_t keys;
+
+    double seconds;
+
+    bool spread;            //round robin over NUMA nodes, else fill node by node
+
+    bool modes[2];
+
+    const char *config;
+
+    FILE *out;
+
+} Settings;
+
+/// State shared by the threads of one measurement
+
+typedef struct Shared {
+
+    HashADT table;
+
+    Mode mode;
+
+    pthread_mutex_t mutex;
+
+    pthread_rwlock_t rwlock;
+
+    pthread_barrier_t start;
+
+    int stop;               //set by the main thread to end a measurement
+
+} Shared;
+
+/// One worker thread
+
+typedef struct Worker {
+
+    Shared *shared;
+
+    int cpu;                //CPU to pin to, or -1
+
+    const void **sequence;  //SEQUENCE keys
+
+    bool *writes;           //SEQUENCE flags, true for ht_put
+
+    uint64_t ops;
+
+    pthread_t thread;
+
+} Worker;
+
+//the CPUs in placement order, and the node of each
+
+static int cpu_order[MAX_CPUS];
+
+static int cpu_node[MAX_CPUS];
+
+static size_t cpu_count = 0;
+
+static size_t node_count = 1;
+
+/// print_nothing(): print callback required by ht_create
+
+static void print_nothing( const void *key, const void *value ) {
+
+    (void) key;
+
+    (void) value;
+}
+
+/// parse_cpulist(): mark the CPUs of a sysfs list like "0-3,8-11"
+
+static size_t parse_cpulist( const char *list, int *cpus, size_t room ) {
+
+    size_t count = 0;
+
+    const char *p = list;
+
+    while(*p != '\0' && *p != '\n') {
+
+        char *end;
+
+        long first = strtol(p, &end, 10);
+
+        long last = first;
+
+        if(end == p) {
+            break;
+        }
+
+        if(*end == '-') {
+
+            p = end + 1;
+
+            last = strtol(p, &end, 10);
+        }
+
+        for(long cpu = first; cpu <= last && count < room; cpu++) {
+
+            cpus[count++] = (int) cpu;
+        }
+
+        p = *end == ',' ? end + 1 : end;
+    }
+
+    return count;
+}
+
+/// discover_cpus(): CPUs per NUMA node from sysfs, ordered for placement
+///
+/// spread takes one CPU from each node in turn so every added thread
+/// lands on the least loaded socket; compact fills node 0 first, so the
+/// curve shows where the interconnect starts to matter
+
+static void discover_cpus( bool spread ) {
+
+    static int node_cpus[64][MAX_CPUS];
+
+    size_t node_sizes[64] = { 0 };
+
+    node_count = 0;
+
+    for(size_t node = 0; node < 64; node++) {
+
+        char path[128];
+
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%zu/cpulist", node);
+
+        FILE *in = fopen(path, "r");
+
+        if(in == NULL) {
+
+            if(node_count > 0) {
+                break;
+            }
+
+            continue;
+        }
+
+        char list[4096];
+
+        if(fgets(list, sizeof(list), in) != NULL) {
+
+            node_sizes[node_count] = parse_cpulist(list, node_cpus[node_count], MAX_CPUS);
+
+            node_count++;
+        }
+
+        fclose(in);
+    }
+
+    //no NUMA information: one node with every online CPU
+
+    if(node_count == 0) {
+
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+
+        node_count = 1;
+
+        node_sizes[0] = online > 0 && online < MAX_CPUS ? (size_t) online : 1;
+
+        for(size_t i = 0; i < node_sizes[0]; i++) {
+
+            node_cpus[0][i] = (int) i;
+        }
+    }
+
+    cpu_count = 0;
+
+    if(spread) {
+
+        for(size_t round = 0; cpu_count < MAX_CPUS; round++) {
+
+            bool added = false;
+
+            for(size_t node = 0; node < node_count && cpu_count < MAX_CPUS; node++) {
+
+                if(round < node_sizes[node]) {
+
+                    cpu_node[cpu_count] = (int) node;
+
+                    cpu_order[cpu_count++] = node_cpus[node][round];
+
+                    added = true;
+                }
+            }
+
+            if(!added) {
+                break;
+            }
+        }
+
+    } else {
+
+        for(size_t node = 0; node < node_count; node++) {
+
+            for(size_t i = 0; i < node_sizes[node] && cpu_count < MAX_CPUS; i++) {
+
+                cpu_node[cpu_count] = (int) node;
+
+                cpu_order[cpu_count++] = node_cpus[node][i];
+            }
+        }
+    }
+}
+
+/// worker_main(): pin, wait for the start, then run until stopped
+
+static void *worker_main( void *arg ) {
+
+    Worker *worker = (Worker *) arg;
+
+    Shared *shared = worker -> shared;
+
+    if(worker -> cpu >= 0) {
+
+        cpu_set_t set;
+
+        CPU_ZERO(&set);
+
+        CPU_SET(worker -> cpu, &set);
+
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+
+    pthread_barrier_wait(&shared -> start);
+
+    uint64_t ops = 0;
+
+    size_t i = 0;
+
+    while(!__atomic_load_n(&shared -> stop, __ATOMIC_ACQUIRE)) {
+
+        const void *key = worker -> sequence[i];
+
+        bool write = worker -> writes[i];
+
+        if(shared -> mode == MODE_MUTEX) {
+
+            pthread_mutex_lock(&shared -> mutex);
+
+            if(write) {
+                ht_put(shared -> table, key, key);
+            } else {
+                ht_get(shared -> table, key);
+            }
+
+            pthread_mutex_unlock(&shared -> mutex);
+
+        } else if(write) {
+
+            pthread_rwlock_wrlock(&shared -> rwlock);
+
+            ht_put(shared -> table, key, key);
+
+            pthread_rwlock_unlock(&shared -> rwlock);
+
+        } else {
+
+            pthread_rwlock_rdlock(&shared -> rwlock);
+
+            ht_get(shared -> table, key);
+
+            pthread_rwlock_unlock(&shared -> rwlock);
+        }
+
+        ops++;
+
+        i = (i + 1) % SEQUENCE;
+    }
+
+    worker -> ops = ops;
+
+    return NULL;
+}
+
+/// measure(): run threads for the configured time, return total ops/s
+
+static double measure( const Settings *settings, Shared *shared, Worker *workers,
+        size_t threads, const void **keys, double read_ratio, const BenchZipf *zipf,
+        BenchRng *rng, FILE *out, double baseline ) {
+
+    //fresh operation sequences per measurement
+
+    for(size_t w = 0; w < threads; w++) {
+
+        for(size_t i = 0; i < SEQUENCE; i++) {
+
+            uint64_t rank = zipf != NULL
+                ? bench_zipf_next(zipf, rng) : bench_rng_below(rng, settings -> keys);
+
+            workers[w].sequence[i] = keys[rank];
+
+            workers[w].writes[i] = bench_rng_unit(rng) >= read_ratio;
+        }
+
+        workers[w].shared = shared;
+
+        workers[w].cpu = cpu_count > 0 ? cpu_order[w % cpu_count] : -1;
+
+        workers[w].ops = 0;
+    }
+
+    shared -> stop = 0;
+
+    pthread_barrier_init(&shared -> start, NULL, (unsigned) threads + 1);
+
+    for(size_t w = 0; w < threads; w++) {
+
+        pthread_create(&workers[w].thread, NULL, worker_main, &workers[w]);
+    }
+
+    pthread_barrier_wait(&shared -> start);
+
+    uint64_t begin = bench_now_ns();
+
+    struct timespec pause = {
+        (time_t) settings -> seconds,
+        (long) ((settings -> seconds - (double) (time_t) settings -> seconds) * 1e9)
+    };
+
+    nanosleep(&pause, NULL);
+
+    __atomic_store_n(&shared -> stop, 1, __ATOMIC_RELEASE);
+
+    for(size_t w = 0; w < threads; w++) {
+
+        pthread_join(workers[w].thread, NULL);
+    }
+
+    double elapsed = (double) (bench_now_ns() - begin) / 1e9;
+
+    pthread_barrier_destroy(&shared -> start);
+
+    //throughput and fairness: Jain's index is 1 when every thread did
+    //the same work and 1/threads when one thread did all of it
+
+    double total = 0.0, squares = 0.0;
+
+    uint64_t fewest = UINT64_MAX, most = 0;
+
+    for(size_t w = 0; w < threads; w++) {
+
+        double ops = (double) workers[w].ops;
+
+        total += ops;
+
+        squares += ops * ops;
+
+        if(workers[w].ops < fewest) {
+            fewest = workers[w].ops;
+        }
+
+        if(workers[w].ops > most) {
+            most = workers[w].ops;
+        }
+    }
+
+    double throughput = total / elapsed;
+
+    double jain = squares > 0 ? total * total / (threads * squares) : 0.0;
+
+    fprintf(out, ", \"threads\": %zu, \"seconds\": %.3f, \"ops_per_s\": %.0f", threads, elapsed, throughput);
+
+    fprintf(out, ", \"speedup\": %.3f, \"efficiency\": %.3f",
+        baseline > 0 ? throughput / baseline : 1.0,
+        baseline > 0 ? throughput / baseline / threads : 1.0);
+
+    fprintf(out, ", \"jain_fairness\": %.4f, \"min_max_ratio\": %.4f",
+        jain, most > 0 ? (double) fewest / most : 0.0);
+
+    fprintf(out, ",\n     \"per_thread\": [");
+
+    for(size_t w = 0; w < threads; w++) {
+
+        fprintf(out, "%s{\"cpu\": %d, \"node\": %d, \"ops\": %" PRIu64 "}",
+            w == 0 ? "" : ", ", workers[w].cpu,
+            workers[w].cpu >= 0 && cpu_count > 0 ? cpu_node[w % cpu_count] : -1, workers[w].ops);
+    }
+
+    fprintf(out, "]}");
+
+    fflush(out);
+
+    return throughput;
+}
+
+/// parse_list(): comma separated numbers
+
+static size_t parse_list( const char *text, double *values, size_t room ) {
+
+    size_t count = 0;
+
+    char *rest = (char *) text;
+
+    while(*rest != '\0' && count < room) {
+
+        values[count++] = strtod(rest, &rest);
+
+        if(*rest != ',') {
+            break;
+        }
+
+        rest++;
+    }
+
+    return count;
+}
+
+/// usage(): print the command line help
+
+static void usage( const char *program ) {
+
+    fprintf(stderr,
+        "usage: %s [options]\n"
+        "  --threads A,B,...   thread counts (default 1,2,4,... up to the CPU count)\n"
+        "  --reads A,B,...     fractions of operations that are ht_get (default 0.5,0.9,0.99)\n"
+        "  --theta T           zipf skew of key popularity, 0 for uniform (default 0.99)\n"
+        "  --keys N            keys in the table (default 1000000)\n"
+        "  --seconds S         time per measurement (default 1)\n"
+        "  --placement P       spread or compact over NUMA nodes (default spread)\n"
+        "  --mode M            mutex, rwlock or both (default both)\n"
+        "  --config NAME       table configuration (default default)\n"
+        "  --out FILE          write JSON to FILE instead of stdout\n",
+        program);
+}
+
+/// main(): parse settings, fill a table and sweep threads and read ratios
+
+int main( int argc, char *argv[] ) {
+
+    Settings settings = {
+        { 0 }, 0, { 0.5, 0.9, 0.99 }, 3, 0.99, 1000000, 1.0, true, { true, true }, "default", stdout
+    };
+
+    for(int i = 1; i + 1 < argc; i += 2) {
+
+        const char *arg = argv[i], *value = argv[i + 1];
+
+        double list[MAX_POINTS];
+
+        if(strcmp(arg, "--threads") == 0) {
+
+            settings.thread_count = parse_list(value, list, MAX_POINTS);
+
+            for(size_t t = 0; t < settings.thread_count; t++) {
+
+                settings.threads[t] = list[t] >= 1 ? (size_t) list[t] : 1;
+            }
+
+        } else if(strcmp(arg, "--reads") == 0) {
+
+            settings.read_count = parse_list(value, settings.reads, MAX_POINTS);
+
+        } else if(strcmp(arg, "--theta") == 0) {
+
+            settings.theta = atof(value);
+
+        } else if(strcmp(arg, "--keys") == 0) {
+
+            settings.keys = strtoull(value, NULL, 10);
+
+        } else if(strcmp(arg, "--seconds") == 0) {
+
+            settings.seconds = atof(value);
+
+        } else if(strcmp(arg, "--placement") == 0) {
+
+            settings.spread = strcmp(value, "compact") != 0;
+
+        } else if(strcmp(arg, "--mode") == 0) {
+
+            settings.modes[MODE_MUTEX] = strcmp(value, "rwlock") != 0;
+
+            settings.modes[MODE_RWLOCK] = strcmp(value, "mutex") != 0;
+
+        } else if(strcmp(arg, "--config") == 0) {
+
+            settings.config = value;
+
+        } else if(strcmp(arg, "--out") == 0) {
+
+            settings.out = fopen(value, "w");
+
+            if(settings.out == NULL) {
+
+                perror(value);
+
+                return EXIT_FAILURE;
+            }
+
+        } else {
+
+            usage(argv[0]);
+
+            return EXIT_FAILURE;
+        }
+    }
+
+    const BenchConfig *config = bench_config_find(settings.config);
+
+    if(argc % 2 == 0 || config == NULL || settings.keys == 0) {
+
+        usage(argv[0]);
+
+        return EXIT_FAILURE;
+    }
+
+    discover_cpus(settings.spread);
+
+    if(settings.thread_count == 0) {
+
+        for(size_t t = 1; t <= cpu_count && settings.thread_count < MAX_POINTS; t *= 2) {
+
+            settings.threads[settings.thread_count++] = t;
+        }
+
+        if(settings.threads[settings.thread_count - 1] != cpu_count && settings.thread_count < MAX_POINTS) {
+
+            settings.threads[settings.thread_count++] = cpu_count;
+        }
+    }
+
+    //fill the table; writes later update these keys, so its size is steady
+
+    uint64_t *ints = (uint64_t*)malloc(settings.keys * sizeof(uint64_t));
+
+    const void **keys = (const void**)malloc(settings.keys * sizeof(void*));
+
+    assert(ints != NULL && keys != NULL);
+
+    HTOptions options;
+
+    config -> options(&options);
+
+    Shared shared;
+
+    shared.table = ht_create_opts(ht_hash_u64, ht_equals_u64, print_nothing, NULL, &options);
+
+    pthread_mutex_init(&shared.mutex, NULL);
+
+    pthread_rwlock_init(&shared.rwlock, NULL);
+
+    for(size_t i = 0; i < settings.keys; i++) {
+
+        ints[i] = i * 0x9e3779b97f4a7c15ULL;
+
+        keys[i] = &ints[i];
+
+        ht_put(shared.table, keys[i], keys[i]);
+    }
+
+    //counted lookups write to the table, so they cannot share a read lock
+
+    HTStats stats;
+
+    ht_stats(shared.table, &stats);
+
+    if(stats.counters && settings.modes[MODE_RWLOCK]) {
+
+        fprintf(stderr, "library built with HASHADT_STATS: skipping rwlock mode\n");
+
+        settings.modes[MODE_RWLOCK] = false;
+    }
+
+    BenchZipf zipf;
+
+    if(settings.theta > 0.0) {
+
+        bench_zipf_init(&zipf, settings.keys, settings.theta);
+    }
+
+    size_t most = 0;
+
+    for(size_t t = 0; t < settings.thread_count; t++) {
+
+        if(settings.threads[t] > most) {
+            most = settings.threads[t];
+        }
+    }
+
+    Worker *workers = (Worker*)calloc(most, sizeof(Worker));
+
+    assert(workers != NULL);
+
+    for(size_t w = 0; w < most; w++) {
+
+        workers[w].sequence = (const void**)malloc(SEQUENCE * sizeof(void*));
+
+        workers[w].writes = (bool*)malloc(SEQUENCE * sizeof(bool));
+
+        assert(workers[w].sequence != NULL && workers[w].writes != NULL);
+    }
+
+    BenchRng rng;
+
+    bench_rng_seed(&rng, 1);
+
+    FILE *out = settings.out;
+
+    fprintf(out, "{\n  \"benchmark\": \"hashadt_threads\",\n  \"config\": ");
+
+    bench_json_string(out, config -> name);
+
+    fprintf(out, ",\n  \"keys\": %zu, \"theta\": %.3f, \"placement\": \"%s\", \"numa_nodes\": %zu, \"cpus\": %zu,\n  \"results\": [",
+        settings.keys, settings.theta, settings.spread ? "spread" : "compact", node_count, cpu_count);
+
+    bool first = true;
+
+    for(int mode = MODE_MUTEX; mode <= MODE_RWLOCK; mode++) {
+
+        if(!settings.modes[mode]) {
+            continue;
+        }
+
+        shared.mode = (Mode) mode;
+
+        for(size_t r = 0; r < settings.read_count; r++) {
+
+            double baseline = 0.0;
+
+            for(size_t t = 0; t < settings.thread_count; t++) {
+
+                fprintf(out, "%s\n    {\"mode\": \"%s\", \"read_ratio\": %.3f",
+                    first ? "" : ",", mode_names[mode], settings.reads[r]);
+
+                first = false;
+
+                double throughput = measure(&settings, &shared, workers, settings.threads[t],
+                    keys, settings.reads[r], settings.theta > 0.0 ? &zipf : NULL, &rng, out, baseline);
+
+                if(t == 0) {
+
+                    baseline = throughput / settings.threads[0];
+                }
+            }
+        }
+    }
+
+    fprintf(out, "\n  ]\n}\n");
+
+    if(out != stdout) {
+        fclose(out);
+    }
+
+    for(size_t w = 0; w < most; w++) {
+
+        free(workers[w].sequence);
+
+        free(workers[w].writes);
+    }
+
+    free(workers);
+
+    ht_destroy(shared.table);
+
+    pthread_mutex_destroy(&shared.mutex);
+
+    pthread_rwlock_destroy(&shared.rwlock);
+
+    free(ints);
+
+    free(keys);
+
+    return EXIT_SUCCESS;
+}
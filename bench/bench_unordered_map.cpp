@@ -0,0 +1,112 @@
+//
+// File name: bench_unordered_map.cpp
+//
+// Description:
+// std::unordered_map baseline for bench.c.  Keys are the same pointers
+// the HashADT tables store, hashed and compared through the same
+// HashFunctions.h callbacks, so the comparison is of the tables alone.
+// The map keeps its default max_load_factor of 1.  Linked into bench.c
+// when that is built with -DBENCH_UNORDERED_MAP; see bench.c for the
+// build lines.
+//
+// @author Nick Creeley - nc8004
+//
+// version control:
+// git hw6 repository
+//
+// // // // // // // // // // // // // // // // // // // // // // // // // // // // // //
+
+//include standard libraries
+
+#include <cstddef>
+
+#include <unordered_map>
+
+//include header files
+
+extern "C" {
+
+#include "HashFunctions.h"
+
+}
+
+#include "bench_unordered_map.h"
+
+/// KeyHash: calls a HashFunctions.h hash on the key pointer
+
+struct KeyHash {
+
+    size_t (*hash)( const void *key );
+
+    size_t operator()( const void *key ) const {
+
+        return hash(key);
+    }
+};
+
+/// KeyEquals: calls a HashFunctions.h equals on two key pointers
+
+struct KeyEquals {
+
+    bool (*equals)( const void *key1, const void *key2 );
+
+    bool operator()( const void *key1, const void *key2 ) const {
+
+        return equals(key1, key2);
+    }
+};
+
+typedef std::unordered_map<const void *, const void *, KeyHash, KeyEquals> UnorderedMap;
+
+/// bench_umap_create(): an empty map
+///
+/// see headerfile for full documentation
+
+void *bench_umap_create( bool strings ) {
+
+    KeyHash hash = { strings ? ht_hash_cstr : ht_hash_u64 };
+
+    KeyEquals equals = { strings ? ht_equals_cstr : ht_equals_u64 };
+
+    return new UnorderedMap(16, hash, equals);
+}
+
+/// bench_umap_put(): store or replace a value
+///
+/// see headerfile for full documentation
+
+void bench_umap_put( void *table, const void *key, const void *value ) {
+
+    (*static_cast<UnorderedMap *>(table))[key] = value;
+}
+
+/// bench_umap_get(): the value under a key
+///
+/// see headerfile for full documentation
+
+const void *bench_umap_get( void *table, const void *key ) {
+
+    UnorderedMap *map = static_cast<UnorderedMap *>(table);
+
+    UnorderedMap::const_iterator found = map -> find(key);
+
+    return found == map -> end() ? NULL : found -> second;
+}
+
+/// bench_umap_has(): whether a key is stored
+///
+/// see headerfile for full documentation
+
+bool bench_umap_has( void *table, const void *key ) {
+
+    return static_cast<UnorderedMap *>(table) -> count(key) > 0;
+}
+
+/// bench_umap_destroy(): free the map
+///
+/// see headerfile for full documentation
+
+void bench_umap_destroy( void *table ) {
+
+    delete static_cast<UnorderedMap *>(table);
+}
@@ -0,0 +1,67 @@
+/// \file bench_unordered_map.h
+/// \brief A std::unordered_map baseline for bench.c, behind C functions
+/// that match its Target operations.  Built from bench_unordered_map.cpp
+/// with a C++ compiler when bench.c is built with -DBENCH_UNORDERED_MAP.
+///
+/// @author Nick Creeley - nc8004
+
+#ifndef BENCH_UNORDERED_MAP_H
+#define BENCH_UNORDERED_MAP_H
+
+#include <stdbool.h>    // bool
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+///
+/// Create an empty map over key pointers, hashed and compared with the
+/// same HashFunctions.h callbacks the HashADT tables use.
+///
+/// @param strings True for C string keys, false for uint64_t keys
+///
+/// @return A new map, aborting if it cannot be allocated
+///
+void *bench_umap_create( bool strings );
+
+///
+/// Store value under key, replacing any value already there.
+///
+/// @param table The map
+/// @param key The key, which must outlive the map
+/// @param value The value
+///
+void bench_umap_put( void *table, const void *key, const void *value );
+
+///
+/// The value stored under key.
+///
+/// @param table The map
+/// @param key The key
+///
+/// @return The value, or NULL if key is absent
+///
+const void *bench_umap_get( void *table, const void *key );
+
+///
+/// Whether key is stored.
+///
+/// @param table The map
+/// @param key The key
+///
+/// @return True if key is in the map
+///
+bool bench_umap_has( void *table, const void *key );
+
+///
+/// Destroy the map; the keys and values are left alone.
+///
+/// @param table The map
+///
+void bench_umap_destroy( void *table );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BENCH_UNORDERED_MAP_H
@@ -0,0 +1,817 @@
+//
+// File name: test_hashadt.c
+//
+// Description:
+// Randomized differential test of HashADT: long runs of ht_put, ht_has,
+// ht_get and ht_remove on every layout, on small tables, on tables that
+// grow in place and under every memory budget policy, each checked
+// against a plain array of which keys are stored and with what value.
+// Keys collide on purpose, so probe runs are long and removals shift.
+// Prints one line per configuration and exits nonzero on the first
+// mismatch.  Build it with the sanitizers:
+//
+//   cc -std=c99 -g -fsanitize=address,undefined -IHashADT tests/test_hashadt.c
+//       HashADT/HashADT.c HashADT/HTSegmented.c HashADT/HTSoA.c
+//       HashADT/HTCompact.c HashADT/HashFunctions.c -lm -pthread -o test_hashadt
+//   ./test_hashadt
+//
+// @author Nick Creeley - nc8004
+//
+// version control:
+// git hw6 repository
+//
+// // // // // // // // // // // // // // // // // // // // // // // // // // // // // //
+
+//include standard libraries
+
+#include <stdbool.h>
+
+#include <stddef.h>
+
+#include <stdlib.h>
+
+#include <stdint.h>
+
+#include <string.h>
+
+#include <stdio.h>
+
+//include header files
+
+#include "HashADT.h"
+
+#include "HTLayout.h"
+
+//distinct keys a run draws from, and operations per run
+
+#define KEYS 5000
+
+#define OPS 400000
+
+//fail the whole test, with where and why, even in NDEBUG builds
+
+#define CHECK(cond) \
+    do { \
+        if(!(cond)) { \
+            fprintf(stderr, "%s:%d: %s: check failed: %s\n", __FILE__, __LINE__, current, #cond); \
+            exit(1); \
+        } \
+    } while(0)
+
+//the configuration being run, for failure messages
+
+static const char *current = "";
+
+//the keys, and the reference: whether each is stored and its value
+
+static uint64_t keys[KEYS];
+
+static bool stored[KEYS];
+
+static uintptr_t values[KEYS];
+
+static size_t stored_count;
+
+/// key_hash(): a weak hash, so many keys share a bucket
+
+static size_t key_hash( const void *key ) {
+
+    return (size_t) (*(const uint64_t *) key % 1009);
+}
+
+/// key_equals(): compare two keys
+
+static bool key_equals( const void *key1, const void *key2 ) {
+
+    return *(const uint64_t *) key1 == *(const uint64_t *) key2;
+}
+
+/// key_print(): dump callback; the test never dumps
+
+static void key_print( const void *key, const void *value ) {
+
+    (void) key;
+
+    (void) value;
+}
+
+/// key_index(): the position in keys of a stored key pointer
+
+static size_t key_index( const void *key ) {
+
+    size_t index = (size_t) ((const uint64_t *) key - keys);
+
+    CHECK(index < KEYS);
+
+    return index;
+}
+
+/// key_evicted(): delete callback; only an eviction calls it while the
+/// table lives, so the reference forgets the pair
+
+static bool destroying;
+
+static void key_evicted( void *key, void *value ) {
+
+    if(destroying) {
+        return;
+    }
+
+    size_t i = key_index(key);
+
+    CHECK(stored[i] && (uintptr_t) value == values[i]);
+
+    stored[i] = false;
+
+    stored_count--;
+}
+
+/// heap_alloc(), heap_free(), heap_realloc(): an allocator with a
+/// realloc hook, so grow_in_place tables resize their heap arrays
+
+static void *heap_alloc( void *context, size_t size ) {
+
+    (void) context;
+
+    return malloc(size);
+}
+
+static void heap_free( void *context, void *ptr, size_t size ) {
+
+    (void) context;
+
+    (void) size;
+
+    free(ptr);
+}
+
+static void *heap_realloc( void *context, void *ptr, size_t old_size, size_t new_size ) {
+
+    (void) context;
+
+    (void) old_size;
+
+    return realloc(ptr, new_size);
+}
+
+static const HTAllocator heap = { heap_alloc, NULL, heap_free, NULL, heap_realloc };
+
+/// check_all(): every key agrees with the reference, and ht_keys lists
+/// exactly the stored ones
+
+static void check_all( HashADT t ) {
+
+    CHECK(ht_occupancy(t) == stored_count);
+
+    for(size_t i = 0; i < KEYS; i++) {
+
+        CHECK(ht_has(t, &keys[i]) == stored[i]);
+
+        if(stored[i]) {
+
+            CHECK((uintptr_t) ht_get(t, &keys[i]) == values[i]);
+        }
+    }
+
+    void **listed = ht_keys(t);
+
+    bool *seen = calloc(KEYS, sizeof(bool));
+
+    CHECK(seen != NULL);
+
+    for(size_t j = 0; j < stored_count; j++) {
+
+        size_t i = key_index(listed[j]);
+
+        CHECK(stored[i] && !seen[i]);
+
+        seen[i] = true;
+    }
+
+    free(seen);
+
+    free(listed);
+}
+
+/// run(): OPS random operations on a table made with options
+
+static void run( const char *name, const HTOptions *options ) {
+
+    current = name;
+
+    memset(stored, 0, sizeof(stored));
+
+    stored_count = 0;
+
+    destroying = false;
+
+    HashADT t = ht_create_opts(key_hash, key_equals, key_print, key_evicted, options);
+
+    srand(12345);
+
+    size_t refused = 0;
+
+    for(size_t op = 0; op < OPS; op++) {
+
+        size_t i = (size_t) rand() % KEYS;
+
+        int kind = rand() % 8;
+
+        if(kind < 4) {
+
+            uintptr_t value = (uintptr_t) rand() + 1;
+
+            bool was = stored[i];
+
+            void *old_value = ht_put(t, &keys[i], (void *) value);
+
+            if(ht_error(t) != HT_OK) {
+
+                //only a budget may refuse, and only a new key
+
+                CHECK(options -> memory_budget > 0 && !was && old_value == NULL);
+
+                CHECK(!ht_has(t, &keys[i]));
+
+                refused++;
+
+                continue;
+            }
+
+            CHECK(was ? (uintptr_t) old_value == values[i] : old_value == NULL);
+
+            if(!stored[i]) {
+
+                stored[i] = true;
+
+                stored_count++;
+            }
+
+            values[i] = value;
+
+        } else if(kind < 6) {
+
+            void *key;
+
+            void *value;
+
+            bool removed = ht_remove(t, &keys[i], &key, &value);
+
+            CHECK(removed == stored[i]);
+
+            if(removed) {
+
+                CHECK(key == &keys[i] && (uintptr_t) value == values[i]);
+
+                stored[i] = false;
+
+                stored_count--;
+            }
+
+        } else {
+
+            CHECK(ht_has(t, &keys[i]) == stored[i]);
+
+            if(stored[i]) {
+
+                CHECK((uintptr_t) ht_get(t, &keys[i]) == values[i]);
+            }
+        }
+
+        CHECK(ht_occupancy(t) == stored_count);
+
+        if(options -> memory_budget > 0) {
+
+            CHECK(ht_memory_usage(t) <= options -> memory_budget);
+        }
+
+        if(op % 50000 == 0) {
+
+            check_all(t);
+        }
+    }
+
+    check_all(t);
+
+    HTStats stats;
+
+    ht_stats(t, &stats);
+
+    printf("%-20s ok: %zu keys, capacity %llu, %zu refused, %llu evicted, %zu bytes\n",
+        name, stored_count, (unsigned long long) stats.capacity, refused,
+        (unsigned long long) stats.evictions, ht_memory_usage(t));
+
+    destroying = true;
+
+    ht_destroy(t);
+}
+
+/// run_copies(): ht_put_copy() under a memory budget; a refused pair
+/// leaves no copies behind
+
+static void run_copies( const char *name, HTBudgetPolicy policy ) {
+
+    current = name;
+
+    HTOptions options;
+
+    ht_options_init(&options);
+
+    options.memory_budget = 100000;
+
+    options.budget_policy = policy;
+
+    HashADT t = ht_create_opts(key_hash, key_equals, key_print, NULL, &options);
+
+    size_t refused = 0;
+
+    for(size_t round = 0; round < 2; round++) {
+
+        for(size_t i = 0; i < KEYS; i++) {
+
+            uint64_t value[3] = { keys[i], round, i };
+
+            size_t before = ht_memory_usage(t);
+
+            bool was = ht_has(t, &keys[i]);
+
+            void *old_value = ht_put_copy(t, &keys[i], sizeof(keys[i]), value, sizeof(value));
+
+            CHECK(ht_memory_usage(t) <= options.memory_budget);
+
+            if(ht_error(t) != HT_OK) {
+
+                CHECK(old_value == NULL && ht_has(t, &keys[i]) == was);
+
+                CHECK(ht_memory_usage(t) == before);
+
+                refused++;
+
+                continue;
+            }
+
+            CHECK(was == (old_value != NULL));
+
+            const uint64_t *copy = ht_get(t, &keys[i]);
+
+            CHECK(copy != NULL && memcmp(copy, value, sizeof(value)) == 0);
+        }
+    }
+
+    HTStats stats;
+
+    ht_stats(t, &stats);
+
+    printf("%-20s ok: %llu keys, capacity %llu, %zu refused, %zu bytes\n",
+        name, (unsigned long long) stats.size, (unsigned long long) stats.capacity,
+        refused, ht_memory_usage(t));
+
+    ht_destroy(t);
+}
+
+/// value_bytes(): pair_bytes callback that depends on the value's bytes
+
+static size_t value_bytes( const void *key, const void *value ) {
+
+    (void) key;
+
+    return 8 + (size_t) (*(const uint64_t *) value % 100);
+}
+
+/// run_pair_bytes(): the pair_bytes a table counts always matches the sum
+/// over the stored pairs, for updates and removes too
+
+static void run_pair_bytes( const char *name, HTLayout layout, size_t value_size ) {
+
+    current = name;
+
+    HTOptions options;
+
+    ht_options_init(&options);
+
+    options.layout = layout;
+
+    options.value_size = value_size;
+
+    HashADT plain = ht_create_opts(key_hash, key_equals, key_print, NULL, &options);
+
+    options.pair_bytes = value_bytes;
+
+    HashADT t = ht_create_opts(key_hash, key_equals, key_print, NULL, &options);
+
+    static uint64_t held[OPS / 4];
+
+    memset(stored, 0, sizeof(stored));
+
+    size_t expected = 0;
+
+    srand(777);
+
+    for(size_t op = 0; op < OPS / 4; op++) {
+
+        size_t i = (size_t) rand() % KEYS;
+
+        if(rand() % 3 > 0) {
+
+            //with a value_size the table copies the value, so it may be
+            //a local; otherwise each put gets a value object of its own
+
+            uint64_t value = (uint64_t) rand();
+
+            held[op] = value;
+
+            const void *pointer = value_size > 0 ? (const void *) &value : (const void *) &held[op];
+
+            if(stored[i]) {
+
+                expected -= 8 + (size_t) (values[i] % 100);
+            }
+
+            ht_put(plain, &keys[i], pointer);
+
+            ht_put(t, &keys[i], pointer);
+
+            stored[i] = true;
+
+            values[i] = value;
+
+            expected += 8 + (size_t) (value % 100);
+
+        } else {
+
+            void *key;
+
+            void *value;
+
+            bool removed = ht_remove(t, &keys[i], &key, &value);
+
+            CHECK(removed == stored[i]);
+
+            CHECK(ht_remove(plain, &keys[i], &key, &value) == removed);
+
+            if(removed) {
+
+                stored[i] = false;
+
+                expected -= 8 + (size_t) (values[i] % 100);
+            }
+        }
+
+        CHECK(ht_memory_usage(t) - ht_memory_usage(plain) == expected);
+    }
+
+    printf("%-20s ok: %zu pair bytes\n", name, expected);
+
+    ht_destroy(plain);
+
+    ht_destroy(t);
+}
+
+/// equal_hash(): every key hashes alike, so probes only get longer
+
+static size_t equal_hash( const void *key ) {
+
+    (void) key;
+
+    return 0;
+}
+
+/// run_reseed(): probes that would reseed a table with no room in its
+/// budget for a second array leave it on its seed
+
+static void run_reseed( const char *name ) {
+
+    current = name;
+
+    HTOptions options;
+
+    ht_options_init(&options);
+
+    options.max_probe = 4;
+
+    options.budget_policy = HT_BUDGET_LOAD;
+
+    HashADT free_table = ht_create_opts(equal_hash, key_equals, key_print, NULL, &options);
+
+    options.memory_budget = ht_memory_usage(free_table);
+
+    HashADT t = ht_create_opts(equal_hash, key_equals, key_print, NULL, &options);
+
+    size_t stored_keys = 0;
+
+    for(size_t i = 0; i < 64; i++) {
+
+        ht_put(free_table, &keys[i], NULL);
+
+        ht_put(t, &keys[i], NULL);
+
+        CHECK(ht_memory_usage(t) <= options.memory_budget);
+
+        stored_keys += ht_error(t) == HT_OK;
+    }
+
+    for(size_t i = 0; i < stored_keys; i++) {
+
+        CHECK(ht_has(t, &keys[i]));
+    }
+
+    HTStats free_stats;
+
+    HTStats stats;
+
+    ht_stats(free_table, &free_stats);
+
+    ht_stats(t, &stats);
+
+    CHECK(free_stats.reseeds > 0 && stats.reseeds == 0);
+
+    printf("%-20s ok: %zu keys, %llu reseeds without a budget\n", name,
+        stored_keys, (unsigned long long) free_stats.reseeds);
+
+    ht_destroy(free_table);
+
+    ht_destroy(t);
+}
+
+/// few_hashes(): keys spread over three hash values that differ only in
+/// their top bits, so a split separates at most three groups
+
+static size_t few_hashes( const void *key ) {
+
+    return (size_t) (*(const uint64_t *) key % 3) << (sizeof(size_t) * 8 - 2);
+}
+
+/// run_flood(): every key of a table whose hash values barely differ is
+/// stored and found, removed and missed
+
+static void run_flood( const char *name, HTLayout layout, size_t (*hash)( const void *key ) ) {
+
+    current = name;
+
+    HTOptions options;
+
+    ht_options_init(&options);
+
+    options.layout = layout;
+
+    HashADT t = ht_create_opts(hash, key_equals, key_print, NULL, &options);
+
+    for(size_t i = 0; i < KEYS; i++) {
+
+        CHECK(ht_put(t, &keys[i], &keys[i]) == NULL);
+    }
+
+    for(size_t i = 0; i < KEYS; i++) {
+
+        CHECK(ht_get(t, &keys[i]) == &keys[i]);
+    }
+
+    for(size_t i = 0; i < KEYS; i += 2) {
+
+        void *key;
+
+        void *value;
+
+        CHECK(ht_remove(t, &keys[i], &key, &value) && key == &keys[i]);
+    }
+
+    for(size_t i = 0; i < KEYS; i++) {
+
+        CHECK(ht_has(t, &keys[i]) == (i % 2 == 1));
+    }
+
+    printf("%-20s ok: %zu keys, %zu bytes\n", name, ht_occupancy(t), ht_memory_usage(t));
+
+    ht_destroy(t);
+}
+
+/// run_aliased(): with a value_size, a value may be the copy ht_get()
+/// returned for another key, even across growth
+
+static void run_aliased( const char *name ) {
+
+    current = name;
+
+    HTOptions options;
+
+    ht_options_init(&options);
+
+    options.layout = HT_LAYOUT_SOA;
+
+    options.value_size = 3 * sizeof(uint64_t);
+
+    HashADT t = ht_create_opts(key_hash, key_equals, key_print, NULL, &options);
+
+    uint64_t first[3] = { 1, 2, 3 };
+
+    ht_put(t, &keys[0], first);
+
+    for(size_t i = 1; i < KEYS; i++) {
+
+        ht_put(t, &keys[i], ht_get(t, &keys[i - 1]));
+
+        ht_put(t, &keys[i], ht_get(t, &keys[i]));
+    }
+
+    for(size_t i = 0; i < KEYS; i++) {
+
+        CHECK(memcmp(ht_get(t, &keys[i]), first, sizeof(first)) == 0);
+    }
+
+    printf("%-20s ok: %zu keys\n", name, ht_occupancy(t));
+
+    ht_destroy(t);
+}
+
+/// mixed_hash(): a hash that spreads sequential keys, for large tables
+
+static size_t mixed_hash( const void *key ) {
+
+    uint64_t x = *(const uint64_t *) key;
+
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+
+    return (size_t) (x ^ (x >> 31));
+}
+
+/// fill(): put count sequential keys into a table made with options,
+/// checking the budget after each; the number stored
+
+static size_t fill( const HTOptions *options, size_t count, HTStats *stats ) {
+
+    uint64_t *many = malloc(count * sizeof(uint64_t));
+
+    CHECK(many != NULL);
+
+    HashADT t = ht_create_opts(mixed_hash, key_equals, key_print, NULL, options);
+
+    size_t added = 0;
+
+    for(size_t i = 0; i < count; i++) {
+
+        many[i] = i;
+
+        ht_put(t, &many[i], NULL);
+
+        added += ht_error(t) == HT_OK;
+
+        CHECK(ht_memory_usage(t) <= options -> memory_budget);
+    }
+
+    ht_stats(t, stats);
+
+    //with nothing prepared, slabs or pair bytes the two agree
+
+    if(options -> prefault != HT_PREFAULT_BACKGROUND) {
+
+        CHECK(stats -> bytes_used == ht_memory_usage(t));
+    }
+
+    ht_destroy(t);
+
+    free(many);
+
+    return added;
+}
+
+/// run_mapped(): a budget holds for arrays mapped whole huge pages at a
+/// time, and a prepared array does not take room from the growth
+
+static void run_mapped( const char *name ) {
+
+    current = name;
+
+    HTOptions options;
+
+    ht_options_init(&options);
+
+    options.huge_threshold = 4096;
+
+    options.memory_budget = 600000;
+
+    HTStats stats;
+
+    size_t added = fill(&options, KEYS, &stats);
+
+    printf("%-20s ok: %zu keys, capacity %llu\n", name, added, (unsigned long long) stats.capacity);
+
+    //the default threshold, with and without the next array prepared
+
+    ht_options_init(&options);
+
+    options.memory_budget = (size_t) 3 << 20;
+
+    added = fill(&options, 131072, &stats);
+
+    options.prefault = HT_PREFAULT_BACKGROUND;
+
+    HTStats prefault_stats;
+
+    size_t prefault_added = fill(&options, 131072, &prefault_stats);
+
+    CHECK(prefault_added == added && prefault_stats.capacity == stats.capacity);
+
+    printf("%-20s ok: %zu keys, capacity %llu, with prefault too\n", name, added,
+        (unsigned long long) stats.capacity);
+}
+
+/// main(): run every configuration
+
+int main( void ) {
+
+    for(size_t i = 0; i < KEYS; i++) {
+
+        keys[i] = i * 7919;
+    }
+
+    HTOptions options;
+
+    static const struct { const char *name; HTLayout layout; } layouts[] = {
+        { "flat", HT_LAYOUT_FLAT },
+        { "segmented", HT_LAYOUT_SEGMENTED },
+        { "soa", HT_LAYOUT_SOA },
+        { "compact", HT_LAYOUT_COMPACT }
+    };
+
+    char name[64];
+
+    for(size_t l = 0; l < sizeof(layouts) / sizeof(layouts[0]); l++) {
+
+        ht_options_init(&options);
+
+        options.layout = layouts[l].layout;
+
+        run(layouts[l].name, &options);
+
+        options.small_capacity = 8;
+
+        snprintf(name, sizeof(name), "%s small", layouts[l].name);
+
+        run(name, &options);
+
+        options.small_capacity = 0;
+
+        options.seed_mode = HT_SEED_FIXED;
+
+        options.seed = 42;
+
+        snprintf(name, sizeof(name), "%s seeded", layouts[l].name);
+
+        run(name, &options);
+    }
+
+    ht_options_init(&options);
+
+    options.allocator = &heap;
+
+    options.grow_in_place = true;
+
+    run("flat in place", &options);
+
+    static const struct { const char *name; HTBudgetPolicy policy; } policies[] = {
+        { "budget refuse", HT_BUDGET_REFUSE },
+        { "budget evict", HT_BUDGET_EVICT },
+        { "budget load", HT_BUDGET_LOAD }
+    };
+
+    for(size_t p = 0; p < sizeof(policies) / sizeof(policies[0]); p++) {
+
+        ht_options_init(&options);
+
+        options.memory_budget = 40000;
+
+        options.budget_policy = policies[p].policy;
+
+        run(policies[p].name, &options);
+
+        options.small_capacity = 8;
+
+        snprintf(name, sizeof(name), "%s small", policies[p].name);
+
+        run(name, &options);
+    }
+
+    run_copies("copies refuse", HT_BUDGET_REFUSE);
+
+    run_copies("copies load", HT_BUDGET_LOAD);
+
+    run_aliased("soa aliased value");
+
+    run_pair_bytes("pair bytes flat", HT_LAYOUT_FLAT, 0);
+
+    run_pair_bytes("pair bytes soa", HT_LAYOUT_SOA, 0);
+
+    run_pair_bytes("pair bytes copied", HT_LAYOUT_SOA, sizeof(uint64_t));
+
+    run_reseed("reseed budget");
+
+    run_flood("segmented equal", HT_LAYOUT_SEGMENTED, equal_hash);
+
+    run_flood("segmented few", HT_LAYOUT_SEGMENTED, few_hashes);
+
+    run_mapped("budget mapped");
+
+    return 0;
+}
@@ -0,0 +1,294 @@
+//
+// File name: test_hashanalyzer.c
+//
+// Description:
+// Test of ht_analyze_hash(): a strong hash passes every measurement, a
+// hash that returns its key unchanged spreads sequential keys perfectly
+// but fails the avalanche test, and a hash with empty low bits fails the
+// distribution tests.  Probe counts are checked exactly where linear
+// probing is easy to follow by hand: no collisions at all, or every key
+// in one bucket.  Prints one line per hash and exits nonzero on the
+// first mismatch.  Build it with the sanitizers:
+//
+//   cc -std=c99 -g -fsanitize=address,undefined -IHashADT
+//       tests/test_hashanalyzer.c HashADT/HashAnalyzer.c
+//       HashADT/HashFunctions.c -lm -o test_hashanalyzer
+//   ./test_hashanalyzer
+//
+// @author Nick Creeley - nc8004
+//
+// version control:
+// git hw6 repository
+//
+// // // // // // // // // // // // // // // // // // // // // // // // // // // // // //
+
+//include standard libraries
+
+#include <stdbool.h>
+
+#include <stddef.h>
+
+#include <stdlib.h>
+
+#include <stdint.h>
+
+#include <string.h>
+
+#include <stdio.h>
+
+#include <math.h>
+
+//include header files
+
+#include "HashADT.h"
+
+#include "HashAnalyzer.h"
+
+#include "HashFunctions.h"
+
+//sample keys
+
+#define KEYS 10000
+
+//fail the whole test, with where and why, even in NDEBUG builds
+
+#define CHECK(cond) \
+    do { \
+        if(!(cond)) { \
+            fprintf(stderr, "%s:%d: %s: check failed: %s\n", __FILE__, __LINE__, current, #cond); \
+            exit(1); \
+        } \
+    } while(0)
+
+//the hash being analyzed, for failure messages
+
+static const char *current = "";
+
+//the sample keys, 0 .. KEYS-1, and pointers to them
+
+static uint64_t keys[KEYS];
+
+static const void *key_ptrs[KEYS];
+
+/// identity_hash(): the key itself
+
+static size_t identity_hash( const void *key ) {
+
+    return (size_t) *(const uint64_t *) key;
+}
+
+/// shifted_hash(): the key with its low 12 bits left empty
+
+static size_t shifted_hash( const void *key ) {
+
+    return (size_t) (*(const uint64_t *) key << 12);
+}
+
+/// constant_hash(): every key in bucket 0
+
+static size_t constant_hash( const void *key ) {
+
+    (void) key;
+
+    return 0;
+}
+
+/// flip_u64(): HashKeyFlipper callback for uint64_t keys
+
+static const void *flip_u64( void *context, const void *key, size_t bit ) {
+
+    uint64_t *scratch = (uint64_t *) context;
+
+    *scratch = *(const uint64_t *) key ^ ((uint64_t) 1 << bit);
+
+    return scratch;
+}
+
+/// flip_none(): HashKeyFlipper callback for keys with no bits to flip
+
+static const void *flip_none( void *context, const void *key, size_t bit ) {
+
+    (void) context;
+
+    (void) key;
+
+    (void) bit;
+
+    return NULL;
+}
+
+/// analyze(): analyze hash over the sample, flipping all 64 key bits,
+/// and check what holds for every hash
+
+static void analyze( const char *name, size_t (*hash)( const void *key ), HashReport *report ) {
+
+    current = name;
+
+    uint64_t scratch;
+
+    HashKeyFlipper flipper = { flip_u64, 64, &scratch };
+
+    ht_analyze_hash(hash, key_ptrs, KEYS, &flipper, report);
+
+    CHECK(report -> key_count == KEYS);
+
+    //the capacity a table grows to for the sample
+
+    CHECK((report -> buckets & (report -> buckets - 1)) == 0);
+
+    CHECK((double) KEYS / report -> buckets < LOAD_THRESHOLD);
+
+    CHECK((double) KEYS / (report -> buckets / RESIZE_FACTOR) >= LOAD_THRESHOLD);
+
+    CHECK(report -> bucket_entropy <= report -> ideal_entropy + 1e-9);
+
+    CHECK(report -> avalanche_tested);
+
+    for(size_t i = 0; i < HT_ANALYZE_LOADS; i++) {
+
+        const HashLoadReport *load = &report -> loads[i];
+
+        CHECK((load -> capacity & (load -> capacity - 1)) == 0);
+
+        CHECK(load -> inserted <= KEYS);
+
+        CHECK(fabs(load -> load - (double) load -> inserted / load -> capacity) < 1e-9);
+
+        CHECK(load -> observed_probe <= load -> max_probe);
+    }
+}
+
+/// run_strong(): ht_hash_u64 passes every measurement
+
+static void run_strong( void ) {
+
+    HashReport report;
+
+    analyze("ht_hash_u64", ht_hash_u64, &report);
+
+    CHECK(fabs(report.chi_square_z) < 5.0);
+
+    CHECK(report.bucket_entropy > report.ideal_entropy - 1.0);
+
+    CHECK(report.low_bit_bias < 0.05);
+
+    CHECK(report.avalanche_mean_bias < 0.02);
+
+    CHECK(report.avalanche_worst_bias < 0.1);
+
+    for(size_t i = 0; i < HT_ANALYZE_LOADS; i++) {
+
+        CHECK(report.loads[i].observed_probe < 2.0 * report.loads[i].expected_probe + 0.5);
+    }
+
+    printf("%-20s ok: chi-square z %.2f, avalanche bias %.4f\n", current,
+        report.chi_square_z, report.avalanche_mean_bias);
+}
+
+/// run_identity(): sequential keys fill distinct buckets, so nothing
+/// collides, but each input bit flips only its own output bit
+
+static void run_identity( void ) {
+
+    HashReport report;
+
+    analyze("identity", identity_hash, &report);
+
+    CHECK(report.avalanche_worst_bias == 0.5);
+
+    CHECK(report.avalanche_mean_bias > 0.45);
+
+    for(size_t i = 0; i < HT_ANALYZE_LOADS; i++) {
+
+        CHECK(report.loads[i].max_probe == 0);
+
+        CHECK(report.loads[i].observed_probe == 0.0);
+    }
+
+    printf("%-20s ok: avalanche bias %.4f\n", current, report.avalanche_mean_bias);
+}
+
+/// run_shifted(): every key lands in one of few buckets, and the low
+/// bits never change
+
+static void run_shifted( void ) {
+
+    HashReport report;
+
+    analyze("shifted", shifted_hash, &report);
+
+    CHECK(report.chi_square_z > 100.0);
+
+    CHECK(report.bucket_entropy < report.ideal_entropy - 8.0);
+
+    CHECK(report.low_bit_bias == 0.5);
+
+    for(size_t i = 0; i < HT_ANALYZE_LOADS; i++) {
+
+        CHECK(report.loads[i].observed_probe > 10.0 * report.loads[i].expected_probe);
+    }
+
+    printf("%-20s ok: chi-square z %.0f, low bit bias %.2f\n", current,
+        report.chi_square_z, report.low_bit_bias);
+}
+
+/// run_constant(): with every key in one bucket the nth insert steps over
+/// the n before it, and without bits to flip no avalanche test runs
+
+static void run_constant( void ) {
+
+    current = "constant";
+
+    HashReport report;
+
+    HashKeyFlipper flipper = { flip_none, 64, NULL };
+
+    ht_analyze_hash(constant_hash, key_ptrs, KEYS, &flipper, &report);
+
+    CHECK(!report.avalanche_tested);
+
+    CHECK(report.bucket_entropy == 0.0);
+
+    for(size_t i = 0; i < HT_ANALYZE_LOADS; i++) {
+
+        size_t inserted = report.loads[i].inserted;
+
+        CHECK(inserted > 0);
+
+        CHECK(report.loads[i].max_probe == inserted - 1);
+
+        CHECK(report.loads[i].observed_probe == (double) (inserted - 1) / 2.0);
+    }
+
+    //no flipper at all
+
+    ht_analyze_hash(constant_hash, key_ptrs, KEYS, NULL, &report);
+
+    CHECK(!report.avalanche_tested);
+
+    CHECK(report.avalanche_mean_bias == 0.0 && report.avalanche_worst_bias == 0.0);
+
+    printf("%-20s ok: %zu probes at most\n", current, report.loads[HT_ANALYZE_LOADS - 1].max_probe);
+}
+
+/// main(): analyze every hash
+
+int main( void ) {
+
+    for(size_t i = 0; i < KEYS; i++) {
+
+        keys[i] = i;
+
+        key_ptrs[i] = &keys[i];
+    }
+
+    run_strong();
+
+    run_identity();
+
+    run_shifted();
+
+    run_constant();
+
+    return 0;
+}
@@ -0,0 +1,308 @@
+//
+// File name: test_hashfunctions.c
+//
+// Description:
+// Test of the bundled hash functions.  Every byte hashing variant the CPU
+// supports is selected in turn and checked against known answers, and
+// against ht_equals_bytes(): keys that are equal, wherever they sit in
+// memory and whatever bytes follow them, hash alike, and the sample keys
+// that differ (by a bit, or by length) all hash apart, so every variant
+// splits the sample exactly as ht_equals_bytes() does.  ht_siphash13() is
+// checked against the SipHash-1-3 reference vectors.  Prints one line per
+// variant and exits nonzero on the first mismatch.  Build it with the
+// sanitizers:
+//
+//   cc -std=c99 -g -fsanitize=address,undefined -IHashADT
+//       tests/test_hashfunctions.c HashADT/HashFunctions.c -o test_hashfunctions
+//   ./test_hashfunctions
+//
+// @author Nick Creeley - nc8004
+//
+// version control:
+// git hw6 repository
+//
+// // // // // // // // // // // // // // // // // // // // // // // // // // // // // //
+
+//include standard libraries
+
+#include <stdbool.h>
+
+#include <stddef.h>
+
+#include <stdlib.h>
+
+#include <stdint.h>
+
+#include <string.h>
+
+#include <stdio.h>
+
+//include header files
+
+#include "HashFunctions.h"
+
+//longest sample key, the longest one whose bits are flipped one at a
+//time, and the alignments each key is hashed at
+
+#define MAX_LENGTH 200
+
+#define FLIP_LENGTH 64
+
+#define OFFSETS 8
+
+//fail the whole test, with where and why, even in NDEBUG builds
+
+#define CHECK(cond) \
+    do { \
+        if(!(cond)) { \
+            fprintf(stderr, "%s:%d: %s: check failed: %s\n", __FILE__, __LINE__, current, #cond); \
+            exit(1); \
+        } \
+    } while(0)
+
+//the variant being run, for failure messages
+
+static const char *current = "";
+
+//the bytes every sample key is cut from: 00 01 02 ...
+
+static uint8_t message[MAX_LENGTH];
+
+//the lengths with known answers, and the answers for each variant, for
+//the key of that many message bytes
+
+static const size_t known_lengths[] = {
+    0, 1, 3, 7, 8, 15, 16, 17, 31, 32, 63, 64, 100
+};
+
+#define KNOWN (sizeof(known_lengths) / sizeof(known_lengths[0]))
+
+static const uint64_t known_portable[KNOWN] = {
+    0x146a6b2ea9984c76ULL, 0xd9aff3416fb78758ULL, 0x3cd8a7c504ea7d41ULL,
+    0x2a63bff667512954ULL, 0xff251405e9d15e03ULL, 0x56cb6df3ddf7e6b1ULL,
+    0xd8bc6f251e5496eaULL, 0x82615292aef3a349ULL, 0xefb8d83b6e40e62bULL,
+    0x855906bc67a831edULL, 0x0d7fb6276951270cULL, 0x867825c2758fa6a9ULL,
+    0xfde2c90bf5a533ddULL
+};
+
+static const uint64_t known_crc32c[KNOWN] = {
+    0x70e5e91ec8d7b13fULL, 0x9722ae65da603908ULL, 0x65c7fefab9bd0e18ULL,
+    0x70cf2eda9988402cULL, 0x8b81b22548eab840ULL, 0x8175608eae3636e1ULL,
+    0x9180cbd983556b46ULL, 0xd87e0e5ac6e2ca74ULL, 0x7e525f4793ccb18bULL,
+    0x2aaaebe8df412b06ULL, 0x211a153a5938e52aULL, 0x0e98042cacec13d8ULL,
+    0x5b8b0548122c367cULL
+};
+
+static const uint64_t known_aesni[KNOWN] = {
+    0x6029f6b9827b9df8ULL, 0x94b8ca7b16b3e6ffULL, 0x4d267760791bde38ULL,
+    0x5497c36036a81546ULL, 0xc5d916ac38f8c30aULL, 0xe59a5297cf027ca1ULL,
+    0xa32eaa1be2314ac2ULL, 0x1481d462bcc9ea04ULL, 0xa3d5996b703db1eeULL,
+    0x7bfc575fd9193bb1ULL, 0xc4dbf31edd751ffbULL, 0x3d68705fbc39889dULL,
+    0x4a940286cca12a46ULL
+};
+
+//SipHash-1-3 of the message bytes 00 .. n-1 under the key 00 .. 0f, for
+//n = 0 .. 15, from the reference implementation
+
+static const uint64_t siphash13_vectors[16] = {
+    0xabac0158050fc4dcULL, 0xc9f49bf37d57ca93ULL, 0x82cb9b024dc7d44dULL,
+    0x8bf80ab8e7ddf7fbULL, 0xcf75576088d38328ULL, 0xdef9d52f49533b67ULL,
+    0xc50d2b50c59f22a7ULL, 0xd3927d989bb11140ULL, 0x369095118d299a8eULL,
+    0x25a48eb36c063de4ULL, 0x79de85ee92ff097fULL, 0x70c118c1f94dc352ULL,
+    0x78a384b157b4d9a2ULL, 0x306f760c1229ffa7ULL, 0x605aa111c0f95d34ULL,
+    0xd320d86d2a519956ULL
+};
+
+/// hash_of(): ht_hash_bytes() of length bytes at data
+
+static size_t hash_of( const void *data, size_t length ) {
+
+    HashBytes key = { data, length };
+
+    return ht_hash_bytes(&key);
+}
+
+/// compare_hashes(): qsort callback ordering hash values
+
+static int compare_hashes( const void *a, const void *b ) {
+
+    size_t x = *(const size_t *) a;
+
+    size_t y = *(const size_t *) b;
+
+    return (x > y) - (x < y);
+}
+
+/// check_equal_keys(): every prefix of the message hashes alike at every
+/// alignment and whatever bytes follow it, as ht_equals_bytes() says
+
+static void check_equal_keys( void ) {
+
+    static uint8_t buffer[MAX_LENGTH + OFFSETS + 32];
+
+    for(size_t length = 0; length <= MAX_LENGTH; length++) {
+
+        HashBytes base = { message, length };
+
+        size_t expected = ht_hash_bytes(&base);
+
+        CHECK(ht_hash_buffer(message, length, 0) == expected);
+
+        for(size_t offset = 0; offset < OFFSETS; offset++) {
+
+            //bytes around the key differ each time, and must not matter
+
+            memset(buffer, (int) (0x5a + offset), sizeof(buffer));
+
+            memcpy(buffer + offset, message, length);
+
+            HashBytes copy = { buffer + offset, length };
+
+            CHECK(ht_equals_bytes(&base, &copy));
+
+            CHECK(ht_hash_bytes(&copy) == expected);
+        }
+    }
+
+    //an empty key may have no data at all
+
+    HashBytes empty = { NULL, 0 };
+
+    HashBytes also_empty = { message, 0 };
+
+    CHECK(ht_equals_bytes(&empty, &also_empty));
+
+    CHECK(ht_hash_bytes(&empty) == ht_hash_bytes(&also_empty));
+}
+
+/// check_distinct_keys(): the sample keys ht_equals_bytes() tells apart,
+/// every prefix of the message and every one bit change of the short
+/// ones, hash to distinct values
+
+static void check_distinct_keys( void ) {
+
+    size_t count = (MAX_LENGTH + 1) + FLIP_LENGTH * (FLIP_LENGTH + 1) / 2 * 8;
+
+    size_t *hashes = (size_t *) malloc(count * sizeof(size_t));
+
+    CHECK(hashes != NULL);
+
+    size_t n = 0;
+
+    for(size_t length = 0; length <= MAX_LENGTH; length++) {
+
+        hashes[n++] = hash_of(message, length);
+    }
+
+    uint8_t flipped[FLIP_LENGTH];
+
+    for(size_t length = 1; length <= FLIP_LENGTH; length++) {
+
+        memcpy(flipped, message, length);
+
+        for(size_t bit = 0; bit < length * 8; bit++) {
+
+            flipped[bit / 8] ^= (uint8_t) (1u << (bit % 8));
+
+            hashes[n++] = hash_of(flipped, length);
+
+            flipped[bit / 8] ^= (uint8_t) (1u << (bit % 8));
+        }
+    }
+
+    CHECK(n == count);
+
+    qsort(hashes, count, sizeof(size_t), compare_hashes);
+
+    for(size_t i = 1; i < count; i++) {
+
+        CHECK(hashes[i] != hashes[i - 1]);
+    }
+
+    free(hashes);
+}
+
+/// run(): check one variant, if the CPU supports it
+
+static void run( const char *name, HTHashImpl impl, const uint64_t *known ) {
+
+    current = name;
+
+    if(!ht_hash_select(impl)) {
+
+        printf("%-20s skipped: not supported\n", name);
+
+        return;
+    }
+
+    CHECK(ht_hash_implementation() == impl);
+
+    //the answers are for 64-bit hash values
+
+    if(sizeof(size_t) == sizeof(uint64_t)) {
+
+        for(size_t i = 0; i < KNOWN; i++) {
+
+            CHECK((uint64_t) hash_of(message, known_lengths[i]) == known[i]);
+        }
+    }
+
+    check_equal_keys();
+
+    check_distinct_keys();
+
+    //the seed changes the hash
+
+    CHECK(ht_hash_buffer(message, 16, 1) != ht_hash_buffer(message, 16, 0));
+
+    printf("%-20s ok: %zu known answers\n", name, KNOWN);
+}
+
+/// run_siphash(): ht_siphash13() gives the reference vectors
+
+static void run_siphash( void ) {
+
+    current = "siphash13";
+
+    uint64_t k0 = 0, k1 = 0;
+
+    for(int i = 0; i < 8; i++) {
+
+        k0 |= (uint64_t) i << (8 * i);
+
+        k1 |= (uint64_t) (i + 8) << (8 * i);
+    }
+
+    for(size_t length = 0; length < 16; length++) {
+
+        CHECK(ht_siphash13(message, length, k0, k1) == siphash13_vectors[length]);
+    }
+
+    printf("%-20s ok: 16 reference vectors\n", current);
+}
+
+/// main(): run every variant, then put back the one chosen at startup
+
+int main( void ) {
+
+    for(size_t i = 0; i < MAX_LENGTH; i++) {
+
+        message[i] = (uint8_t) i;
+    }
+
+    HTHashImpl startup = ht_hash_implementation();
+
+    run("portable", HT_HASH_PORTABLE, known_portable);
+
+    run("crc32c", HT_HASH_CRC32C, known_crc32c);
+
+    run("aesni", HT_HASH_AESNI, known_aesni);
+
+    current = "startup";
+
+    CHECK(ht_hash_select(startup));
+
+    run_siphash();
+
+    return 0;
+}
@@ -0,0 +1,211 @@
+//
+// File name: test_hashset.c
+//
+// Description:
+// Randomized test of HashSet: long runs of hs_insert, hs_contains and
+// hs_remove, checked against an array of which keys are in the set, on
+// default, small and seeded sets and on sets made with options they must
+// ignore.  The second half of each run draws from a few keys, so the
+// same buckets are emptied and filled again.  Prints one line per
+// configuration and exits nonzero on the first mismatch.  Build it with
+// the sanitizers:
+//
+//   cc -std=c99 -g -fsanitize=address,undefined -IHashADT tests/test_hashset.c
+//       HashADT/HashSet.c HashADT/HashADT.c HashADT/HTSegmented.c
+//       HashADT/HTSoA.c HashADT/HTCompact.c HashADT/HashFunctions.c
+//       -lm -pthread -o test_hashset
+//   ./test_hashset
+//
+// @author Nick Creeley - nc8004
+//
+// version control:
+// git hw6 repository
+//
+// // // // // // // // // // // // // // // // // // // // // // // // // // // // // //
+
+//include standard libraries
+
+#include <stdbool.h>
+
+#include <stddef.h>
+
+#include <stdlib.h>
+
+#include <stdint.h>
+
+#include <string.h>
+
+#include <stdio.h>
+
+//include header files
+
+#include "HashSet.h"
+
+#include "HashFunctions.h"
+
+//distinct keys a run draws from, the few its second half draws from, and
+//operations per run
+
+#define KEYS 20000
+
+#define FEW_KEYS 64
+
+#define OPS 400000
+
+//fail the whole test, with where and why, even in NDEBUG builds
+
+#define CHECK(cond) \
+    do { \
+        if(!(cond)) { \
+            fprintf(stderr, "%s:%d: %s: check failed: %s\n", __FILE__, __LINE__, current, #cond); \
+            exit(1); \
+        } \
+    } while(0)
+
+//the configuration being run, for failure messages
+
+static const char *current = "";
+
+//the keys, the reference, and keys the set has deleted
+
+static uint64_t keys[KEYS];
+
+static bool stored[KEYS];
+
+static size_t deleted;
+
+/// key_delete(): count the keys the set hands back
+
+static void key_delete( void *key ) {
+
+    (void) key;
+
+    deleted++;
+}
+
+/// next_random(): xorshift, so every run draws the same operations
+
+static uint64_t next_random( uint64_t *state ) {
+
+    *state ^= *state << 13;
+
+    *state ^= *state >> 7;
+
+    *state ^= *state << 17;
+
+    return *state;
+}
+
+/// run(): OPS random operations on a set made with options
+
+static void run( const char *name, const HTOptions *options ) {
+
+    current = name;
+
+    memset(stored, 0, sizeof(stored));
+
+    deleted = 0;
+
+    HashSet s = hs_create_opts(ht_hash_u64, ht_equals_u64, key_delete, options);
+
+    size_t count = 0;
+
+    uint64_t state = 12345;
+
+    for(size_t op = 0; op < OPS; op++) {
+
+        uint64_t r = next_random(&state);
+
+        size_t i = (size_t) (r % (op < OPS / 2 ? KEYS : FEW_KEYS));
+
+        int kind = (int) ((r >> 32) % 3);
+
+        if(kind == 0) {
+
+            bool added = hs_insert(s, &keys[i]);
+
+            CHECK(added == !stored[i]);
+
+            if(added) {
+
+                stored[i] = true;
+
+                count++;
+            }
+
+        } else if(kind == 1) {
+
+            CHECK(hs_contains(s, &keys[i]) == stored[i]);
+
+        } else {
+
+            bool removed = hs_remove(s, &keys[i]);
+
+            CHECK(removed == stored[i]);
+
+            if(removed) {
+
+                stored[i] = false;
+
+                count--;
+            }
+        }
+
+        CHECK(hs_size(s) == count);
+    }
+
+    for(size_t i = 0; i < KEYS; i++) {
+
+        CHECK(hs_contains(s, &keys[i]) == stored[i]);
+    }
+
+    //every key still in the set is deleted once more by hs_destroy
+
+    size_t removed = deleted;
+
+    printf("%-16s ok: %zu keys, %zu bytes\n", name, count, ht_memory_usage(hs_table(s)));
+
+    hs_destroy(s);
+
+    CHECK(deleted - removed == count);
+}
+
+/// main(): run every configuration
+
+int main( void ) {
+
+    for(size_t i = 0; i < KEYS; i++) {
+
+        keys[i] = i;
+    }
+
+    HTOptions options;
+
+    ht_options_init(&options);
+
+    run("default", &options);
+
+    options.small_capacity = 8;
+
+    run("small", &options);
+
+    ht_options_init(&options);
+
+    options.seed_mode = HT_SEED_RANDOM;
+
+    run("seeded", &options);
+
+    //options a set must ignore
+
+    ht_options_init(&options);
+
+    options.layout = HT_LAYOUT_FLAT;
+
+    options.memory_budget = 4096;
+
+    options.value_size = 16;
+
+    run("ignored options", &options);
+
+    return 0;
+}
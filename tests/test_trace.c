@@ -0,0 +1,313 @@
+//
+// File name: test_trace.c
+//
+// Description:
+// Round trip test of operation traces: random ht_put, ht_get and ht_has
+// on a table that already holds keys are traced with ht_trace_start(),
+// through a buffer small enough to be written out many times.  The file
+// is read back with ht_replay's own loader, and every record must match
+// the operation, answer and key that made it, with key bytes (one key
+// too long to keep whole) and with key hashes only.  ht_replay then
+// replays the file under every configuration and must find no answer
+// that differs.  Prints one line per trace and exits nonzero on the first
+// mismatch.  Build it with the sanitizers:
+//
+//   cc -std=c99 -g -fsanitize=address,undefined -IHashADT -Ibench
+//       tests/test_trace.c bench/bench_common.c HashADT/HashADT.c
+//       HashADT/HTSegmented.c HashADT/HTSoA.c HashADT/HTCompact.c
+//       HashADT/HashFunctions.c -lm -pthread -o test_trace
+//   ./test_trace
+//
+// @author Nick Creeley - nc8004
+//
+// version control:
+// git hw6 repository
+//
+// // // // // // // // // // // // // // // // // // // // // // // // // // // // // //
+
+//ht_replay itself, with its main renamed, for load_trace() and its runs
+
+#define main ht_replay_main
+#include "../tools/ht_replay.c"
+#undef main
+
+//distinct keys, the ones stored before tracing starts, operations traced,
+//and the trace buffer, small so it is written out many times
+
+#define KEYS 300
+
+#define PREFILL 50
+
+#define OPS 5000
+
+#define TRACE_BUFFER 1024
+
+//the files the test writes, removed when it passes
+
+#define TRACE_PATH "test_trace.bin"
+
+#define JSON_PATH "test_trace.json"
+
+//fail the whole test, with where and why, even in NDEBUG builds
+
+#define CHECK(cond) \
+    do { \
+        if(!(cond)) { \
+            fprintf(stderr, "%s:%d: %s: check failed: %s\n", __FILE__, __LINE__, current, #cond); \
+            exit(1); \
+        } \
+    } while(0)
+
+//the trace being run, for failure messages
+
+static const char *current = "";
+
+//the keys, as integers and as bytes; the last byte key is longer than a
+//trace record keeps
+
+static uint64_t int_keys[KEYS];
+
+static HashBytes byte_keys[KEYS];
+
+static char key_text[KEYS][16];
+
+static char long_key[HT_TRACE_MAX_KEY + 44];
+
+//what was traced: each operation, its key and whether it found the key
+
+static uint8_t traced_ops[OPS];
+
+static size_t traced_keys[OPS];
+
+static bool traced_found[OPS];
+
+/// serialize_bytes(): trace key_bytes callback for HashBytes keys
+
+static size_t serialize_bytes( const void *key, void *buffer, size_t room ) {
+
+    const HashBytes *bytes = (const HashBytes *) key;
+
+    memcpy(buffer, bytes -> data, bytes -> length < room ? bytes -> length : room);
+
+    return bytes -> length;
+}
+
+/// next_random(): xorshift, so every run draws the same operations
+
+static uint64_t next_random( uint64_t *state ) {
+
+    *state ^= *state << 13;
+
+    *state ^= *state >> 7;
+
+    *state ^= *state << 17;
+
+    return *state;
+}
+
+/// trace_ops(): trace OPS random operations on keys, PREFILL of them
+/// stored first, and remember each one
+
+static void trace_ops( HashADT t, const void *const *keys,
+        size_t (*key_bytes)( const void *key, void *buffer, size_t room ) ) {
+
+    bool stored[KEYS] = { false };
+
+    for(size_t i = 0; i < PREFILL; i++) {
+
+        ht_put(t, keys[i], keys[i]);
+
+        stored[i] = true;
+    }
+
+    CHECK(ht_trace_start(t, TRACE_PATH, key_bytes, TRACE_BUFFER));
+
+    uint64_t state = 777;
+
+    for(size_t op = 0; op < OPS; op++) {
+
+        uint64_t r = next_random(&state);
+
+        size_t i = (size_t) (r % KEYS);
+
+        int kind = (int) ((r >> 32) % 3);
+
+        //ht_get() only takes stored keys
+
+        if(kind == 1 && !stored[i]) {
+            kind = 2;
+        }
+
+        traced_keys[op] = i;
+
+        traced_found[op] = stored[i];
+
+        if(kind == 0) {
+
+            traced_ops[op] = HT_TRACE_PUT;
+
+            CHECK((ht_put(t, keys[i], keys[i]) != NULL) == stored[i]);
+
+            stored[i] = true;
+
+        } else if(kind == 1) {
+
+            traced_ops[op] = HT_TRACE_GET;
+
+            CHECK(ht_get(t, keys[i]) == keys[i]);
+
+        } else {
+
+            traced_ops[op] = HT_TRACE_HAS;
+
+            CHECK(ht_has(t, keys[i]) == stored[i]);
+        }
+    }
+
+    CHECK(ht_trace_stop(t));
+
+    ht_destroy(t);
+}
+
+/// check_records(): the loaded trace holds exactly the traced operations
+
+static void check_records( const Trace *trace, bool with_bytes ) {
+
+    CHECK(trace -> count == OPS);
+
+    CHECK(trace -> key_bytes == with_bytes);
+
+    for(size_t n = 0; n < OPS; n++) {
+
+        size_t i = traced_keys[n];
+
+        CHECK(trace -> ops[n] == traced_ops[n]);
+
+        CHECK(((trace -> flags[n] & HT_TRACE_FOUND) != 0) == traced_found[n]);
+
+        if(!with_bytes) {
+
+            CHECK(trace -> hash_keys[n] == (uint64_t) ht_hash_u64(&int_keys[i]));
+
+            continue;
+        }
+
+        //a key too long to keep is cut to HT_TRACE_MAX_KEY bytes
+
+        const HashBytes *key = &trace -> byte_keys[n];
+
+        bool truncated = byte_keys[i].length > HT_TRACE_MAX_KEY;
+
+        CHECK(((trace -> flags[n] & HT_TRACE_TRUNCATED) != 0) == truncated);
+
+        CHECK(key -> length == (truncated ? HT_TRACE_MAX_KEY : byte_keys[i].length));
+
+        CHECK(memcmp(key -> data, byte_keys[i].data, key -> length) == 0);
+    }
+}
+
+/// check_replay(): ht_replay runs the trace under every configuration
+/// and no answer differs from the traced one
+
+static void check_replay( void ) {
+
+    char *argv[] = {
+        (char *) "ht_replay", (char *) "--repeat", (char *) "1",
+        (char *) "--out", (char *) JSON_PATH, (char *) TRACE_PATH, NULL
+    };
+
+    CHECK(ht_replay_main(6, argv) == EXIT_SUCCESS);
+
+    FILE *in = fopen(JSON_PATH, "r");
+
+    CHECK(in != NULL);
+
+    static char json[1 << 16];
+
+    size_t length = fread(json, 1, sizeof(json) - 1, in);
+
+    fclose(in);
+
+    json[length] = '\0';
+
+    size_t configs = 0, results = 0;
+
+    for(const BenchConfig *config = bench_configs; config -> name != NULL; config++) {
+        configs++;
+    }
+
+    static const char field[] = "\"mismatches\": ";
+
+    for(const char *at = strstr(json, field); at != NULL; at = strstr(at + 1, field)) {
+
+        CHECK(strtoull(at + strlen(field), NULL, 10) == 0);
+
+        results++;
+    }
+
+    CHECK(results == configs);
+}
+
+/// run(): trace a table, load the trace back and replay it
+
+static void run( const char *name, bool with_bytes ) {
+
+    current = name;
+
+    const void *keys[KEYS];
+
+    for(size_t i = 0; i < KEYS; i++) {
+
+        keys[i] = with_bytes ? (const void *) &byte_keys[i] : (const void *) &int_keys[i];
+    }
+
+    HashADT t = with_bytes
+        ? ht_create(ht_hash_bytes, ht_equals_bytes, print_nothing, NULL)
+        : ht_create(ht_hash_u64, ht_equals_u64, print_nothing, NULL);
+
+    trace_ops(t, keys, with_bytes ? serialize_bytes : NULL);
+
+    Trace trace;
+
+    CHECK(load_trace(TRACE_PATH, &trace));
+
+    check_records(&trace, with_bytes);
+
+    printf("%-20s ok: %zu records\n", name, trace.count);
+
+    free_trace(&trace);
+
+    check_replay();
+
+    remove(TRACE_PATH);
+
+    remove(JSON_PATH);
+}
+
+/// main(): run a trace with key bytes and one with key hashes
+
+int main( void ) {
+
+    for(size_t i = 0; i < KEYS; i++) {
+
+        int_keys[i] = i * 0x9e3779b97f4a7c15ULL;
+
+        int length = sprintf(key_text[i], "key %zu", i);
+
+        byte_keys[i].data = key_text[i];
+
+        byte_keys[i].length = (size_t) length;
+    }
+
+    memset(long_key, 'x', sizeof(long_key));
+
+    byte_keys[KEYS - 1].data = long_key;
+
+    byte_keys[KEYS - 1].length = sizeof(long_key);
+
+    run("key bytes", true);
+
+    run("key hashes", false);
+
+    return 0;
+}
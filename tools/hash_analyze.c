@@ -0,0 +1,276 @@
+//
+// File name: hash_analyze.c
+//
+// Description:
+// Command line front end of the hash analyzer.  Reads one key per line and
+// reports how a string hash function would behave inside a HashADT.
+//
+//   cc -O2 -IHashADT tools/hash_analyze.c HashADT/HashAnalyzer.c
+//       HashADT/HashFunctions.c -lm -o hash_analyze
+//   ./hash_analyze [-f function] [keyfile]
+//
+// @author Nick Creeley - nc8004
+//
+// version control:
+// git hw6 repository
+//
+// // // // // // // // // // // // // // // // // // // // // // // // // // // // // //
+
+//include standard libraries
+
+#include <stdbool.h>
+
+#include <stddef.h>
+
+#include <stdlib.h>
+
+#include <stdint.h>
+
+#include <string.h>
+
+#include <stdio.h>
+
+//include header files
+
+#include "HashAnalyzer.h"
+
+#include "HashFunctions.h"
+
+//longest key line accepted
+
+#define MAX_KEY 4096
+
+/// hash_sum(): adds up the characters, the classic first attempt
+
+static size_t hash_sum( const void *key ) {
+
+    size_t hash = 0;
+
+    for(const char *c = (const char *) key; *c != '\0'; c++) {
+
+        hash += (unsigned char) *c;
+    }
+
+    return hash;
+}
+
+/// hash_djb2(): hash * 33 + c
+
+static size_t hash_djb2( const void *key ) {
+
+    size_t hash = 5381;
+
+    for(const char *c = (const char *) key; *c != '\0'; c++) {
+
+        hash = hash * 33 + (unsigned char) *c;
+    }
+
+    return hash;
+}
+
+/// hash_fnv1a(): 64-bit FNV-1a
+
+static size_t hash_fnv1a( const void *key ) {
+
+    uint64_t hash = 0xcbf29ce484222325ULL;
+
+    for(const char *c = (const char *) key; *c != '\0'; c++) {
+
+        hash ^= (unsigned char) *c;
+
+        hash *= 0x100000001b3ULL;
+    }
+
+    return (size_t) hash;
+}
+
+/// hash_siphash(): the keyed hash under a fixed seed
+
+static size_t hash_siphash( const void *key ) {
+
+    return ht_hash_cstr_keyed(key, 0x0123456789abcdefULL);
+}
+
+/// The hash functions the tool knows by name
+
+static const struct {
+    const char *name;
+    size_t (*hash)( const void *key );
+} functions[] = {
+    { "cstr", ht_hash_cstr },
+    { "siphash", hash_siphash },
+    { "fnv1a", hash_fnv1a },
+    { "djb2", hash_djb2 },
+    { "sum", hash_sum },
+};
+
+#define FUNCTION_COUNT (sizeof(functions) / sizeof(functions[0]))
+
+/// flip_cstr(): copy a string key with one bit flipped
+///
+/// only the low 7 bits of each character are flipped so the copy never
+/// gains an early NUL or leaves ASCII
+
+static const void *flip_cstr( void *context, const void *key, size_t bit ) {
+
+    char *scratch = (char *) context;
+
+    const char *str = (const char *) key;
+
+    size_t length = strlen(str);
+
+    size_t position = bit / 7;
+
+    if(position >= length) {
+        return NULL;
+    }
+
+    char flipped = (char) (str[position] ^ (1 << (bit % 7)));
+
+    if(flipped == '\0') {
+        return NULL;
+    }
+
+    memcpy(scratch, str, length + 1);
+
+    scratch[position] = flipped;
+
+    return scratch;
+}
+
+/// usage(): print the command line help
+
+static void usage( const char *program ) {
+
+    fprintf(stderr, "usage: %s [-f function] [keyfile]\n", program);
+
+    fprintf(stderr, "functions:");
+
+    for(size_t i = 0; i < FUNCTION_COUNT; i++) {
+
+        fprintf(stderr, " %s", functions[i].name);
+    }
+
+    fprintf(stderr, "\nkeys are read one per line, from stdin without keyfile\n");
+}
+
+/// main(): read keys, analyze, print the report
+
+int main( int argc, char *argv[] ) {
+
+    size_t (*hash)( const void *key ) = ht_hash_cstr;
+
+    const char *path = NULL;
+
+    for(int i = 1; i < argc; i++) {
+
+        if(strcmp(argv[i], "-f") == 0 && i + 1 < argc) {
+
+            hash = NULL;
+
+            for(size_t f = 0; f < FUNCTION_COUNT; f++) {
+
+                if(strcmp(argv[i + 1], functions[f].name) == 0) {
+
+                    hash = functions[f].hash;
+                }
+            }
+
+            if(hash == NULL) {
+
+                usage(argv[0]);
+
+                return EXIT_FAILURE;
+            }
+
+            i++;
+
+        } else if(argv[i][0] == '-') {
+
+            usage(argv[0]);
+
+            return EXIT_FAILURE;
+
+        } else {
+
+            path = argv[i];
+        }
+    }
+
+    FILE *in = path != NULL ? fopen(path, "r") : stdin;
+
+    if(in == NULL) {
+
+        perror(path);
+
+        return EXIT_FAILURE;
+    }
+
+    //read the keys, one per line
+
+    size_t count = 0, room = 1024;
+
+    char **keys = (char**)malloc(room * sizeof(char*));
+
+    char line[MAX_KEY];
+
+    while(keys != NULL && fgets(line, sizeof(line), in) != NULL) {
+
+        line[strcspn(line, "\r\n")] = '\0';
+
+        if(count == room) {
+
+            room *= 2;
+
+            keys = (char**)realloc(keys, room * sizeof(char*));
+
+            if(keys == NULL) {
+                break;
+            }
+        }
+
+        size_t length = strlen(line) + 1;
+
+        keys[count] = (char*)malloc(length);
+
+        if(keys[count] == NULL) {
+            break;
+        }
+
+        memcpy(keys[count], line, length);
+
+        count++;
+    }
+
+    if(in != stdin) {
+        fclose(in);
+    }
+
+    if(keys == NULL || count == 0) {
+
+        fprintf(stderr, "no keys read\n");
+
+        return EXIT_FAILURE;
+    }
+
+    //flip up to the first 8 characters of each key
+
+    char scratch[MAX_KEY];
+
+    HashKeyFlipper flipper = { flip_cstr, 8 * 7, scratch };
+
+    HashReport report;
+
+    ht_analyze_hash(hash, (const void *const *) keys, count, &flipper, &report);
+
+    ht_print_hash_report(&report, stdout);
+
+    for(size_t i = 0; i < count; i++) {
+
+        free(keys[i]);
+    }
+
+    free(keys);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,470 @@
+//
+// File name: ht_replay.c
+//
+// Description:
+// Replays an operation trace written by ht_trace_start() against this
+// build of HashADT, once per table configuration, as fast as it can.
+// Keys come from the traced key bytes when the trace has them, otherwise
+// from the traced key hashes.  Keys that the trace reads before it ever
+// puts them were in the table before tracing began, so they are inserted
+// first, untimed.  Results are JSON.
+//
+//   cc -O2 -DNDEBUG -IHashADT -Ibench tools/ht_replay.c bench/bench_common.c
+//       HashADT/HashADT.c HashADT/HTSegmented.c HashADT/HTSoA.c
+//       HashADT/HTCompact.c HashADT/HashFunctions.c -lm -pthread -o ht_replay
+//   ./ht_replay [--config NAME|all] [--repeat N] [--latency] [--out FILE] tracefile
+//
+// @author Nick Creeley - nc8004
+//
+// version control:
+// git hw6 repository
+//
+// // // // // // // // // // // // // // // // // // // // // // // // // // // // // //
+
+//include standard libraries
+
+#include <stdbool.h>
+
+#include <stddef.h>
+
+#include <stdlib.h>
+
+#include <stdint.h>
+
+#include <inttypes.h>
+
+#include <string.h>
+
+#include <assert.h>
+
+#include <stdio.h>
+
+//include header files
+
+#include "HashADT.h"
+
+#include "HashFunctions.h"
+
+#include "bench_common.h"
+
+/// A trace loaded into memory, ready to replay
+
+typedef struct Trace {
+
+    size_t count;
+
+    uint8_t *ops;
+
+    uint8_t *flags;
+
+    const void **keys;      //HashBytes or uint64_t, per record
+
+    HashBytes *byte_keys;   //backing for keys when the trace has key bytes
+
+    uint64_t *hash_keys;    //backing for keys otherwise
+
+    unsigned char *bytes;   //every key's bytes, back to back
+
+    bool key_bytes;
+
+    uint64_t span_ns;       //time the traced operations took originally
+
+} Trace;
+
+/// print_nothing(): print callback required by ht_create
+
+static void print_nothing( const void *key, const void *value ) {
+
+    (void) key;
+
+    (void) value;
+}
+
+/// load_trace(): read a whole trace file, false with a message if invalid
+
+static bool load_trace( const char *path, Trace *trace ) {
+
+    FILE *in = fopen(path, "rb");
+
+    if(in == NULL) {
+
+        perror(path);
+
+        return false;
+    }
+
+    char magic[8];
+
+    HTTraceHeader header;
+
+    if(fread(magic, 1, 8, in) != 8 || memcmp(magic, HT_TRACE_MAGIC, 8) != 0
+            || fread(&header, sizeof(header), 1, in) != 1) {
+
+        fprintf(stderr, "%s: not a HashADT trace\n", path);
+
+        fclose(in);
+
+        return false;
+    }
+
+    if(header.byte_order != 0x01020304 || header.record_size != sizeof(HTTraceRecord)) {
+
+        fprintf(stderr, "%s: written by a machine with another byte order or record layout\n", path);
+
+        fclose(in);
+
+        return false;
+    }
+
+    //the rest of the file in one piece, then split into records
+
+    long begin = ftell(in);
+
+    fseek(in, 0, SEEK_END);
+
+    size_t length = (size_t) (ftell(in) - begin);
+
+    fseek(in, begin, SEEK_SET);
+
+    unsigned char *data = (unsigned char*)malloc(length > 0 ? length : 1);
+
+    assert(data != NULL);
+
+    bool read_all = fread(data, 1, length, in) == length;
+
+    fclose(in);
+
+    if(!read_all) {
+
+        fprintf(stderr, "%s: read failed\n", path);
+
+        free(data);
+
+        return false;
+    }
+
+    size_t room = length / sizeof(HTTraceRecord);
+
+    trace -> key_bytes = (header.flags & HT_TRACE_KEY_BYTES) != 0;
+
+    trace -> ops = (uint8_t*)malloc(room + 1);
+
+    trace -> flags = (uint8_t*)malloc(room + 1);
+
+    trace -> keys = (const void**)malloc((room + 1) * sizeof(void*));
+
+    trace -> byte_keys = (HashBytes*)malloc((room + 1) * sizeof(HashBytes));
+
+    trace -> hash_keys = (uint64_t*)malloc((room + 1) * sizeof(uint64_t));
+
+    assert(trace -> ops != NULL && trace -> flags != NULL && trace -> keys != NULL
+        && trace -> byte_keys != NULL && trace -> hash_keys != NULL);
+
+    trace -> bytes = data;
+
+    trace -> count = 0;
+
+    trace -> span_ns = 0;
+
+    size_t at = 0;
+
+    while(at + sizeof(HTTraceRecord) <= length) {
+
+        HTTraceRecord record;
+
+        memcpy(&record, data + at, sizeof(record));
+
+        at += sizeof(record);
+
+        if(at + record.key_length > length || record.op > HT_TRACE_HAS) {
+
+            fprintf(stderr, "%s: truncated or corrupt after %zu records\n", path, trace -> count);
+
+            break;
+        }
+
+        size_t n = trace -> count++;
+
+        trace -> ops[n] = record.op;
+
+        trace -> flags[n] = record.flags;
+
+        trace -> span_ns = record.ns;
+
+        if(trace -> key_bytes) {
+
+            trace -> byte_keys[n].data = data + at;
+
+            trace -> byte_keys[n].length = record.key_length;
+
+            trace -> keys[n] = &trace -> byte_keys[n];
+
+        } else {
+
+            trace -> hash_keys[n] = record.hash;
+
+            trace -> keys[n] = &trace -> hash_keys[n];
+        }
+
+        at += record.key_length;
+    }
+
+    return true;
+}
+
+/// free_trace(): release a loaded trace
+
+static void free_trace( Trace *trace ) {
+
+    free(trace -> ops);
+
+    free(trace -> flags);
+
+    free(trace -> keys);
+
+    free(trace -> byte_keys);
+
+    free(trace -> hash_keys);
+
+    free(trace -> bytes);
+}
+
+/// replay(): run the trace once against a table, counting differences
+/// from what the traced table answered
+
+static uint64_t replay( HashADT t, const Trace *trace, BenchHistogram *latency,
+        uint64_t *mismatches ) {
+
+    uint64_t start = bench_now_ns();
+
+    for(size_t i = 0; i < trace -> count; i++) {
+
+        uint64_t op_start = latency != NULL ? bench_now_ns() : 0;
+
+        const void *key = trace -> keys[i];
+
+        bool found = (trace -> flags[i] & HT_TRACE_FOUND) != 0;
+
+        if(trace -> ops[i] == HT_TRACE_PUT) {
+
+            if((ht_put(t, key, key) != NULL) != found) {
+                (*mismatches)++;
+            }
+
+        } else if(trace -> ops[i] == HT_TRACE_GET) {
+
+            ht_get(t, key);
+
+        } else if(ht_has(t, key) != found) {
+
+            (*mismatches)++;
+        }
+
+        if(latency != NULL) {
+
+            bench_hist_record(latency, bench_now_ns() - op_start);
+        }
+    }
+
+    return bench_now_ns() - start;
+}
+
+/// run_config(): replay the trace repeat times on fresh tables
+
+static void run_config( const BenchConfig *config, const Trace *trace, const void **prefill,
+        size_t prefill_count, size_t repeat, bool timed_ops, FILE *out, bool first ) {
+
+    HTOptions options;
+
+    config -> options(&options);
+
+    static BenchHistogram latency;
+
+    bench_hist_reset(&latency);
+
+    uint64_t best = UINT64_MAX, total = 0, mismatches = 0;
+
+    for(size_t r = 0; r < repeat; r++) {
+
+        HashADT t = trace -> key_bytes
+            ? ht_create_opts(ht_hash_bytes, ht_equals_bytes, print_nothing, NULL, &options)
+            : ht_create_opts(ht_hash_u64, ht_equals_u64, print_nothing, NULL, &options);
+
+        for(size_t i = 0; i < prefill_count; i++) {
+
+            ht_put(t, prefill[i], prefill[i]);
+        }
+
+        uint64_t ns = replay(t, trace, timed_ops ? &latency : NULL, &mismatches);
+
+        total += ns;
+
+        if(ns < best) {
+            best = ns;
+        }
+
+        ht_destroy(t);
+    }
+
+    fprintf(out, "%s\n    {\"config\": ", first ? "" : ",");
+
+    bench_json_string(out, config -> name);
+
+    fprintf(out, ", \"repeat\": %zu, \"best_ns\": %" PRIu64 ", \"mean_ns\": %" PRIu64
+        ", \"ops_per_s\": %.0f, \"mismatches\": %" PRIu64,
+        repeat, best, total / repeat, best > 0 ? trace -> count * 1e9 / best : 0.0, mismatches);
+
+    if(timed_ops) {
+
+        fprintf(out, ",\n     \"latency\": {");
+
+        bench_hist_json(&latency, out);
+
+        fprintf(out, "}");
+    }
+
+    fprintf(out, "}");
+
+    fflush(out);
+}
+
+/// usage(): print the command line help
+
+static void usage( const char *program ) {
+
+    fprintf(stderr, "usage: %s [--config NAME|all] [--repeat N] [--latency] "
+        "[--out FILE] tracefile\nconfigurations:", program);
+
+    for(const BenchConfig *config = bench_configs; config -> name != NULL; config++) {
+
+        fprintf(stderr, " %s", config -> name);
+    }
+
+    fprintf(stderr, "\n");
+}
+
+/// main(): load the trace and replay it under every selected configuration
+
+int main( int argc, char *argv[] ) {
+
+    const char *only = "all";
+
+    const char *path = NULL;
+
+    size_t repeat = 5;
+
+    bool timed_ops = false;
+
+    FILE *out = stdout;
+
+    for(int i = 1; i < argc; i++) {
+
+        if(strcmp(argv[i], "--latency") == 0) {
+
+            timed_ops = true;
+
+        } else if(strcmp(argv[i], "--config") == 0 && i + 1 < argc) {
+
+            only = argv[++i];
+
+        } else if(strcmp(argv[i], "--repeat") == 0 && i + 1 < argc) {
+
+            repeat = strtoull(argv[++i], NULL, 10);
+
+        } else if(strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+
+            out = fopen(argv[++i], "w");
+
+            if(out == NULL) {
+
+                perror(argv[i]);
+
+                return EXIT_FAILURE;
+            }
+
+        } else if(argv[i][0] != '-' && path == NULL) {
+
+            path = argv[i];
+
+        } else {
+
+            usage(argv[0]);
+
+            return EXIT_FAILURE;
+        }
+    }
+
+    if(path == NULL || repeat == 0 || (strcmp(only, "all") != 0 && bench_config_find(only) == NULL)) {
+
+        usage(argv[0]);
+
+        return EXIT_FAILURE;
+    }
+
+    Trace trace;
+
+    if(!load_trace(path, &trace)) {
+        return EXIT_FAILURE;
+    }
+
+    //keys whose first appearance finds them were there before the trace
+
+    const void **prefill = (const void**)malloc((trace.count + 1) * sizeof(void*));
+
+    assert(prefill != NULL);
+
+    size_t prefill_count = 0;
+
+    HashADT seen = trace.key_bytes
+        ? ht_create(ht_hash_bytes, ht_equals_bytes, print_nothing, NULL)
+        : ht_create(ht_hash_u64, ht_equals_u64, print_nothing, NULL);
+
+    for(size_t i = 0; i < trace.count; i++) {
+
+        const void *key = trace.keys[i];
+
+        if(ht_has(seen, key)) {
+            continue;
+        }
+
+        ht_put(seen, key, key);
+
+        if(trace.ops[i] == HT_TRACE_GET || (trace.flags[i] & HT_TRACE_FOUND) != 0) {
+
+            prefill[prefill_count++] = key;
+        }
+    }
+
+    ht_destroy(seen);
+
+    fprintf(out, "{\n  \"benchmark\": \"hashadt_replay\",\n  \"trace\": ");
+
+    bench_json_string(out, path);
+
+    fprintf(out, ",\n  \"records\": %zu, \"key_bytes\": %s, \"prefill\": %zu, \"traced_ns\": %" PRIu64
+        ",\n  \"results\": [", trace.count, trace.key_bytes ? "true" : "false", prefill_count, trace.span_ns);
+
+    bool first = true;
+
+    for(const BenchConfig *config = bench_configs; config -> name != NULL; config++) {
+
+        if(strcmp(only, "all") == 0 || strcmp(only, config -> name) == 0) {
+
+            run_config(config, &trace, prefill, prefill_count, repeat, timed_ops, out, first);
+
+            first = false;
+        }
+    }
+
+    fprintf(out, "\n  ]\n}\n");
+
+    if(out != stdout) {
+        fclose(out);
+    }
+
+    free(prefill);
+
+    free_trace(&trace);
+
+    return EXIT_SUCCESS;
+}